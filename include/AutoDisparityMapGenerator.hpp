@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+
+#include "AutoTuneConfigurations.hpp"
+#include "DisparityMapAlgorithmParameters.hpp"
+#include "DisparityMapGenerator.hpp"
+
+// Runs the configuration AutoTune measured fastest on this host (see AutoTuneConfigurations::select()).
+// The frame size is only known once the first frame arrives, so the generator is created then,
+//   and again whenever the size, channel count or parameters change.
+// Parameters the tuned backend does not support (see DisparityMapBackendRegistry::checkSupport()) select
+//   the fastest estimate that supports them instead, keeping the tuned thread count and strip height.
+// The caller's strip height is kept unless the configuration tuned one.
+class AutoDisparityMapGenerator : public DisparityMapGenerator {
+    public:
+        AutoDisparityMapGenerator(
+            const DisparityMapAlgorithmParameters_t& parameters);
+
+        // Always runs configuration, whatever was tuned, and throws rather than select another backend
+        //   if its backend cannot run. AutoTune measures its candidates with this.
+        AutoDisparityMapGenerator(
+            const DisparityMapAlgorithmParameters_t& parameters,
+            const AutoTuneConfiguration_t& configuration);
+
+        virtual void setParameters(
+            const DisparityMapAlgorithmParameters_t& parameters) override;
+
+        virtual const DisparityMapAlgorithmParameters_t& getParameters() const override;
+
+        virtual void computeDisparity(
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage,
+            cv::Mat& disparity) override;
+
+        virtual void computeDisparityAt(
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage,
+            const std::vector<cv::Point>& points,
+            std::vector<float>& disparities,
+            std::vector<int>* costs = nullptr) override;
+
+        virtual void computeDisparityAt(
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage,
+            const std::vector<cv::Rect>& regions,
+            cv::Mat& disparity,
+            cv::Mat* costs = nullptr) override;
+
+        // The configuration of the last frame.
+        const AutoTuneConfiguration_t& getConfiguration() const;
+
+    private:
+        DisparityMapAlgorithmParameters_t parameters_;
+        AutoTuneConfigurations configurations_;
+        AutoTuneConfiguration_t configuration_;
+        bool hasFixedConfiguration_ = false;
+        AutoTuneConfiguration_t fixedConfiguration_;
+        std::unique_ptr<DisparityMapGenerator> generator_;
+
+        void loadConfigurations();
+        void ensureGenerator(const cv::Mat& leftImage);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DisparityMapAlgorithmParameters.hpp"
+
+// The fastest configuration AutoTune measured for one frame size and set of matching parameters.
+typedef struct AutoTuneConfiguration {
+    // What the configuration was tuned for.
+    int rows = 0;
+    int cols = 0;
+    int channels = 1;
+    int blockSize = 0;
+    int leftScanSteps = 0;
+    int rightScanSteps = 0;
+
+    // What to run. 0 threads keeps the OpenMP default, and a strip height of 0 (not tuned) the caller's.
+    std::string algorithmName = "OpenMPSimd";
+    int numThreads = 0;
+    int openMpStripHeight = 0;
+
+    // The measured mean frame time, for reference.
+    double frameTimeMs = 0;
+} AutoTuneConfiguration_t;
+
+// The tuned configurations of one host, stored as an OpenCV FileStorage (YAML) file.
+class AutoTuneConfigurations {
+    public:
+        // A missing file loads as empty.
+        static AutoTuneConfigurations load(const std::string& path);
+
+        void save(const std::string& path) const;
+
+        // Replaces any configuration tuned for the same frame size and parameters.
+        void set(const AutoTuneConfiguration_t& configuration);
+
+        // The configuration tuned for this frame size and parameters. Without one, the configuration
+        //   tuned for the same parameters at the closest frame size, then the default (OpenMPSimd).
+        AutoTuneConfiguration_t select(
+            int rows,
+            int cols,
+            int channels,
+            const DisparityMapAlgorithmParameters_t& parameters) const;
+
+        const std::vector<AutoTuneConfiguration_t>& getConfigurations() const;
+
+        // autotune.yml under CacheDirectory::getDefault().
+        static std::string getDefaultPath();
+
+    private:
+        std::vector<AutoTuneConfiguration_t> configurations_;
+
+        static bool hasSameParameters(
+            const AutoTuneConfiguration_t& configuration,
+            int channels,
+            const DisparityMapAlgorithmParameters_t& parameters);
+};
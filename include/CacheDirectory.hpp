@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+// The per-user directory for files worth keeping between runs, such as compiled OpenCL programs and AutoTune results.
+class CacheDirectory {
+    public:
+        // $XDG_CACHE_HOME/StereoVisionMultiWay, falling back to $HOME/.cache/StereoVisionMultiWay.
+        // Empty when neither is set.
+        static std::string getDefault();
+};
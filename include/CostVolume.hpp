@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "AlignmentAllocator.hpp"
+
+// The matching cost of every pixel at every candidate disparity, kept for consumers that need
+//   the whole cost curve (confidence, refinement, aggregation, left-right checks).
+//
+// Layout: rows of cols pixels of numDisparities uint16 costs, disparity innermost.
+//   Slot k of pixel (y, x) holds the SAD of the left block at x against the right block at
+//   x - leftScanSteps + k, which is the disparity |k - leftScanSteps|. Candidates outside the
+//   image hold INVALID_COST, and costs above MAX_COST saturate to it.
+//   Pixels are packed, and each row starts on a 64-byte boundary (see getRowStride()).
+//
+// With a window, only the latest windowRows rows are kept, row y in slot y % windowRows.
+class CostVolume {
+    public:
+        static constexpr uint16_t INVALID_COST = 0xFFFF;
+        static constexpr uint16_t MAX_COST = 0xFFFE;
+        static constexpr size_t ALIGNMENT = 64;
+
+        // Sizes the volume for a frame. The buffer is only reallocated when it grows.
+        // windowRows 0 keeps every row.
+        void configure(
+            int rows,
+            int cols,
+            int leftScanSteps,
+            int rightScanSteps,
+            int windowRows);
+
+        int getRows() const;
+        int getCols() const;
+        int getNumDisparities() const;
+        int getLeftScanSteps() const;
+        int getWindowRows() const;
+
+        // Elements from one row to the next.
+        size_t getRowStride() const;
+
+        // Rows [getMinAvailableRow(), getMaxAvailableRow()) are complete and still held.
+        int getMinAvailableRow() const;
+        int getMaxAvailableRow() const;
+        bool hasRow(int y) const;
+
+        // Throws if the row is not available.
+        const uint16_t* getRow(int y) const;
+
+        // The numDisparities costs of pixel (y, x), unchecked.
+        inline const uint16_t* getCosts(int y, int x) const {
+            return this->data_.data() + (this->getSlot(y) * this->rowStride_) + (static_cast<size_t>(x) * this->numDisparities_);
+        }
+
+        // For the generator that fills the volume.
+        inline uint16_t* getMutableRow(int y) {
+            return this->data_.data() + (this->getSlot(y) * this->rowStride_);
+        }
+
+        void beginFrame();
+        void setRowsComplete(int maxY);
+
+    private:
+        int rows_ = 0;
+        int cols_ = 0;
+        int numDisparities_ = 0;
+        int leftScanSteps_ = 0;
+        int windowRows_ = 0;
+        int numSlots_ = 0;
+        size_t rowStride_ = 0;
+        int maxAvailableRow_ = 0;
+
+        std::vector<uint16_t, AlignmentAllocator<uint16_t, ALIGNMENT>> data_;
+
+        inline size_t getSlot(int y) const {
+            return static_cast<size_t>(y % this->numSlots_);
+        }
+};
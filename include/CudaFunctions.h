@@ -5,6 +5,9 @@
 #include <stdio.h>
 
 extern "C" {
+    // 0 when there is no CUDA device or driver.
+    int getCudaDeviceCount();
+
     void destroyCudaMemoryBuffers();
 
     void computeDisparityCuda(
@@ -6,9 +6,13 @@
 
 #include "DisparityMapAlgorithmParameters.hpp"
 #include "DisparityMapGenerator.hpp"
+#include "GrayscaleConverter.hpp"
 
 class CudaSimdDisparityMapGenerator : public DisparityMapGenerator {
     public:
+        // The kernel keeps the costs of a pixel in a fixed array.
+        static constexpr int MAX_DISPARITY_RANGE = 512;
+
         CudaSimdDisparityMapGenerator(
             const DisparityMapAlgorithmParameters_t& parameters);
 
@@ -26,6 +30,8 @@ class CudaSimdDisparityMapGenerator : public DisparityMapGenerator {
 
     private:
         DisparityMapAlgorithmParameters_t parameters_;
+        cv::Mat leftGrayImage_;
+        cv::Mat rightGrayImage_;
         std::vector<int> disparityBuf_;
 
         uint8_t* leftCudaData = nullptr;
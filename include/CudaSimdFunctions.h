@@ -1,5 +1,5 @@
-#ifndef CUDA_FUNCTIONS_H
-#define CUDA_FUNCTIONS_H
+#ifndef CUDA_SIMD_FUNCTIONS_H
+#define CUDA_SIMD_FUNCTIONS_H
 
 #include <stdint.h>
 #include <stdio.h>
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Error statistics over one set of ground truth pixels.
+typedef struct DisparityRegionAccuracy {
+    int numPixels = 0;
+
+    // One entry per threshold: the percentage of pixels whose error is above it.
+    std::vector<double> badPixelPercentages;
+
+    double meanAbsoluteError = 0;
+    double rootMeanSquaredError = 0;
+} DisparityRegionAccuracy_t;
+
+typedef struct DisparityAccuracy {
+    DisparityRegionAccuracy_t nonOccluded;
+    DisparityRegionAccuracy_t all;
+} DisparityAccuracy_t;
+
+// Scores disparity maps against Middlebury-style ground truth, in which 0 marks an unknown disparity.
+// "all" covers every pixel with a known disparity. "nonOccluded" also requires the pixel to be
+//   visible in the right image, which is found by checking the left ground truth against the right.
+// Without right ground truth, both regions are the same.
+class DisparityAccuracyEvaluator {
+    public:
+        // The ground truth images are CV_8UC1 or CV_16UC1, holding the disparity times scale.
+        DisparityAccuracyEvaluator(
+            const cv::Mat& leftGroundTruth,
+            const cv::Mat& rightGroundTruth,
+            float scale,
+            const std::vector<float>& thresholds);
+
+        // Parses a comma-separated list of positive thresholds, such as "0.5,1,2,4".
+        static std::vector<float> parseThresholds(const std::string& thresholds);
+
+        const std::vector<float>& getThresholds() const;
+
+        DisparityAccuracy_t evaluate(const cv::Mat& disparity) const;
+
+    private:
+        // The largest difference between the left and right ground truth of a visible pixel.
+        static constexpr float OCCLUSION_TOLERANCE = 1.0f;
+
+        static constexpr uint8_t UNKNOWN = 0;
+        static constexpr uint8_t OCCLUDED = 1;
+        static constexpr uint8_t NON_OCCLUDED = 2;
+
+        std::vector<float> thresholds_;
+        cv::Mat groundTruth_;
+        cv::Mat regions_;
+
+        static cv::Mat toDisparity(const cv::Mat& groundTruth, float scale);
+
+        void finishRegion(
+            DisparityRegionAccuracy_t& region,
+            const std::vector<int>& numBadPixels,
+            double sumAbsoluteError,
+            double sumSquaredError) const;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "DisparityMapAlgorithmParameters.hpp"
+#include "DisparityServiceProtocol.hpp"
+
+// Client library for DisparityServer.
+// Frames are written directly into a shared-memory ring of slots, and the disparity
+//   is read back from the same slot, so no image data is copied over the socket.
+//
+// Usage:
+//   client.open(parameters, width, height, numSlots);
+//   int slot = client.acquireSlot(left, right);   // left and right view shared memory
+//   ... fill left and right ...
+//   client.submit(slot);
+//   client.waitForDisparity(disparity);           // disparity views shared memory
+//
+// Up to numSlots frames may be acquired or in flight at once. Slots are completed in order.
+class DisparityClient {
+    public:
+        DisparityClient(const std::string& socketPath = DisparityServiceProtocol::getDefaultSocketPath());
+
+        ~DisparityClient();
+
+        // Only the algorithm name, block size and scan steps are sent to the server.
+        void open(
+            const DisparityMapAlgorithmParameters_t& parameters,
+            int width,
+            int height,
+            int numSlots);
+
+        void close();
+
+        // Returns the next free slot, with leftImage and rightImage viewing its shared memory.
+        int acquireSlot(cv::Mat& leftImage, cv::Mat& rightImage);
+
+        void submit(int slot);
+
+        // Waits for the oldest submitted slot and returns its index.
+        // The disparity views shared memory and stays valid until the slot is acquired again.
+        int waitForDisparity(cv::Mat& disparity, double* computeTimeMs = nullptr);
+
+        int getNumSlotsInFlight() const;
+
+    private:
+        int socketFd_ = -1;
+        uint8_t* sharedMemory_ = nullptr;
+        size_t sharedMemorySize_ = 0;
+        DisparityServiceSlotLayout_t layout_;
+
+        int width_ = 0;
+        int height_ = 0;
+        int numSlots_ = 0;
+        int oldestSlot_ = 0;
+        int numSlotsAcquired_ = 0;
+        int numSlotsSubmitted_ = 0;
+
+        void receiveReply(DisparityServiceMessage_t& reply, int* fileDescriptor = nullptr);
+};
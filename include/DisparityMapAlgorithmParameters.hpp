@@ -6,6 +6,99 @@ typedef struct DisparityMapAlgorithmParameters {
     int blockSize = 7;
     int leftScanSteps = 50;
     int rightScanSteps = 50;
+
+    // Subpixel fit around each cost minimum: "parabolic", "equiangular" or "none".
+    // Only OpenMPSimd offers anything other than parabolic.
+    std::string subpixelInterpolation = "parabolic";
+
+    // Optional post-processing, which OpenMPSimd runs on each strip of the disparity as it is finished.
+    // The median filter size is 0 (off), 3 or 5. Speckle filtering replaces 4-connected regions of at most
+    //   speckleMaxSize pixels (0 disables it), whose neighbours differ by at most speckleMaxDifference.
+    int medianFilterSize = 0;
+    int speckleMaxSize = 0;
+    float speckleMaxDifference = 1.0f;
+    float speckleNewValue = 0.0f;
+
+    // Pinhole camera of the rectified pair, for depth and point cloud output.
+    // Depth is in the units of the baseline. A negative principal point selects the image centre.
+    //   Pixels with a disparity at or below minProjectedDisparity are not projected.
+    double focalLength = 0;
+    double baseline = 0;
+    double principalPointX = -1;
+    double principalPointY = -1;
+    float minProjectedDisparity = 0.0f;
+
+    // Rows per strip when OpenMPSimd rectifies, converts to gray or post-processes in strips.
+    // Each strip also prepares blockSize - 1 halo rows, so taller strips repeat less work but balance worse.
+    int openMpStripHeight = 32;
+
+    // OpenMPSimd can keep the cost of every candidate disparity of every pixel in a CostVolume.
+    // A window of costVolumeWindowRows (at least openMpStripHeight, 0 keeps the whole frame) bounds its memory.
+    //   The frame is then matched in batches of whole strips that fit in the window.
+    bool costVolumeEnabled = false;
+    int costVolumeWindowRows = 0;
+
+    // OpenMPSimd can rate each match while it searches, with a MatchConfidence measure:
+    //   "none", "peakRatio" or "curvature". Pixels below minConfidence are left unrefined,
+    //   and are not projected into point clouds.
+    std::string confidenceMeasure = "none";
+    float minConfidence = 0.0f;
+
+    // OpenMPSimd can stop summing a candidate's block once its partial SAD exceeds the best so far,
+    //   or the fourth lowest so far with the peak ratio, which needs the lowest costs away from the best.
+    //   Candidates are searched from the left neighbour's disparity, which usually makes the bound tight early.
+    // The disparities and confidences do not change. The cost volume needs every cost, and disables it.
+    bool earlyTerminationEnabled = false;
+
+    // The "Auto" algorithm runs the configuration AutoTune saved to this file for the frame size and parameters.
+    // An empty path selects AutoTuneConfigurations::getDefaultPath().
+    std::string autoTuneConfigurationPath;
+
+    // Incremental recomputation for mostly static scenes.
+    // A tile size of 0 disables it. Tiles whose SAD against the previous
+    //   frame exceeds the threshold are considered changed.
+    int incrementalTileSize = 0;
+    int incrementalChangeThreshold = 0;
+
+    // Optional OpenCV FileStorage file holding fixed-point remap tables (see StereoRectifier).
+    // When set, OpenMPSimd takes raw images and rectifies them on the fly as it matches.
+    std::string rectificationMapsPath;
+
+    // Number of buffer sets the OpenCL generator rotates through.
+    // More than one allows frames to be pipelined with enqueueDisparity().
+    int openClNumBufferSets = 2;
+
+    // Compiled OpenCL programs are cached in this directory.
+    // An empty directory selects OpenClProgramCache::getDefaultCacheDirectory().
+    bool openClBinaryCacheEnabled = true;
+    std::string openClBinaryCacheDirectory;
+
+    // OpenCL device selection. Names are matched as substrings, empty matches anything.
+    // The device type is one of "default", "cpu", "gpu", "accelerator" or "all".
+    std::string openClPlatformName;
+    std::string openClDeviceName;
+    std::string openClDeviceType = "default";
+
+    // Each frame is split into row bands across up to this many devices. 0 uses every match.
+    int openClMaxDevices = 1;
+
+    // Optionally partitions each device with clCreateSubDevices.
+    // One of "" (no partitioning), "numa", or "equally:<computeUnitsPerSubDevice>".
+    std::string openClDeviceFission;
+
+    // Initial fraction of rows the Hybrid generator sends to OpenCL, before any measurements.
+    // 0 and 1 run only OpenMPSimd or only OpenCL, and are kept as they are.
+    double hybridOpenClRowFraction = 0.5;
+
+    // Sharded execution across DisparityShardWorker processes.
+    // The workers run shardWorkerAlgorithm, and exchange bands over "sharedMemory" or "socket" (TCP loopback).
+    // 0 worker threads keeps the OpenMP default. An empty executable path looks next to the running program.
+    std::string shardWorkerAlgorithm = "OpenMPSimd";
+    int shardNumWorkers = 2;
+    std::string shardTransport = "sharedMemory";
+    int shardWorkerNumThreads = 0;
+    std::string shardWorkerExecutable;
+
     std::string leftImageFilePath;
     std::string rightImageFilePath;
     std::string outputPath;
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DisparityMapAlgorithmParameters.hpp"
+#include "DisparityMapGenerator.hpp"
+
+// What a backend needs and supports, and roughly how fast it is.
+typedef struct DisparityMapBackendInfo {
+    std::string name;
+    std::string description;
+
+    // Host instruction sets ("avx2", "fma", ...) and devices ("cuda", "opencl") the backend needs.
+    // isDeviceAvailable checks the devices, and is empty for backends without any.
+    std::vector<std::string> requiredInstructionSets;
+    std::vector<std::string> requiredDevices;
+    std::function<bool()> isDeviceAvailable;
+
+    // Limits of the matcher. 0 is unlimited.
+    // The disparity range is leftScanSteps + rightScanSteps + 1.
+    int maxDisparityRange = 0;
+    int maxBlockSize = 0;
+
+    // OpenCV types of the input images and of the disparity.
+    std::vector<int> inputTypes;
+    std::vector<int> outputTypes;
+
+    // Options beyond plain matching.
+    // Sparse queries are DisparityMapGenerator::computeDisparityAt(). Subpixel interpolation is anything but parabolic.
+    // The cost volume is costVolumeEnabled (see CostVolume), and confidence is any confidenceMeasure but "none".
+    bool supportsRectification = false;
+    bool supportsPostProcessing = false;
+    bool supportsSubpixelInterpolation = false;
+    bool supportsIncremental = false;
+    bool supportsSparseQueries = false;
+    bool supportsCostVolume = false;
+    bool supportsConfidence = false;
+
+    // Separate instances can compute on separate threads at the same time.
+    // No generator is safe to share between threads.
+    bool reentrant = true;
+
+    // Rough cost model, see DisparityMapBackendRegistry::estimateFrameTimeMs().
+    // A fixed per-frame overhead (launches, transfers), plus a time per block pixel compared,
+    //   which backends that run on OpenMP threads divide by the thread count.
+    // Backends that select another backend themselves (Auto) are never selected.
+    double fixedCostMs = 0;
+    double nanosecondsPerComparison = 1;
+    bool scalesWithOpenMpThreads = false;
+    bool selectable = true;
+
+    std::function<std::unique_ptr<DisparityMapGenerator>(const DisparityMapAlgorithmParameters_t&)> create;
+} DisparityMapBackendInfo_t;
+
+// Every backend of the program, registered during static initialization by a
+//   DisparityMapBackendRegistration in its own source file. Names are matched case-insensitively.
+// The CPU backends are part of the core library. Backends that need a device runtime (CUDA, OpenCL)
+//   are plugins, only loaded once a backend is asked for that the core does not have,
+//   so that programs neither load nor require runtimes they do not use.
+class DisparityMapBackendRegistry {
+    public:
+        static DisparityMapBackendRegistry& getInstance();
+
+        // Throws if a backend of the same name is already registered.
+        void registerBackend(const DisparityMapBackendInfo_t& info);
+
+        // In registration order. Loads the plugins first.
+        std::vector<DisparityMapBackendInfo_t> getBackends();
+        std::vector<std::string> getNames();
+
+        // Loads the plugins if the name is not registered yet.
+        bool find(const std::string& name, DisparityMapBackendInfo_t& info);
+
+        // Loads every libDisparityBackend*.so in getPluginDirectories(), once.
+        // A plugin that fails to load, e.g. because its runtime is not installed, is skipped
+        //   and its error is kept for getPluginErrors().
+        void loadPlugins();
+
+        std::vector<std::string> getPluginErrors() const;
+
+        // The directories listed in $STEREO_VISION_PLUGIN_PATH (separated by ':'),
+        //   or else the directory of the running executable.
+        static std::vector<std::string> getPluginDirectories();
+
+        // Why the backend cannot run these parameters on inputType images, or empty if it can.
+        // Does not look for devices, see isAvailable().
+        static std::string checkSupport(
+            const DisparityMapBackendInfo_t& info,
+            const DisparityMapAlgorithmParameters_t& parameters,
+            int inputType);
+
+        // Whether this host has the instruction sets and devices the backend needs.
+        static bool isAvailable(const DisparityMapBackendInfo_t& info);
+
+        static double estimateFrameTimeMs(
+            const DisparityMapBackendInfo_t& info,
+            const DisparityMapAlgorithmParameters_t& parameters,
+            int rows,
+            int cols);
+
+        // The selectable, available backends that support the parameters, fastest estimate first.
+        std::vector<DisparityMapBackendInfo_t> findSupporting(
+            const DisparityMapAlgorithmParameters_t& parameters,
+            int rows,
+            int cols,
+            int inputType);
+
+        // Throws if no backend supports the parameters.
+        DisparityMapBackendInfo_t selectFastest(
+            const DisparityMapAlgorithmParameters_t& parameters,
+            int rows,
+            int cols,
+            int inputType);
+
+        static bool isInstructionSetSupported(const std::string& instructionSet);
+
+    private:
+        DisparityMapBackendRegistry() = default;
+
+        mutable std::mutex mutex_;
+        std::vector<DisparityMapBackendInfo_t> backends_;
+        std::vector<std::string> pluginErrors_;
+
+        // Plugins register themselves while they are opened, which takes mutex_, so loading uses its own guard.
+        // Plugins are never closed, since their backends stay registered.
+        std::once_flag pluginsLoaded_;
+
+        bool findRegistered(const std::string& name, DisparityMapBackendInfo_t& info) const;
+
+        static bool caseInsensitiveStringsEqual(
+            const std::string& s1,
+            const std::string& s2);
+};
+
+// Registers a backend when constructed. Each backend declares one at file scope:
+//   static DisparityMapBackendRegistration registration(createBackendInfo());
+class DisparityMapBackendRegistration {
+    public:
+        DisparityMapBackendRegistration(const DisparityMapBackendInfo_t& info) {
+            DisparityMapBackendRegistry::getInstance().registerBackend(info);
+        }
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdexcept>
+#include <vector>
+
 #include <opencv2/core.hpp>
 
 #include "DisparityMapAlgorithmParameters.hpp"
@@ -17,4 +20,45 @@ class DisparityMapGenerator {
             const cv::Mat& leftImage, 
             const cv::Mat& rightImage, 
             cv::Mat& disparity) = 0;
+
+        // Computes the disparity only at the requested pixels.
+        // The results are identical to the dense map at the same locations.
+        // Generators throw if they would post-process or rectify the dense map.
+        // If costs is provided, it receives the SAD at the selected disparity.
+        virtual void computeDisparityAt(
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage,
+            const std::vector<cv::Point>& points,
+            std::vector<float>& disparities,
+            std::vector<int>* costs = nullptr);
+
+        // Computes the disparity only inside the requested regions, clipped to the image.
+        // disparity (CV_32FC1) and costs (CV_32SC1, if provided) are allocated with create(),
+        //   so pixels outside of the regions are only left untouched if they already have the size and type of the output.
+        virtual void computeDisparityAt(
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage,
+            const std::vector<cv::Rect>& regions,
+            cv::Mat& disparity,
+            cv::Mat* costs = nullptr);
+
+    protected:
+        // Hooks of computeDisparityAt(), which checks the query and converts the images to grayscale.
+        // beginSparseQuery() throws if the generator does not support the query, and otherwise returns
+        //   whether computeDisparitySpan() may be called from several OpenMP threads at once.
+        // computeDisparitySpan() computes the pixels [minX, maxX) of row y. costs is null when they are not wanted.
+        virtual bool beginSparseQuery();
+
+        virtual void computeDisparitySpan(
+            const cv::Mat& leftGray,
+            const cv::Mat& rightGray,
+            int y,
+            int minX,
+            int maxX,
+            float* disparities,
+            int* costs);
+
+    private:
+        cv::Mat sparseLeftGrayImage_;
+        cv::Mat sparseRightGrayImage_;
 };
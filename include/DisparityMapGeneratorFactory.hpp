@@ -6,13 +6,10 @@
 #include "DisparityMapAlgorithmParameters.hpp"
 #include "DisparityMapGenerator.hpp"
 
+// Creates the backend named by parameters.algorithmName from DisparityMapBackendRegistry.
 class DisparityMapGeneratorFactory {
     public:
+        // Throws if the name is not registered, or the backend does not support the parameters.
         std::unique_ptr<DisparityMapGenerator> create(
                 const DisparityMapAlgorithmParameters_t& parameters);
-
-    private:
-        bool caseInsensitiveStringsEqual(
-            const std::string& s1,
-            const std::string& s2);
 };
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DisparityMapAlgorithmParameters.hpp"
+
+#include <immintrin.h>
+
+// Median and speckle filtering of CV_32FC1 disparity maps.
+// Both stages work on row ranges, so that a generator can run them on each strip
+//   of the output right after matching it, while the strip is still in cache.
+// Usage, for strips of stripHeight rows:
+//   processor.beginFrame(rows, cols);
+//   for each strip (concurrently): processor.medianFilterRows(raw, minY, maxY, disparity);
+//                                  processor.labelSpeckleRows(disparity, minY, maxY);
+//   processor.removeSpeckles(disparity, stripHeight);
+class DisparityPostProcessor {
+    public:
+        DisparityPostProcessor(const DisparityMapAlgorithmParameters_t& parameters);
+
+        bool isEnabled() const;
+        bool isMedianFilterEnabled() const;
+        bool isSpeckleFilterEnabled() const;
+
+        // Rows either side of a strip that medianFilterRows() reads.
+        int getMedianRadius() const;
+
+        // Sizes the speckle labels for a frame. Must be called before labelSpeckleRows().
+        void beginFrame(int rows, int cols);
+
+        // Writes rows [minY, maxY) of the median of source into destination, which must not
+        //   be source. The image border is replicated. Copies the rows if the median is disabled.
+        void medianFilterRows(const cv::Mat& source, int minY, int maxY, cv::Mat& destination) const;
+
+        // Joins the similar neighbours within rows [minY, maxY) into regions.
+        // Disjoint row ranges can be labelled concurrently.
+        void labelSpeckleRows(const cv::Mat& disparity, int minY, int maxY);
+
+        // Joins the regions across the seams between strips of stripHeight rows,
+        //   then replaces every region of at most speckleMaxSize pixels.
+        void removeSpeckles(cv::Mat& disparity, int stripHeight);
+
+        // Runs every enabled stage over a whole frame.
+        void apply(const cv::Mat& rawDisparity, cv::Mat& disparity);
+
+    private:
+        // Rows per strip when apply() processes a whole frame.
+        static constexpr int STRIP_HEIGHT = 32;
+
+        // Disparities filtered per iteration of the SIMD median.
+        static constexpr int SIMD_WIDTH = 8;
+
+        int medianRadius_;
+        int speckleMaxSize_;
+        float speckleMaxDifference_;
+        float speckleNewValue_;
+
+        int frameCols_ = 0;
+        std::vector<int> speckleParents_;
+        std::vector<int> speckleRoots_;
+        std::vector<int> speckleSizes_;
+        cv::Mat rawDisparity_;
+
+        bool isSimilar(float a, float b) const;
+        int findRoot(int index);
+        int findRootReadOnly(int index) const;
+        void unite(int a, int b);
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DisparityMapAlgorithmParameters.hpp"
+
+#include <immintrin.h>
+
+// One projected pixel, in the units of the baseline.
+// The layout is also the record format of PointCloudWriter.
+typedef struct PointXYZI {
+    float x;
+    float y;
+    float z;
+    float intensity;
+} PointXYZI_t;
+
+// Turns disparities into depth or 3D points for a rectified pinhole stereo pair:
+//   z = focalLength * baseline / d, x = (u - cx) * z / focalLength, y = (v - cy) * z / focalLength.
+// Works on row ranges, so that a generator can project each strip as soon as it is final.
+class DisparityProjector {
+    public:
+        // Disparities at or below minDisparity are invalid.
+        DisparityProjector(
+            double focalLength,
+            double baseline,
+            double principalPointX,
+            double principalPointY,
+            float minDisparity);
+
+        // Reads the camera from parameters. A negative principal point selects the image centre.
+        static DisparityProjector fromParameters(
+            const DisparityMapAlgorithmParameters_t& parameters,
+            int imageRows,
+            int imageCols);
+
+        // Writes the depth of rows [minY, maxY) into depth (CV_32FC1). Invalid pixels get 0.
+        void computeDepthRows(const cv::Mat& disparity, int minY, int maxY, cv::Mat& depth) const;
+
+        // Appends the points of the valid pixels in rows [minY, maxY) to points.
+        // intensity (CV_8UC1) supplies each point's intensity, or 0 if it is empty.
+        // If confidence (CV_32FC1) is not empty, pixels below minConfidence are skipped too.
+        void projectRows(
+            const cv::Mat& disparity,
+            const cv::Mat& intensity,
+            const cv::Mat& confidence,
+            float minConfidence,
+            int minY,
+            int maxY,
+            std::vector<PointXYZI_t>& points) const;
+
+    private:
+        static constexpr int SIMD_WIDTH = 8;
+
+        float focalLength_;
+        float focalLengthTimesBaseline_;
+        float principalPointX_;
+        float principalPointY_;
+        float minDisparity_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DisparityMapAlgorithmParameters.hpp"
+#include "DisparityMapGenerator.hpp"
+#include "DisparityServiceProtocol.hpp"
+
+// Long-running disparity service.
+// Generators are kept warm between clients: when a client disconnects, its generator
+//   is parked in a pool and handed to the next client asking for the same parameters.
+// Each client is served by its own thread, with its own shared-memory ring of frame slots.
+// Backends that are not reentrant (see DisparityMapBackendInfo_t) share state between their instances,
+//   so their clients take turns, one frame at a time. Auto may select any of them, so they all share one turn.
+class DisparityServer {
+    public:
+        // Client requests override the algorithm name, block size and scan steps of templateParameters.
+        DisparityServer(
+            const std::string& socketPath,
+            const DisparityMapAlgorithmParameters_t& templateParameters);
+
+        ~DisparityServer();
+
+        // Creates a generator and runs it on a blank frame of the given size,
+        //   so that lazily-initialized backends are ready before the first client arrives.
+        void warmUp(
+            const DisparityMapAlgorithmParameters_t& parameters,
+            int width,
+            int height);
+
+        // Accepts clients until stop() is called.
+        void run();
+
+        // Safe to call from a signal handler.
+        void stop();
+
+        int getNumIdleGenerators();
+
+    private:
+        std::string socketPath_;
+        DisparityMapAlgorithmParameters_t templateParameters_;
+        int listenFd_ = -1;
+        std::atomic<bool> stopRequested_;
+
+        std::mutex mutex_;
+        std::multimap<std::string, std::unique_ptr<DisparityMapGenerator>> idleGenerators_;
+        std::map<int, std::thread> clientThreads_;
+        std::vector<int> finishedClientFds_;
+        std::mutex nonReentrantMutex_;
+        int nextSessionId_ = 0;
+
+        void serveClient(int clientFd, int sessionId);
+
+        void processFrames(
+            int clientFd,
+            DisparityMapGenerator& generator,
+            std::mutex* backendMutex,
+            uint8_t* sharedMemory,
+            const DisparityServiceMessage_t& openMessage);
+
+        std::unique_ptr<DisparityMapGenerator> acquireGenerator(
+            const DisparityMapAlgorithmParameters_t& parameters);
+
+        void releaseGenerator(
+            const DisparityMapAlgorithmParameters_t& parameters,
+            std::unique_ptr<DisparityMapGenerator> generator);
+
+        void joinFinishedClients();
+
+        // The mutex generators of the backend compute under, or nullptr if it is reentrant.
+        std::mutex* findBackendMutex(const std::string& algorithmName);
+
+        static std::string computeGeneratorKey(const DisparityMapAlgorithmParameters_t& parameters);
+
+        static void sendError(int clientFd, int slot, const std::string& errorMessage);
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// Control messages exchanged between DisparityClient and DisparityServer over a Unix domain socket.
+// Frames never travel over the socket. They live in a shared-memory ring of slots,
+//   whose file descriptor is passed to the client along with the Opened reply.
+enum class DisparityServiceMessageType : uint32_t {
+    // Client to server: algorithm parameters and frame geometry.
+    Open = 1,
+    // Server to client: carries the shared-memory file descriptor.
+    Opened,
+    // Client to server: the images in the slot are ready.
+    Submit,
+    // Server to client: the disparity in the slot is ready.
+    Completed,
+    // Server to client: errorMessage describes what went wrong.
+    Error,
+    // Client to server: the session is over.
+    Close
+};
+
+typedef struct DisparityServiceMessage {
+    uint32_t type;
+    int32_t slot;
+
+    int32_t width;
+    int32_t height;
+    int32_t numSlots;
+
+    int32_t blockSize;
+    int32_t leftScanSteps;
+    int32_t rightScanSteps;
+    char algorithmName[64];
+
+    // Server-side time spent computing the slot's disparity.
+    double computeTimeMs;
+
+    char errorMessage[256];
+} DisparityServiceMessage_t;
+
+// Byte offsets within one slot of the shared-memory ring.
+// Every section is 64-byte aligned, so that the SIMD backends can use it directly.
+typedef struct DisparityServiceSlotLayout {
+    size_t leftImageOffset;
+    size_t rightImageOffset;
+    size_t disparityOffset;
+    size_t slotSize;
+} DisparityServiceSlotLayout_t;
+
+class DisparityServiceProtocol {
+    public:
+        static DisparityServiceSlotLayout_t computeSlotLayout(int width, int height);
+
+        // Optionally passes a file descriptor along with the message (SCM_RIGHTS).
+        static void sendMessage(
+            int socketFd,
+            const DisparityServiceMessage_t& message,
+            int fileDescriptor = -1);
+
+        // Returns false if the peer closed the connection.
+        static bool receiveMessage(
+            int socketFd,
+            DisparityServiceMessage_t& message,
+            int* fileDescriptor = nullptr);
+
+        // Sends or receives exactly size bytes on a stream socket, optionally passing a descriptor.
+        // Also used by the shard transports, which carry their own headers.
+        static void sendBytes(
+            int socketFd,
+            const void* data,
+            size_t size,
+            int fileDescriptor = -1);
+
+        static bool receiveBytes(
+            int socketFd,
+            void* data,
+            size_t size,
+            int* fileDescriptor = nullptr);
+
+        static void copyString(const std::string& source, char* destination, size_t destinationSize);
+
+        // $XDG_RUNTIME_DIR/StereoVisionMultiWay.sock, falling back to /tmp/StereoVisionMultiWay.sock.
+        static std::string getDefaultSocketPath();
+};
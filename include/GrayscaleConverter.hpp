@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+
+#include <immintrin.h>
+
+// Converts 3-channel BGR input to the 8-bit luma the matchers run on.
+// Uses the same fixed-point BT.601 weights as cv::cvtColor(COLOR_BGR2GRAY),
+//   so the output is bit-identical to converting up front.
+// Rows can be converted on their own, so that a backend can convert just the rows
+//   it is about to read, straight into its own staging buffers.
+class GrayscaleConverter {
+    public:
+        // Luma of one BGR pixel.
+        static inline uint8_t toGray(int blue, int green, int red) {
+            return static_cast<uint8_t>(
+                ((blue * BLUE_WEIGHT) + (green * GREEN_WEIGHT) + (red * RED_WEIGHT) + (1 << (WEIGHT_BITS - 1))) >> WEIGHT_BITS);
+        }
+
+        // Converts rows [minY, maxY) of a CV_8UC1 or CV_8UC3 image into destination,
+        //   a buffer of (maxY - minY) rows of image.cols bytes. CV_8UC1 rows are copied.
+        static void convertRows(const cv::Mat& image, int minY, int maxY, uint8_t* destination);
+
+        // Returns image if it is already CV_8UC1, otherwise converts it into buffer and returns that.
+        static const cv::Mat& ensureGray(const cv::Mat& image, cv::Mat& buffer);
+
+        // Throws unless image is CV_8UC1 or CV_8UC3.
+        static void ensureSupportedType(const cv::Mat& image);
+
+    private:
+        static constexpr int WEIGHT_BITS = 14;
+        static constexpr int BLUE_WEIGHT = 1868;
+        static constexpr int GREEN_WEIGHT = 9617;
+        static constexpr int RED_WEIGHT = 4899;
+
+        // Pixels converted per iteration of the SIMD loop.
+        static constexpr int SIMD_PIXELS = 16;
+
+        static void convertRowSimd(const uint8_t* source, int width, uint8_t* destination);
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+
+#include "DisparityMapAlgorithmParameters.hpp"
+#include "DisparityMapGenerator.hpp"
+#include "OpenClDisparityMapGenerator.hpp"
+#include "OpenMpThreadedSimdDisparityMapGenerator.hpp"
+
+// Splits each frame's rows between the OpenCL device(s) and the OpenMP SIMD CPU path.
+// The OpenCL share is rebalanced after every frame from the measured completion
+//   times of both sides, so that they finish together.
+class HybridDisparityMapGenerator : public DisparityMapGenerator {
+    public:
+        HybridDisparityMapGenerator(
+            const DisparityMapAlgorithmParameters_t& parameters);
+
+        virtual void setParameters(
+            const DisparityMapAlgorithmParameters_t& parameters) override;
+
+        virtual const DisparityMapAlgorithmParameters_t& getParameters() const override;
+        
+        virtual void computeDisparity(
+            const cv::Mat& leftImage, 
+            const cv::Mat& rightImage, 
+            cv::Mat& disparity) override;
+
+        // The fraction of rows the next frame will send to OpenCL.
+        double getOpenClRowFraction() const;
+
+    private:
+        // Unless the fraction is 0 or 1, both sides keep at least this many rows, so that their throughput can still be measured.
+        static constexpr int MIN_ROWS_PER_SIDE = 8;
+
+        DisparityMapAlgorithmParameters_t parameters_;
+        std::unique_ptr<OpenClDisparityMapGenerator> openClGenerator_;
+        std::unique_ptr<OpenMpThreadedSimdDisparityMapGenerator> cpuGenerator_;
+
+        double openClRowFraction_;
+        double openClRowsPerSecond_ = 0;
+        double cpuRowsPerSecond_ = 0;
+
+        void ensureParametersValid();
+        int computeOpenClRows(int imageHeight) const;
+        void updateRowFraction(int openClRows, double openClSeconds, int cpuRows, double cpuSeconds);
+};
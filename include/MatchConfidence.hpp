@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+enum class ConfidenceMeasure {
+    None,
+    PeakRatio,
+    Curvature
+};
+
+// How distinct the cost minimum of a pixel is, from the costs of its candidates.
+//   PeakRatio is 1 - best / second, where second is the lowest cost of the candidates more than one step
+//     from the best one, so that the neighbours of the best candidate do not count against it.
+//     It is in [0, 1], and 0 for ambiguous matches: a flat curve, a tie or plateau wider than two candidates,
+//     or a single candidate. Without candidates more than one step away, second is the lowest neighbour.
+//   Curvature is previous + next - 2 * best at the minimum, divided by the number of block pixels.
+//     A candidate at the end of the scan range takes its one neighbour for both, and a single candidate gives 0.
+class MatchConfidence {
+    public:
+        // One of "none", "peakRatio" or "curvature".
+        static ConfidenceMeasure parse(const std::string& name);
+
+        static inline float computePeakRatio(int bestCost, int secondCost) {
+            if (secondCost <= 0) {
+                return 0.0f;
+            }
+
+            return 1.0f - (static_cast<float>(bestCost) / static_cast<float>(secondCost));
+        }
+
+        static inline float computeCurvature(int previousCost, int bestCost, int nextCost, int numBlockPixels) {
+            return static_cast<float>(previousCost + nextCost - (2 * bestCost)) / static_cast<float>(numBlockPixels);
+        }
+};
+
+// Tracks the peak ratio in the search loop, from the candidates in any order.
+// Three neighbouring candidates hide at most three of the four lowest costs,
+//   so those four always hold the second cost of the peak ratio.
+class PeakRatioTracker {
+    public:
+        inline void reset() {
+            this->numKept_ = 0;
+        }
+
+        inline void add(int index, int cost) {
+            int k = std::min(this->numKept_, NUM_KEPT - 1);
+            if ((this->numKept_ == NUM_KEPT) && (cost >= this->costs_[k])) {
+                return;
+            }
+
+            for (; (k > 0) && (this->costs_[k - 1] > cost); k--) {
+                this->costs_[k] = this->costs_[k - 1];
+                this->indices_[k] = this->indices_[k - 1];
+            }
+
+            this->costs_[k] = cost;
+            this->indices_[k] = index;
+            this->numKept_ = std::min(this->numKept_ + 1, NUM_KEPT);
+        }
+
+        // Candidates costing more than this can not change the peak ratio, and need not be summed exactly.
+        inline int getBound() const {
+            return (this->numKept_ < NUM_KEPT) ? std::numeric_limits<int>::max() : this->costs_[NUM_KEPT - 1];
+        }
+
+        // The peak ratio once every candidate that can change it is added. bestIndex is the search's argmin.
+        inline float getPeakRatio(int bestIndex, int bestCost) const {
+            int neighbourCost = std::numeric_limits<int>::max();
+            for (int k = 0; k < this->numKept_; k++) {
+                int distance = std::abs(this->indices_[k] - bestIndex);
+                if (distance > 1) {
+                    return MatchConfidence::computePeakRatio(bestCost, this->costs_[k]);
+                } else if ((distance == 1) && (neighbourCost == std::numeric_limits<int>::max())) {
+                    neighbourCost = this->costs_[k];
+                }
+            }
+
+            return (neighbourCost == std::numeric_limits<int>::max())
+                ? 0.0f
+                : MatchConfidence::computePeakRatio(bestCost, neighbourCost);
+        }
+
+    private:
+        static constexpr int NUM_KEPT = 4;
+
+        int costs_[NUM_KEPT];
+        int indices_[NUM_KEPT];
+        int numKept_ = 0;
+};
@@ -1,19 +1,34 @@
 #pragma once
 
-#include <fstream>
-#include <sstream>
+#include <map>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <CL/cl.h>
 #include <opencv2/core.hpp>
 
 #include "DisparityMapAlgorithmParameters.hpp"
 #include "DisparityMapGenerator.hpp"
+#include "GrayscaleConverter.hpp"
+#include "OpenClProgramCache.hpp"
+#include "PipelinedDisparityMapGenerator.hpp"
 
-class OpenClDisparityMapGenerator : public DisparityMapGenerator {
+enum class OpenClKernelVariant {
+    // One candidate per iteration, tiled in local memory when it fits.
+    Scalar,
+    // uchar16 loads with abs_diff, several candidates per iteration.
+    Vectorized
+};
+
+class OpenClDisparityMapGenerator : public PipelinedDisparityMapGenerator {
     public:
+        // Kernels that are not specialized for the scan steps keep the costs of a pixel in a fixed array.
+        static constexpr int MAX_DISPARITY_RANGE = 512;
+
         OpenClDisparityMapGenerator(
-            const DisparityMapAlgorithmParameters_t& parameters);
+            const DisparityMapAlgorithmParameters_t& parameters,
+            OpenClKernelVariant kernelVariant = OpenClKernelVariant::Scalar);
 
         virtual ~OpenClDisparityMapGenerator() override;
 
@@ -27,27 +42,135 @@ class OpenClDisparityMapGenerator : public DisparityMapGenerator {
             const cv::Mat& rightImage, 
             cv::Mat& disparity) override;
 
+        // Asynchronous interface.
+        // enqueueDisparity() uploads the frame and launches the kernel without waiting.
+        //   Up to openClNumBufferSets frames may be in flight, so that the upload of
+        //   frame N+1 overlaps the computation of frame N.
+        // dequeueDisparity() waits for the oldest frame in flight and copies out its disparity,
+        //   which is allocated with create() if it is not already a CV_32FC1 Mat of the frame size.
+        virtual void enqueueDisparity(
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage) override;
+
+        // Only computes output rows [rowMinY, rowMinY + numRows).
+        // The matching dequeueDisparity() leaves the other rows of the output untouched.
+        void enqueueDisparity(
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage,
+            int rowMinY,
+            int numRows);
+
+        virtual void dequeueDisparity(cv::Mat& disparity) override;
+
+        virtual int getNumFramesInFlight() const override;
+
+        // The devices (or sub-devices) frames are split across. Available after the first frame.
+        virtual std::vector<std::string> getDeviceNames() const override;
+
+        // Describes every OpenCL device visible on this machine, one per line.
+        static std::vector<std::string> listAvailableDevices();
+
     private:
-        DisparityMapAlgorithmParameters_t parameters_;
+        // Device buffers, along with pinned (CL_MEM_ALLOC_HOST_PTR) staging buffers
+        //   that stay mapped for the lifetime of the set.
+        // The buffers are sized for the full image, so that bands can be rebalanced freely.
+        typedef struct OclBufferSet {
+            cl_mem leftImageData;
+            cl_mem rightImageData;
+            cl_mem disparityData;
 
-        bool openClKernelCreated_ = false;
-        int imageWidth_;
-        int imageHeight_;
+            cl_mem leftImagePinned;
+            cl_mem rightImagePinned;
+            cl_mem disparityPinned;
+            uint8_t* leftImageHost;
+            uint8_t* rightImageHost;
+            float* disparityHost;
+
+            // The band of output rows computed by the frame in flight, if any.
+            int bandMinY;
+            int bandNumRows;
+            cl_event kernelEvent;
+            cl_event readEvent;
+        } OclBufferSet_t;
+
+        // A program built for one parameter set and image size.
+        // The parameters are passed as -D build options, so they are compile-time constants.
+        typedef struct OclSpecializedKernel {
+            cl_program program;
+            cl_kernel kernel;
+
+            // The tiled kernel is used whenever its tiles fit in local memory.
+            // Otherwise, the untiled kernel reads straight from global memory.
+            bool useTiledKernel;
+            size_t localWorkSize[2];
+            size_t leftTileBytes;
+            size_t rightTileBytes;
+        } OclSpecializedKernel_t;
+
+        // A device (or sub-device) with its own context, queues, kernels and buffers.
+        typedef struct OclDevice {
+            cl_device_id deviceId;
+            bool isSubDevice;
+            std::string name;
+
+            cl_context context;
+            cl_command_queue uploadQueue;
+            cl_command_queue computeQueue;
+            cl_command_queue downloadQueue;
+
+            // Keyed by build options. Switching between parameter sets
+            //   only compiles each variant the first time it is used.
+            std::map<std::string, OclSpecializedKernel_t> specializedKernels;
+            std::vector<OclBufferSet_t> bufferSets;
+
+            // Measured from kernel profiling, and used to balance the bands.
+            double rowsPerSecond;
+        } OclDevice_t;
+
+        // The vectorized kernel loads 16 bytes at a time, and may read past the last pixel.
+        static constexpr int VECTOR_LOAD_PADDING = 32;
+
+        DisparityMapAlgorithmParameters_t parameters_;
+        OpenClKernelVariant kernelVariant_;
 
-        cl_platform_id oclPlatformId_;
-        cl_device_id oclDeviceId_;
-        cl_uint oclNumDevices_;
-        cl_uint oclNumPlatforms_;
+        bool openClContextCreated_ = false;
+        int imageWidth_ = 0;
+        int imageHeight_ = 0;
 
-        cl_context oclContext_;
-        cl_command_queue oclCommandQueue_;
-        cl_mem oclLeftImageData_;
-        cl_mem oclRightImageData_;
-        cl_mem oclDisparityData_;
-        cl_program oclProgram_;
-        cl_kernel oclKernel_;
+        std::vector<OclDevice_t> oclDevices_;
+        int numBufferSets_ = 0;
+        int nextBufferSet_ = 0;
+        int numFramesInFlight_ = 0;
 
         void ensureParametersValid();
-        void initializeOclKernel();
-        void cleanOclKernel();
+        void initializeOclDevices();
+        std::vector<cl_device_id> selectOclDevices();
+        std::vector<cl_device_id> partitionOclDevice(cl_device_id deviceId);
+        void ensureBufferSetsAllocated(int imageWidth, int imageHeight);
+        void createBufferSets(OclDevice_t& device);
+        void releaseBufferSets(OclDevice_t& device);
+        void releaseBandEvents(OclBufferSet_t& bufferSet);
+        std::vector<int> computeBandRows(int numRows);
+        void enqueueBand(
+            OclDevice_t& device,
+            OclBufferSet_t& bufferSet,
+            int bandMinY,
+            int bandNumRows,
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage);
+        std::string computeBuildOptions() const;
+        const OclSpecializedKernel_t& getSpecializedKernel(OclDevice_t& device);
+        void buildSpecializedKernel(
+            OclDevice_t& device,
+            const std::string& buildOptions,
+            OclSpecializedKernel_t& specializedKernel);
+        bool selectTiledWorkGroupSize(
+            OclDevice_t& device,
+            OclSpecializedKernel_t& specializedKernel);
+        void selectWorkGroupSize(
+            OclDevice_t& device,
+            OclSpecializedKernel_t& specializedKernel);
+        void cleanOcl();
+        static void checkOclError(cl_int ret, const std::string& operation);
+        static std::string getOclInfoString(cl_platform_id platformId, cl_device_id deviceId, cl_uint paramName);
 };
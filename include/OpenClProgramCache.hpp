@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <CL/cl.h>
+
+// Builds OpenCL programs, caching the compiled binaries on disk.
+// Entries are keyed by a hash of the device name, driver version,
+//   build options and program source, so any change to these triggers a rebuild.
+class OpenClProgramCache {
+    public:
+        // An empty cache directory disables the cache.
+        OpenClProgramCache(const std::string& cacheDirectory);
+
+        cl_program buildProgram(
+            cl_context context,
+            cl_device_id device,
+            const std::string& source,
+            const std::string& buildOptions);
+
+        // CacheDirectory::getDefault().
+        static std::string getDefaultCacheDirectory();
+
+    private:
+        std::string cacheDirectory_;
+
+        std::string computeCacheFilePath(
+            cl_device_id device,
+            const std::string& source,
+            const std::string& buildOptions);
+
+        cl_program loadBinary(
+            cl_context context,
+            cl_device_id device,
+            const std::string& cacheFilePath,
+            const std::string& buildOptions);
+
+        void storeBinary(
+            cl_program program,
+            const std::string& cacheFilePath);
+
+        cl_program buildFromSource(
+            cl_context context,
+            cl_device_id device,
+            const std::string& source,
+            const std::string& buildOptions);
+
+        std::string getDeviceInfoString(
+            cl_device_id device,
+            cl_device_info paramName);
+
+        void createDirectories(const std::string& path);
+};
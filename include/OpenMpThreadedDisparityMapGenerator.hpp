@@ -7,9 +7,13 @@
 
 #include "DisparityMapAlgorithmParameters.hpp"
 #include "DisparityMapGenerator.hpp"
+#include "GrayscaleConverter.hpp"
 
 class OpenMpThreadedDisparityMapGenerator : public DisparityMapGenerator {
     public:
+        // computeDisparityForPixel() keeps the costs of a pixel on the stack.
+        static constexpr int MAX_DISPARITY_RANGE = 512;
+
         OpenMpThreadedDisparityMapGenerator(
             const DisparityMapAlgorithmParameters_t& parameters);
 
@@ -24,14 +28,30 @@ class OpenMpThreadedDisparityMapGenerator : public DisparityMapGenerator {
             cv::Mat& disparity) override;
 
     private:
+        virtual bool beginSparseQuery() override;
+
+        virtual void computeDisparitySpan(
+            const cv::Mat& leftGray,
+            const cv::Mat& rightGray,
+            int y,
+            int minX,
+            int maxX,
+            float* disparities,
+            int* costs) override;
+
         DisparityMapAlgorithmParameters_t parameters_;
 
+        // Color input is converted into these before matching.
+        cv::Mat leftGrayImage_;
+        cv::Mat rightGrayImage_;
+
         void ensureParametersValid();
         float computeDisparityForPixel(
                 int y, 
                 int x, 
                 const cv::Mat& leftImage, 
-                const cv::Mat& rightImage);
+                const cv::Mat& rightImage,
+                int* bestCost = nullptr);
 
         int computeSadOverBlock(
                 int minYL,
@@ -1,17 +1,41 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <omp.h>
 #include <stdexcept>
+#include <vector>
 
 #include <opencv2/core.hpp>
 
+#include "CostVolume.hpp"
 #include "DisparityMapAlgorithmParameters.hpp"
 #include "DisparityMapGenerator.hpp"
+#include "DisparityPostProcessor.hpp"
+#include "DisparityProjector.hpp"
+#include "GrayscaleConverter.hpp"
+#include "MatchConfidence.hpp"
+#include "PointCloudWriter.hpp"
+#include "ScanlineRingBuffer.hpp"
+#include "StereoRectifier.hpp"
+#include "SubpixelRefiner.hpp"
+#include "TileChangeDetector.hpp"
 
 #include <immintrin.h>
 
 class OpenMpThreadedSimdDisparityMapGenerator : public DisparityMapGenerator {
     public:
+        // The costs of a pixel are kept on the stack, and the SAD masks one block row in a single 32-byte register.
+        static constexpr int MAX_DISPARITY_RANGE = 512;
+        static constexpr int MAX_BLOCK_SIZE = 31;
+
+        // Receives the rows [minY, maxY) of the cost volume that were just completed.
+        typedef std::function<void(const CostVolume& costVolume, int minY, int maxY)> CostVolumeCallback;
+
+        // Receives row y of a streamed disparity, which is only valid during the call.
+        typedef std::function<void(int y, const float* disparityRow)> DisparityRowCallback;
+
         OpenMpThreadedSimdDisparityMapGenerator(
             const DisparityMapAlgorithmParameters_t& parameters);
 
@@ -25,15 +49,208 @@ class OpenMpThreadedSimdDisparityMapGenerator : public DisparityMapGenerator {
             const cv::Mat& rightImage, 
             cv::Mat& disparity) override;
 
+        // Fraction of tiles recomputed by the last call to computeDisparity().
+        // Always 1 when incremental recomputation is disabled.
+        float getRecomputedTileFraction() const;
+
+        // Fraction of candidate block rows the last computation skipped through early termination.
+        // Always 0 when early termination is disabled.
+        float getSkippedBlockRowFraction() const;
+
+        // Rectifies the raw input pairs on the fly, fused with matching.
+        // Replaces any maps loaded from rectificationMapsPath. nullptr disables rectification.
+        void setRectifier(std::shared_ptr<const StereoRectifier> rectifier);
+
+        // Streams the points of every frame into writer, strip by strip as each becomes final.
+        // Needs the camera parameters (focalLength, baseline). nullptr disables it.
+        void setPointCloudWriter(std::shared_ptr<PointCloudWriter> writer);
+
+        // Projects the depth of every frame (CV_32FC1, see DisparityProjector) strip by strip
+        //   as each becomes final, the same way points are streamed. Read it with getDepth().
+        // Needs the camera parameters (focalLength, baseline).
+        void setDepthOutputEnabled(bool enabled);
+
+        // The depth of the last frame, or empty if depth output is disabled.
+        const cv::Mat& getDepth() const;
+
+        // The costs of the last frame, with costVolumeEnabled.
+        // Reused from frame to frame. Incremental recomputation keeps the costs of unchanged tiles.
+        const CostVolume& getCostVolume() const;
+
+        // Called during computeDisparity() as rows of the cost volume complete: for each batch with a window,
+        //   so that the rows can be consumed before they are overwritten, and otherwise once per frame.
+        void setCostVolumeCallback(CostVolumeCallback callback);
+
+        // The confidence of each pixel of the last frame (CV_32FC1), with a confidenceMeasure.
+        // Like the cost volume, it is reused, and incremental recomputation keeps that of unchanged tiles.
+        const cv::Mat& getConfidence() const;
+
+        // Scanline streaming, for sources that deliver rectified rows as they are captured, such as line-scan cameras.
+        // Only the last blockSize rows of each image are kept, so memory does not grow with the height.
+        //   Row y is matched and passed to callback as soon as row y + blockSize / 2 is pushed,
+        //   exactly as computeDisparity() would match it in a frame of the rows pushed.
+        // Post-processing, the cost volume, point clouds and rectification need more than one row,
+        //   and are not supported.
+        void beginStream(int cols, DisparityRowCallback callback);
+
+        // Appends the rows of leftRows and rightRows (CV_8UC1 or CV_8UC3) to the stream.
+        void pushRows(const cv::Mat& leftRows, const cv::Mat& rightRows);
+
+        // Emits the last blockSize / 2 rows, whose blocks end at the last row pushed, and ends the stream.
+        void endStream();
+
     private:
+        virtual bool beginSparseQuery() override;
+
+        virtual void computeDisparitySpan(
+            const cv::Mat& leftGray,
+            const cv::Mat& rightGray,
+            int y,
+            int minX,
+            int maxX,
+            float* disparities,
+            int* costs) override;
+
+        // The median reads at most 2 rows beyond a strip, which must stay within its neighbours.
+        static constexpr int MIN_STRIP_HEIGHT = 2;
+
+        // Progress of each strip through computeDisparityInStrips().
+        static constexpr int STRIP_UNMATCHED = 0;
+        static constexpr int STRIP_MATCHED = 1;
+        static constexpr int STRIP_POST_PROCESSED = 2;
+
+        // Pixels searched before each subpixel refinement pass.
+        static constexpr int SUBPIXEL_CHUNK_SIZE = 64;
+
         DisparityMapAlgorithmParameters_t parameters_;
+        SubpixelInterpolation subpixelInterpolation_ = SubpixelInterpolation::Parabolic;
+        ConfidenceMeasure confidenceMeasure_ = ConfidenceMeasure::None;
+        std::unique_ptr<DisparityPostProcessor> postProcessor_;
+        std::shared_ptr<const StereoRectifier> rectifier_;
+
+        // Only used for color input on the paths that need whole grayscale frames.
+        cv::Mat leftGrayImage_;
+        cv::Mat rightGrayImage_;
+
+        // Matcher output ahead of the median filter.
+        cv::Mat rawDisparity_;
+
+        std::shared_ptr<PointCloudWriter> pointCloudWriter_;
+        std::unique_ptr<DisparityProjector> pointProjector_;
+        cv::Mat pointIntensity_;
+        bool depthOutputEnabled_ = false;
+        cv::Mat depth_;
+
+        CostVolume costVolume_;
+        CostVolumeCallback costVolumeCallback_;
+        cv::Mat confidence_;
+
+        std::unique_ptr<TileChangeDetector> leftChangeDetector_;
+        std::unique_ptr<TileChangeDetector> rightChangeDetector_;
+        std::vector<uint8_t> leftChangedTiles_;
+        std::vector<uint8_t> rightChangedTiles_;
+        std::vector<int> leftChangedTilesIntegral_;
+        std::vector<int> rightChangedTilesIntegral_;
+        std::vector<int> dirtyTiles_;
+        cv::Mat cachedDisparity_;
+        float recomputedTileFraction_ = 1.0f;
+
+        ScanlineRingBuffer leftStreamRows_;
+        ScanlineRingBuffer rightStreamRows_;
+        std::vector<float> streamDisparityRow_;
+        DisparityRowCallback streamCallback_;
+        int streamNextRow_ = 0;
+        bool streaming_ = false;
+
+        // Block rows of the candidates searched, and how many of them were summed, since resetBlockRowCounters().
+        // Candidates summed again around the minimum count twice in both.
+        std::atomic<int64_t> numBlockRows_;
+        std::atomic<int64_t> numBlockRowsSummed_;
 
         void ensureParametersValid();
-        float computeDisparityForPixel(
+        void resetIncrementalState();
+        void resetBlockRowCounters();
+        void loadRectifier();
+        void computeDisparityInStrips(
+                const cv::Mat& leftImage,
+                const cv::Mat& rightImage,
+                cv::Mat& disparity);
+        // Median filters, labels and projects a strip once it and the strips whose rows
+        //   its median reads are matched. Whichever thread matches the last of them does the work,
+        //   so the rows are still in its cache.
+        void tryFinishStrip(
+                int strip,
+                int numStrips,
+                int imageRows,
+                std::vector<std::atomic<int>>& stripStates,
+                const cv::Mat& rawDisparity,
+                cv::Mat& disparity);
+        void beginProjectionFrame(int imageRows, int imageCols);
+        void beginCostVolumeFrame(int imageRows, int imageCols);
+        void completeCostVolumeRows(int minY, int maxY);
+        uint16_t* getCostVolumeRow(int y);
+        void beginConfidenceFrame(int imageRows, int imageCols);
+        float* getConfidenceRow(int y);
+        void emitStreamRow(int y, int imageRows);
+        void projectRows(
+                const cv::Mat& disparity,
+                int minY,
+                int maxY);
+        void computeDisparityIncremental(
+                const cv::Mat& leftImage,
+                const cv::Mat& rightImage,
+                cv::Mat& disparity);
+        void computeChangedTilesIntegral(
+                const std::vector<uint8_t>& changedTiles,
+                int numTileRows,
+                int numTileCols,
+                std::vector<int>& integral);
+        bool anyTileChanged(
+                const std::vector<int>& integral,
+                int numTileRows,
+                int numTileCols,
+                int minY,
+                int minX,
+                int maxY,
+                int maxX);
+        // Fills disparities[0, maxX - minX) (and bestCosts, if given) for pixels [minX, maxX) of row y.
+        // costVolumeRow and confidenceRow, if given, are the cost volume and confidence rows of y,
+        //   whose pixels [minX, maxX) are filled.
+        // The images only hold rows from bandMinY onwards, and imageRows is the height
+        //   of the full image, which the blocks are clamped to.
+        void computeDisparityForRow(
+                int y,
+                int minX,
+                int maxX,
+                int imageRows,
+                int bandMinY,
+                const cv::Mat& leftBand,
+                const cv::Mat& rightBand,
+                float* disparities,
+                int* bestCosts = nullptr,
+                uint16_t* costVolumeRow = nullptr,
+                float* confidenceRow = nullptr);
+
+        // Returns the integer disparity, along with the costs around the minimum for SubpixelRefiner.
+        // predictedSlot is the slot (as in CostVolume) to search first, or -1, and receives the slot of the minimum.
+        // numBlockRows and numBlockRowsSummed are incremented by the rows of the candidates searched and summed.
+        // costs, if given, receives the cost of every candidate, laid out as in CostVolume,
+        //   and confidence the confidenceMeasure of the match.
+        float computeIntegerDisparityForPixelInBand(
                 int y, 
                 int x, 
-                const cv::Mat& leftImage, 
-                const cv::Mat& rightImage);
+                int imageRows,
+                int bandMinY,
+                const cv::Mat& leftBand, 
+                const cv::Mat& rightBand,
+                int& previousCost,
+                int& bestCost,
+                int& nextCost,
+                uint16_t* costs,
+                float* confidence,
+                int& predictedSlot,
+                int64_t& numBlockRows,
+                int64_t& numBlockRowsSummed);
 
         int computeSadOverBlockSimd(
                 int minYL,
@@ -44,4 +261,18 @@ class OpenMpThreadedSimdDisparityMapGenerator : public DisparityMapGenerator {
                 int height,
                 const cv::Mat& leftImage,
                 const cv::Mat& rightImage);
+
+        // As computeSadOverBlockSimd(), but returns -1 as soon as the sum of the rows so far exceeds bound.
+        // numRowsSummed is incremented by the rows summed.
+        int computeBoundedSadOverBlockSimd(
+                int minYL,
+                int minXL,
+                int minYR,
+                int minXR,
+                int width,
+                int height,
+                const cv::Mat& leftImage,
+                const cv::Mat& rightImage,
+                int bound,
+                int64_t& numRowsSummed);
 };
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DisparityMapGenerator.hpp"
+
+// A generator that can keep several frames in flight on its devices.
+// Programs use this to drive pipelined backends without linking them, since backends
+//   that need a device runtime are plugins (see DisparityMapBackendRegistry::loadPlugins()).
+class PipelinedDisparityMapGenerator : public DisparityMapGenerator {
+    public:
+        virtual ~PipelinedDisparityMapGenerator();
+
+        // enqueueDisparity() starts a frame without waiting for it.
+        // dequeueDisparity() waits for the oldest frame in flight and copies out its disparity.
+        virtual void enqueueDisparity(
+            const cv::Mat& leftImage,
+            const cv::Mat& rightImage) = 0;
+
+        virtual void dequeueDisparity(cv::Mat& disparity) = 0;
+
+        virtual int getNumFramesInFlight() const = 0;
+
+        // The devices frames run on. Available after the first frame.
+        virtual std::vector<std::string> getDeviceNames() const = 0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "DisparityProjector.hpp"
+
+enum class PointCloudFormat {
+    // Binary little-endian PLY with float x, y, z and intensity properties.
+    Ply,
+
+    // Headerless PointXYZI_t records.
+    Raw
+};
+
+// Streams points to disk as they are produced, so that no frame-sized point buffer is needed.
+// Several threads may write at once. Each call's points stay together, but the
+//   order between calls follows whichever strip finished first.
+// The PLY vertex count is patched into the header by close().
+class PointCloudWriter {
+    public:
+        PointCloudWriter(const std::string& path, PointCloudFormat format);
+
+        ~PointCloudWriter();
+
+        // "ply" or "raw".
+        static PointCloudFormat parseFormat(const std::string& name);
+
+        void writePoints(const PointXYZI_t* points, size_t numPoints);
+
+        void close();
+
+        size_t getNumPoints() const;
+
+    private:
+        // Width of the zero-padded vertex count, which leaves room to patch it in place.
+        static constexpr int VERTEX_COUNT_DIGITS = 10;
+
+        std::string path_;
+        PointCloudFormat format_;
+        std::ofstream stream_;
+        std::streampos vertexCountPosition_;
+        size_t numPoints_ = 0;
+        mutable std::mutex mutex_;
+
+        std::string formatVertexCount(size_t numPoints) const;
+};
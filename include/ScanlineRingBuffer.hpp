@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// The latest numRows rows of an 8-bit gray image that arrives a row at a time.
+// Each row is stored twice, in slot y % numRows and in the slot numRows after it,
+//   so that any numRows consecutive rows can be read as one contiguous cv::Mat
+//   without moving rows as new ones arrive.
+class ScanlineRingBuffer {
+    public:
+        // Empties the buffer. paddingBytes past its end stay readable, for SIMD loads that run over.
+        void configure(int numRows, int cols, int paddingBytes);
+
+        // Appends row y of image (CV_8UC1 or CV_8UC3, converted to gray), as row getNumRowsPushed().
+        void pushRow(const cv::Mat& image, int y);
+
+        int getNumRowsPushed() const;
+
+        // Rows [minY, maxY), which must be among the last numRows pushed. Valid until the next push.
+        cv::Mat getRows(int minY, int maxY);
+
+    private:
+        int numRows_ = 0;
+        int cols_ = 0;
+        int numRowsPushed_ = 0;
+        std::vector<uint8_t> data_;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+
+enum class ShardRequestType : uint32_t {
+    Compute = 1,
+    Shutdown
+};
+
+// Asks a worker for the disparity of one row band.
+// The input rows include the halo above and below the band, so that the worker's
+//   blocks see the same pixels they would in the full frame.
+typedef struct ShardRequest {
+    uint32_t type;
+    int32_t width;
+    int32_t inputRows;
+    int32_t outputRowOffset;
+    int32_t outputRows;
+
+    int32_t blockSize;
+    int32_t leftScanSteps;
+    int32_t rightScanSteps;
+    char algorithmName[64];
+
+    // Only used by SharedMemoryShardTransport, when it attaches a new region.
+    uint64_t sharedMemorySize;
+} ShardRequest_t;
+
+typedef struct ShardResult {
+    // 0 on success, in which case outputRows rows of disparity follow.
+    int32_t status;
+    int32_t width;
+    int32_t outputRows;
+    double computeTimeMs;
+    char errorMessage[256];
+} ShardResult_t;
+
+// Carries row bands between the sharded coordinator and one worker process.
+// The coordinator calls sendRequest() / receiveResult(), the worker receiveRequest() / sendResult().
+class ShardTransport {
+    public:
+        virtual ~ShardTransport() {}
+
+        // leftRows and rightRows may be CV_8UC1 or CV_8UC3. Workers always receive gray rows.
+        virtual void sendRequest(
+            const ShardRequest_t& request,
+            const cv::Mat& leftRows,
+            const cv::Mat& rightRows) = 0;
+
+        // disparityRows must already have the band's size.
+        virtual void receiveResult(
+            ShardResult_t& result,
+            cv::Mat& disparityRows) = 0;
+
+        // Returns false if the coordinator has gone away.
+        // leftRows and rightRows may view transport-owned memory, valid until the next request.
+        virtual bool receiveRequest(
+            ShardRequest_t& request,
+            cv::Mat& leftRows,
+            cv::Mat& rightRows) = 0;
+
+        virtual void sendResult(
+            const ShardResult_t& result,
+            const cv::Mat& disparityRows) = 0;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DisparityMapAlgorithmParameters.hpp"
+#include "DisparityMapGenerator.hpp"
+#include "ShardTransport.hpp"
+
+// Splits each frame into row bands and computes them in DisparityShardWorker processes,
+//   each running the factory algorithm named by shardWorkerAlgorithm.
+// Bands are sent with (blockSize - 1) / 2 halo rows on either side, so the stitched
+//   result is identical to running the worker algorithm on the whole frame.
+class ShardedDisparityMapGenerator : public DisparityMapGenerator {
+    public:
+        ShardedDisparityMapGenerator(
+            const DisparityMapAlgorithmParameters_t& parameters);
+
+        virtual ~ShardedDisparityMapGenerator() override;
+
+        virtual void setParameters(
+            const DisparityMapAlgorithmParameters_t& parameters) override;
+
+        virtual const DisparityMapAlgorithmParameters_t& getParameters() const override;
+        
+        virtual void computeDisparity(
+            const cv::Mat& leftImage, 
+            const cv::Mat& rightImage, 
+            cv::Mat& disparity) override;
+
+        // Time each worker spent computing its band of the last frame.
+        const std::vector<double>& getWorkerComputeTimesMs() const;
+
+    private:
+        typedef struct ShardWorker {
+            pid_t pid;
+            std::unique_ptr<ShardTransport> transport;
+        } ShardWorker_t;
+
+        DisparityMapAlgorithmParameters_t parameters_;
+        std::vector<ShardWorker_t> workers_;
+        std::vector<double> workerComputeTimesMs_;
+
+        void ensureParametersValid();
+        void startWorkers();
+        void stopWorkers();
+
+        pid_t spawnWorker(const std::vector<std::string>& arguments);
+        std::string getWorkerExecutablePath() const;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+
+#include "ShardTransport.hpp"
+
+// Exchanges band pixels through a shared-memory region, with only the headers going over a Unix socket.
+// The coordinator owns the region, and replaces it (passing the new descriptor along
+//   with the request) whenever a band no longer fits.
+class SharedMemoryShardTransport : public ShardTransport {
+    public:
+        // Takes ownership of the connected Unix socket.
+        SharedMemoryShardTransport(int socketFd);
+
+        virtual ~SharedMemoryShardTransport() override;
+
+        virtual void sendRequest(
+            const ShardRequest_t& request,
+            const cv::Mat& leftRows,
+            const cv::Mat& rightRows) override;
+
+        virtual void receiveResult(
+            ShardResult_t& result,
+            cv::Mat& disparityRows) override;
+
+        virtual bool receiveRequest(
+            ShardRequest_t& request,
+            cv::Mat& leftRows,
+            cv::Mat& rightRows) override;
+
+        virtual void sendResult(
+            const ShardResult_t& result,
+            const cv::Mat& disparityRows) override;
+
+    private:
+        typedef struct RegionLayout {
+            size_t leftOffset;
+            size_t rightOffset;
+            size_t disparityOffset;
+            size_t size;
+        } RegionLayout_t;
+
+        int socketFd_;
+        uint8_t* region_ = nullptr;
+        size_t regionSize_ = 0;
+        RegionLayout_t layout_;
+
+        static RegionLayout_t computeLayout(int width, int inputRows);
+
+        // Returns the descriptor of the new region, or -1 if the current one is large enough.
+        int ensureRegionSize(size_t size);
+
+        void mapRegion(int regionFd, size_t size);
+        void unmapRegion();
+};
@@ -6,6 +6,7 @@
 
 #include "DisparityMapAlgorithmParameters.hpp"
 #include "DisparityMapGenerator.hpp"
+#include "GrayscaleConverter.hpp"
 
 class SingleThreadedDisparityMapGenerator : public DisparityMapGenerator {
     public:
@@ -23,7 +24,23 @@ class SingleThreadedDisparityMapGenerator : public DisparityMapGenerator {
             cv::Mat& disparity) override;
 
     private:
+        virtual bool beginSparseQuery() override;
+
+        virtual void computeDisparitySpan(
+            const cv::Mat& leftGray,
+            const cv::Mat& rightGray,
+            int y,
+            int minX,
+            int maxX,
+            float* disparities,
+            int* costs) override;
+
         DisparityMapAlgorithmParameters_t parameters_;
+
+        // Color input is converted into these before matching.
+        cv::Mat leftGrayImage_;
+        cv::Mat rightGrayImage_;
+
         std::vector<int> disparityBuf_;
 
         void ensureParametersValid();
@@ -31,7 +48,8 @@ class SingleThreadedDisparityMapGenerator : public DisparityMapGenerator {
                 int y, 
                 int x, 
                 const cv::Mat& leftImage, 
-                const cv::Mat& rightImage);
+                const cv::Mat& rightImage,
+                int* bestCost = nullptr);
 
         int computeSadOverBlock(
                 int minYL,
@@ -6,11 +6,15 @@
 
 #include "DisparityMapAlgorithmParameters.hpp"
 #include "DisparityMapGenerator.hpp"
+#include "GrayscaleConverter.hpp"
 
 #include <immintrin.h>
 
 class SingleThreadedSimdDisparityMapGenerator : public DisparityMapGenerator {
     public:
+        // The SAD masks one block row in a single 32-byte register.
+        static constexpr int MAX_BLOCK_SIZE = 31;
+
         SingleThreadedSimdDisparityMapGenerator(
             const DisparityMapAlgorithmParameters_t& parameters);
 
@@ -25,7 +29,23 @@ class SingleThreadedSimdDisparityMapGenerator : public DisparityMapGenerator {
             cv::Mat& disparity) override;
 
     private:
+        virtual bool beginSparseQuery() override;
+
+        virtual void computeDisparitySpan(
+            const cv::Mat& leftGray,
+            const cv::Mat& rightGray,
+            int y,
+            int minX,
+            int maxX,
+            float* disparities,
+            int* costs) override;
+
         DisparityMapAlgorithmParameters_t parameters_;
+
+        // Color input is converted into these before matching.
+        cv::Mat leftGrayImage_;
+        cv::Mat rightGrayImage_;
+
         std::vector<int> disparityBuf_;
 
         void ensureParametersValid();
@@ -33,7 +53,8 @@ class SingleThreadedSimdDisparityMapGenerator : public DisparityMapGenerator {
                 int y, 
                 int x, 
                 const cv::Mat& leftImage, 
-                const cv::Mat& rightImage);
+                const cv::Mat& rightImage,
+                int* bestCost = nullptr);
 
         int computeSadOverBlockSimd(
                 int minYL,
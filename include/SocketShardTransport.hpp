@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "GrayscaleConverter.hpp"
+#include "ShardTransport.hpp"
+
+// Streams the band headers and pixels over a connected socket.
+// Works over TCP, so workers can run on other machines.
+class SocketShardTransport : public ShardTransport {
+    public:
+        // Takes ownership of the connected socket.
+        SocketShardTransport(int socketFd);
+
+        virtual ~SocketShardTransport() override;
+
+        virtual void sendRequest(
+            const ShardRequest_t& request,
+            const cv::Mat& leftRows,
+            const cv::Mat& rightRows) override;
+
+        virtual void receiveResult(
+            ShardResult_t& result,
+            cv::Mat& disparityRows) override;
+
+        virtual bool receiveRequest(
+            ShardRequest_t& request,
+            cv::Mat& leftRows,
+            cv::Mat& rightRows) override;
+
+        virtual void sendResult(
+            const ShardResult_t& result,
+            const cv::Mat& disparityRows) override;
+
+        // Connects to a coordinator listening on host:port.
+        static int connectTo(const std::string& address);
+
+    private:
+        int socketFd_;
+
+        // Color input rows are converted into this before they are sent.
+        cv::Mat grayRows_;
+
+        void sendRows(const cv::Mat& rows);
+        void receiveRows(cv::Mat& rows);
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "GrayscaleConverter.hpp"
+
+// Rectifies stereo pairs using precomputed fixed-point remap tables.
+// The tables use the format produced by cv::initUndistortRectifyMap(..., CV_16SC2, map1, map2)
+//   or cv::convertMaps(..., CV_16SC2): map1 holds the integer source coordinates, and map2
+//   the fractional part as (fy << 5) | fx, with 5 fractional bits per axis.
+// Sampling is bilinear, and samples falling outside the source image read as 0,
+//   which matches cv::remap(INTER_LINEAR, BORDER_CONSTANT) to within one gray level.
+// BGR input is converted to luma sample by sample, so color frames need no separate conversion pass.
+// Rows can be rectified on their own, so that the matcher can rectify
+//   just the band it is about to read instead of whole frames.
+class StereoRectifier {
+    public:
+        StereoRectifier(
+            const cv::Mat& leftMap1,
+            const cv::Mat& leftMap2,
+            const cv::Mat& rightMap1,
+            const cv::Mat& rightMap2);
+
+        // Reads leftMap1, leftMap2, rightMap1 and rightMap2 from an OpenCV FileStorage file.
+        static StereoRectifier load(const std::string& path);
+
+        // Rectifies rows [minY, maxY) of the rectified left (or right) image into
+        //   destination, a buffer of (maxY - minY) rows of getWidth() bytes.
+        void rectifyLeftRows(const cv::Mat& image, int minY, int maxY, uint8_t* destination) const;
+        void rectifyRightRows(const cv::Mat& image, int minY, int maxY, uint8_t* destination) const;
+
+        // Size of the rectified images.
+        int getWidth() const;
+        int getHeight() const;
+
+    private:
+        static constexpr int INTER_BITS = 5;
+        static constexpr int INTER_TAB_SIZE = 1 << INTER_BITS;
+        static constexpr int INTER_MASK = INTER_TAB_SIZE - 1;
+
+        cv::Mat leftMap1_;
+        cv::Mat leftMap2_;
+        cv::Mat rightMap1_;
+        cv::Mat rightMap2_;
+
+        static void ensureMapsValid(const cv::Mat& map1, const cv::Mat& map2);
+
+        // Luma of one source pixel, or 0 outside the image.
+        static int samplePixel(const cv::Mat& image, int y, int x);
+
+        static void remapRows(
+            const cv::Mat& image,
+            const cv::Mat& map1,
+            const cv::Mat& map2,
+            int minY,
+            int maxY,
+            uint8_t* destination);
+};
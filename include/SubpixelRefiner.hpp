@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+#include <immintrin.h>
+
+enum class SubpixelInterpolation {
+    None,
+    Parabolic,
+    Equiangular
+};
+
+// Refines integer disparities to subpixel precision from the matching costs around each minimum.
+// Runs as a separate pass over a span of pixels, so that the search loop only tracks the
+//   integer argmin and the three costs around it.
+// Both fits subtract their offset from the disparity, matching the scalar fit the backends use.
+class SubpixelRefiner {
+    public:
+        // One of "none", "parabolic" or "equiangular".
+        static SubpixelInterpolation parse(const std::string& name);
+
+        // Refines disparities[0, count) in place.
+        // previousCosts, bestCosts and nextCosts hold the cost one step before the minimum, at it,
+        //   and one step after it. Pixels without both neighbours, or whose best cost is 0,
+        //   should have their previous and next costs set to 0, which leaves them unrefined.
+        static void refine(
+            SubpixelInterpolation interpolation,
+            int count,
+            float* disparities,
+            const int* previousCosts,
+            const int* bestCosts,
+            const int* nextCosts);
+
+    private:
+        static constexpr int SIMD_WIDTH = 8;
+
+        static void refineSimd(
+            SubpixelInterpolation interpolation,
+            float* disparities,
+            const int* previousCosts,
+            const int* bestCosts,
+            const int* nextCosts);
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <immintrin.h>
+
+// Compares each frame against a reference frame tile by tile.
+// The reference is only refreshed for tiles that are flagged as changed,
+//   so slow drift below the threshold eventually gets detected.
+class TileChangeDetector {
+    public:
+        TileChangeDetector(int tileSize, int changeThreshold);
+
+        void reset();
+
+        // Fills changedTiles (row-major, numTileRows x numTileCols) with 1 for changed tiles.
+        // Every tile is flagged on the first call, or when the image size changes.
+        void update(
+            const cv::Mat& image,
+            std::vector<uint8_t>& changedTiles);
+
+        int getNumTileRows() const;
+        int getNumTileCols() const;
+
+    private:
+        int tileSize_;
+        int changeThreshold_;
+        int numTileRows_ = 0;
+        int numTileCols_ = 0;
+        cv::Mat referenceImage_;
+
+        int computeTileSadSimd(
+            int minY,
+            int minX,
+            int width,
+            int height,
+            const cv::Mat& image);
+
+        void copyTile(
+            int minY,
+            int minX,
+            int width,
+            int height,
+            const cv::Mat& image);
+};
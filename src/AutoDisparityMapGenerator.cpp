@@ -0,0 +1,180 @@
+#include "../include/AutoDisparityMapGenerator.hpp"
+
+#include <omp.h>
+
+#include "../include/DisparityMapBackendRegistry.hpp"
+#include "../include/DisparityMapGeneratorFactory.hpp"
+
+// Sets the OpenMP thread count of the calling thread for one call.
+// The count is a per-thread setting, so other threads and later calls are unaffected.
+class ScopedOpenMpThreadCount {
+    public:
+        ScopedOpenMpThreadCount(int numThreads)
+                : previousNumThreads_(omp_get_max_threads()) {
+            if (numThreads > 0) {
+                omp_set_num_threads(numThreads);
+            }
+        }
+
+        ~ScopedOpenMpThreadCount() {
+            omp_set_num_threads(this->previousNumThreads_);
+        }
+
+    private:
+        int previousNumThreads_;
+};
+
+AutoDisparityMapGenerator::AutoDisparityMapGenerator(
+        const DisparityMapAlgorithmParameters_t& parameters)
+        : parameters_(parameters) {
+    this->loadConfigurations();
+}
+
+AutoDisparityMapGenerator::AutoDisparityMapGenerator(
+        const DisparityMapAlgorithmParameters_t& parameters,
+        const AutoTuneConfiguration_t& configuration)
+        : parameters_(parameters),
+          hasFixedConfiguration_(true),
+          fixedConfiguration_(configuration) {}
+
+void AutoDisparityMapGenerator::setParameters(
+        const DisparityMapAlgorithmParameters_t& parameters) {
+    bool pathChanged = (parameters.autoTuneConfigurationPath != this->parameters_.autoTuneConfigurationPath);
+    this->parameters_ = parameters;
+    if (pathChanged && (!this->hasFixedConfiguration_)) {
+        this->loadConfigurations();
+    }
+
+    // The best configuration depends on the parameters, so it is selected again on the next frame.
+    this->generator_.reset();
+}
+
+const DisparityMapAlgorithmParameters_t& AutoDisparityMapGenerator::getParameters() const {
+    return this->parameters_;
+}
+
+void AutoDisparityMapGenerator::computeDisparity(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        cv::Mat& disparity) {
+    this->ensureGenerator(leftImage);
+
+    ScopedOpenMpThreadCount threadCount(this->configuration_.numThreads);
+    this->generator_->computeDisparity(leftImage, rightImage, disparity);
+}
+
+void AutoDisparityMapGenerator::computeDisparityAt(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        const std::vector<cv::Point>& points,
+        std::vector<float>& disparities,
+        std::vector<int>* costs) {
+    this->ensureGenerator(leftImage);
+
+    ScopedOpenMpThreadCount threadCount(this->configuration_.numThreads);
+    this->generator_->computeDisparityAt(leftImage, rightImage, points, disparities, costs);
+}
+
+void AutoDisparityMapGenerator::computeDisparityAt(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        const std::vector<cv::Rect>& regions,
+        cv::Mat& disparity,
+        cv::Mat* costs) {
+    this->ensureGenerator(leftImage);
+
+    ScopedOpenMpThreadCount threadCount(this->configuration_.numThreads);
+    this->generator_->computeDisparityAt(leftImage, rightImage, regions, disparity, costs);
+}
+
+const AutoTuneConfiguration_t& AutoDisparityMapGenerator::getConfiguration() const {
+    return this->configuration_;
+}
+
+void AutoDisparityMapGenerator::loadConfigurations() {
+    this->configurations_ = AutoTuneConfigurations::load(
+        this->parameters_.autoTuneConfigurationPath.empty()
+            ? AutoTuneConfigurations::getDefaultPath()
+            : this->parameters_.autoTuneConfigurationPath);
+}
+
+void AutoDisparityMapGenerator::ensureGenerator(const cv::Mat& leftImage) {
+    if ((this->generator_ != nullptr)
+        &&
+        (this->configuration_.rows == leftImage.rows)
+        &&
+        (this->configuration_.cols == leftImage.cols)
+        &&
+        (this->configuration_.channels == leftImage.channels())) {
+        return;
+    }
+
+    AutoTuneConfiguration_t configuration = this->hasFixedConfiguration_
+        ? this->fixedConfiguration_
+        : this->configurations_.select(leftImage.rows, leftImage.cols, leftImage.channels(), this->parameters_);
+
+    // A tuned backend that is missing, unavailable or does not support the options
+    //   selects the fastest estimate that does.
+    DisparityMapBackendRegistry& registry = DisparityMapBackendRegistry::getInstance();
+    DisparityMapBackendInfo_t info;
+    std::string unsupportedReason;
+    if (!registry.find(configuration.algorithmName, info)) {
+        unsupportedReason = "The '" + configuration.algorithmName + "' algorithm is not registered.";
+    } else if (!DisparityMapBackendRegistry::isAvailable(info)) {
+        unsupportedReason = "This host lacks the instruction sets or devices of the '" + configuration.algorithmName + "' algorithm.";
+    } else {
+        unsupportedReason = DisparityMapBackendRegistry::checkSupport(info, this->parameters_, leftImage.type());
+    }
+
+    if (!unsupportedReason.empty()) {
+        // A fixed configuration is measured as given, so nothing may stand in for it.
+        if (this->hasFixedConfiguration_) {
+            throw std::runtime_error("Error: " + unsupportedReason);
+        }
+
+        configuration.algorithmName = registry.selectFastest(
+            this->parameters_,
+            leftImage.rows,
+            leftImage.cols,
+            leftImage.type()).name;
+    }
+
+    // The selection may come from another frame size. It is remembered under this one.
+    configuration.rows = leftImage.rows;
+    configuration.cols = leftImage.cols;
+    configuration.channels = leftImage.channels();
+
+    DisparityMapAlgorithmParameters_t generatorParameters(this->parameters_);
+    generatorParameters.algorithmName = configuration.algorithmName;
+    if (configuration.openMpStripHeight > 0) {
+        generatorParameters.openMpStripHeight = configuration.openMpStripHeight;
+    }
+
+    DisparityMapGeneratorFactory factory;
+    this->generator_ = factory.create(generatorParameters);
+    this->configuration_ = configuration;
+}
+
+static DisparityMapBackendInfo_t createBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "Auto";
+    info.description = "Runs the configuration AutoTune measured fastest, or the fastest estimate that supports the parameters.";
+    // Anything a backend supports, since it selects one that does.
+    // Except the cost volume, which is only reachable through the generator that fills it.
+    info.supportsRectification = true;
+    info.supportsPostProcessing = true;
+    info.supportsSubpixelInterpolation = true;
+    info.supportsIncremental = true;
+    info.supportsSparseQueries = true;
+    info.selectable = false;
+    // It may select a backend that is not.
+    info.reentrant = false;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<AutoDisparityMapGenerator>(parameters);
+    };
+    return info;
+}
+
+static DisparityMapBackendRegistration registration(createBackendInfo());
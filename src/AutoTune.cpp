@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "../include/AutoDisparityMapGenerator.hpp"
+#include "../include/AutoTuneConfigurations.hpp"
+#include "../include/DisparityMapAlgorithmParameters.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
+
+static const std::string ALL_ALGORITHM_NAMES =
+    "SingleThreadedSimd,OpenMP,OpenMPSimd,CUDA,CUDASimd,OpenCL,OpenCLVectorized,Hybrid";
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::stringstream stream(list);
+    std::vector<std::string> values;
+    std::string value;
+    while (std::getline(stream, value, ',')) {
+        if (!value.empty()) {
+            values.emplace_back(value);
+        }
+    }
+
+    return values;
+}
+
+std::vector<int> parseIntList(const std::string& list) {
+    std::vector<int> values;
+    for (const std::string& value : splitList(list)) {
+        values.push_back(std::stoi(value));
+    }
+
+    return values;
+}
+
+// Powers of two up to the OpenMP default, followed by the default itself.
+std::vector<int> getDefaultThreadCounts() {
+    int maxThreads = omp_get_max_threads();
+    std::vector<int> threadCounts;
+    for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2) {
+        threadCounts.push_back(numThreads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    return threadCounts;
+}
+
+// Only these run OpenMP on the calling thread, so only their thread count is tuned.
+bool usesOpenMp(const std::string& algorithmName) {
+    return (algorithmName == "OpenMP") || (algorithmName == "OpenMPSimd") || (algorithmName == "Hybrid");
+}
+
+// Mean wall-clock time of one frame, in milliseconds.
+double measureFrameTimeMs(
+        DisparityMapGenerator& generator,
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        cv::Mat& disparityImage,
+        int numWarmUpIterations,
+        int numIterations) {
+    for (int i = 0; i < numWarmUpIterations; i++) {
+        generator.computeDisparity(leftImage, rightImage, disparityImage);
+    }
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numIterations; i++) {
+        generator.computeDisparity(leftImage, rightImage, disparityImage);
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() / (1000.0 * numIterations);
+}
+
+int main(int argc, char** argv) {
+
+    const cv::String commandLineKeys =
+        "{help h usage ?    |              | This program finds the fastest configuration on this host for a frame size and parameters, and saves it for the Auto algorithm.}"
+        "{leftImage         |              | The left image to tune with. Without images, random images of rows x cols are used.}"
+        "{rightImage        |              | The right image to tune with.}"
+        "{rows              |          480 | The frame height, when no images are given.}"
+        "{cols              |          640 | The frame width, when no images are given.}"
+        "{colorInput        |        false | Tune for 3-channel BGR input.}"
+        "{blockSize         |            7 | The maximum block size to use for matching.}"
+        "{leftScanSteps     |           50 | The number of blocks to scan to the left.}"
+        "{rightScanSteps    |           50 | The number of blocks to scan to the right.}"
+        "{algorithmNames    |          all | The candidate algorithms, comma-separated. Algorithms that fail to run here are skipped.}"
+        "{threadCounts      |              | The candidate OpenMP thread counts, comma-separated. Defaults to powers of two up to the OpenMP default.}"
+        "{stripHeights      | 16,32,64,128 | The candidate OpenMPSimd strip heights, comma-separated. Only tuned for color input, which is matched in strips.}"
+        "{numIterations     |           20 | The number of timed frames per candidate.}"
+        "{warmUpIterations  |            5 | The number of untimed frames per candidate.}"
+        "{configurationPath |              | The file to which to save the winner. Defaults to AutoTuneConfigurations::getDefaultPath().}";
+
+    cv::CommandLineParser parser(argc, argv, commandLineKeys);
+
+    if (!parser.check()) {
+        parser.printMessage();
+        parser.printErrors();
+        return 1;
+    }
+
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 1;
+    }
+
+    DisparityMapAlgorithmParameters_t parameters;
+    parameters.blockSize = parser.get<int>("blockSize");
+    parameters.leftScanSteps = parser.get<int>("leftScanSteps");
+    parameters.rightScanSteps = parser.get<int>("rightScanSteps");
+    parameters.leftImageFilePath = std::string(parser.get<cv::String>("leftImage"));
+    parameters.rightImageFilePath = std::string(parser.get<cv::String>("rightImage"));
+    bool colorInput = parser.get<bool>("colorInput");
+    std::string algorithmNamesStr = std::string(parser.get<cv::String>("algorithmNames"));
+    std::string threadCountsStr = std::string(parser.get<cv::String>("threadCounts"));
+    std::string stripHeightsStr = std::string(parser.get<cv::String>("stripHeights"));
+    int numIterations = parser.get<int>("numIterations");
+    int numWarmUpIterations = parser.get<int>("warmUpIterations");
+    std::string configurationPath = std::string(parser.get<cv::String>("configurationPath"));
+    if (configurationPath.empty()) {
+        configurationPath = AutoTuneConfigurations::getDefaultPath();
+    }
+
+    cv::Mat leftImage;
+    cv::Mat rightImage;
+    int imreadFlags = colorInput ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
+    if ((!parameters.leftImageFilePath.empty()) && (!parameters.rightImageFilePath.empty())) {
+        leftImage = cv::imread(parameters.leftImageFilePath, imreadFlags);
+        rightImage = cv::imread(parameters.rightImageFilePath, imreadFlags);
+
+        if ((leftImage.rows == 0)
+                ||
+            (leftImage.cols == 0)
+                ||
+            (leftImage.rows != rightImage.rows)
+                ||
+            (leftImage.cols != rightImage.cols)) {
+            throw std::runtime_error("Error. The input images are empty or not the same size.");
+        }
+    } else {
+        // Matching cost does not depend on the content, so random images time the same as real ones.
+        int rows = parser.get<int>("rows");
+        int cols = parser.get<int>("cols");
+        int type = colorInput ? CV_8UC3 : CV_8UC1;
+        leftImage = cv::Mat(rows, cols, type);
+        rightImage = cv::Mat(rows, cols, type);
+
+        std::mt19937 generator(1);
+        std::uniform_int_distribution<int> pixelDistribution(0, 255);
+        size_t numBytes = static_cast<size_t>(rows) * cols * leftImage.channels();
+        for (size_t i = 0; i < numBytes; i++) {
+            leftImage.data[i] = static_cast<uint8_t>(pixelDistribution(generator));
+            rightImage.data[i] = static_cast<uint8_t>(pixelDistribution(generator));
+        }
+    }
+
+    std::vector<std::string> algorithmNames = splitList(
+        (algorithmNamesStr == "all") ? ALL_ALGORITHM_NAMES : algorithmNamesStr);
+    std::vector<int> threadCounts = threadCountsStr.empty()
+        ? getDefaultThreadCounts()
+        : parseIntList(threadCountsStr);
+    std::vector<int> stripHeights = parseIntList(stripHeightsStr);
+
+    std::cout << "Tuning with the following parameters:" << std::endl;
+    std::cout << "\tImage Size: (" << leftImage.rows << "x" << leftImage.cols << "x" << leftImage.channels() << ")." << std::endl;
+    std::cout << "\tBlock Size: " << parameters.blockSize << "." << std::endl;
+    std::cout << "\tLeft Scan Steps: " << parameters.leftScanSteps << "." << std::endl;
+    std::cout << "\tRight Scan Steps: " << parameters.rightScanSteps << "." << std::endl;
+    std::cout << "\tCandidate Algorithms: " << algorithmNamesStr << "." << std::endl;
+    std::cout << "\tConfiguration Path: " << configurationPath << "." << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    cv::Mat disparityImage(leftImage.rows, leftImage.cols, CV_32FC1);
+    AutoTuneConfiguration_t best;
+    best.frameTimeMs = std::numeric_limits<double>::max();
+
+    for (const std::string& algorithmName : algorithmNames) {
+        // Algorithms that cannot run here are skipped, rather than timed as whatever Auto would select instead.
+        DisparityMapBackendInfo_t info;
+        std::string skipReason;
+        if (!DisparityMapBackendRegistry::getInstance().find(algorithmName, info)) {
+            skipReason = "not registered";
+        } else if (!DisparityMapBackendRegistry::isAvailable(info)) {
+            skipReason = "this host lacks its instruction sets or devices";
+        } else {
+            skipReason = DisparityMapBackendRegistry::checkSupport(info, parameters, leftImage.type());
+        }
+
+        if (!skipReason.empty()) {
+            std::cout << "\t" << algorithmName << ": SKIPPED (" << skipReason << ")" << std::endl;
+            continue;
+        }
+
+        // A strip height of 0 is not tuned, and keeps the caller's.
+        std::vector<int> candidateThreadCounts = usesOpenMp(algorithmName) ? threadCounts : std::vector<int>(1, 0);
+        std::vector<int> candidateStripHeights = ((algorithmName == "OpenMPSimd") && colorInput)
+            ? stripHeights
+            : std::vector<int>(1, 0);
+
+        for (int numThreads : candidateThreadCounts) {
+            for (int stripHeight : candidateStripHeights) {
+                AutoTuneConfiguration_t candidate;
+                candidate.rows = leftImage.rows;
+                candidate.cols = leftImage.cols;
+                candidate.channels = leftImage.channels();
+                candidate.blockSize = parameters.blockSize;
+                candidate.leftScanSteps = parameters.leftScanSteps;
+                candidate.rightScanSteps = parameters.rightScanSteps;
+                candidate.algorithmName = algorithmName;
+                candidate.numThreads = numThreads;
+                candidate.openMpStripHeight = stripHeight;
+
+                std::cout << "\t" << algorithmName;
+                if (numThreads > 0) {
+                    std::cout << ", " << numThreads << " threads";
+                }
+                if (candidateStripHeights.size() > 1) {
+                    std::cout << ", strip height " << stripHeight;
+                }
+                std::cout << ": " << std::flush;
+
+                // Candidates are run exactly as the Auto algorithm would run them.
+                try {
+                    AutoDisparityMapGenerator generator(parameters, candidate);
+                    candidate.frameTimeMs = measureFrameTimeMs(
+                        generator,
+                        leftImage,
+                        rightImage,
+                        disparityImage,
+                        numWarmUpIterations,
+                        numIterations);
+                } catch (const std::exception& e) {
+                    std::cout << "SKIPPED (" << e.what() << ")" << std::endl;
+                    continue;
+                }
+
+                std::cout << candidate.frameTimeMs << " ms" << std::endl;
+                if (candidate.frameTimeMs < best.frameTimeMs) {
+                    best = candidate;
+                }
+            }
+        }
+    }
+
+    if (best.frameTimeMs == std::numeric_limits<double>::max()) {
+        throw std::runtime_error("Error. None of the candidate algorithms could run.");
+    }
+
+    std::cout << "Fastest: " << best.algorithmName;
+    if (best.numThreads > 0) {
+        std::cout << " with " << best.numThreads << " threads";
+    }
+    if (best.openMpStripHeight > 0) {
+        std::cout << ", strip height " << best.openMpStripHeight;
+    }
+    std::cout << ", " << best.frameTimeMs << " ms." << std::endl;
+
+    AutoTuneConfigurations configurations = AutoTuneConfigurations::load(configurationPath);
+    configurations.set(best);
+    configurations.save(configurationPath);
+
+    std::cout << "Saved to " << configurationPath << "." << std::endl;
+
+    return 0;
+}
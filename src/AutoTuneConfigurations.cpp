@@ -0,0 +1,158 @@
+#include "../include/AutoTuneConfigurations.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <opencv2/core.hpp>
+
+#include "../include/CacheDirectory.hpp"
+
+static void createParentDirectories(const std::string& path) {
+    for (size_t i = 1; i < path.size(); i++) {
+        if (path[i] == '/') {
+            mkdir(path.substr(0, i).c_str(), 0755);
+        }
+    }
+}
+
+AutoTuneConfigurations AutoTuneConfigurations::load(const std::string& path) {
+    AutoTuneConfigurations configurations;
+    if (access(path.c_str(), F_OK) != 0) {
+        return configurations;
+    }
+
+    cv::FileStorage storage(path, cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw std::runtime_error("Error: could not open autotune configurations '" + path + "'.");
+    }
+
+    cv::FileNode entries = storage["configurations"];
+    for (cv::FileNodeIterator it = entries.begin(); it != entries.end(); ++it) {
+        const cv::FileNode& entry = *it;
+
+        AutoTuneConfiguration_t configuration;
+        configuration.rows = static_cast<int>(entry["rows"]);
+        configuration.cols = static_cast<int>(entry["cols"]);
+        configuration.channels = static_cast<int>(entry["channels"]);
+        configuration.blockSize = static_cast<int>(entry["blockSize"]);
+        configuration.leftScanSteps = static_cast<int>(entry["leftScanSteps"]);
+        configuration.rightScanSteps = static_cast<int>(entry["rightScanSteps"]);
+        configuration.algorithmName = static_cast<std::string>(entry["algorithmName"]);
+        configuration.numThreads = static_cast<int>(entry["numThreads"]);
+        configuration.openMpStripHeight = static_cast<int>(entry["openMpStripHeight"]);
+        configuration.frameTimeMs = static_cast<double>(entry["frameTimeMs"]);
+        configurations.configurations_.emplace_back(configuration);
+    }
+
+    return configurations;
+}
+
+void AutoTuneConfigurations::save(const std::string& path) const {
+    createParentDirectories(path);
+
+    cv::FileStorage storage(path, cv::FileStorage::WRITE);
+    if (!storage.isOpened()) {
+        throw std::runtime_error("Error: could not write autotune configurations '" + path + "'.");
+    }
+
+    storage << "configurations" << "[";
+    for (const AutoTuneConfiguration_t& configuration : this->configurations_) {
+        storage << "{"
+            << "rows" << configuration.rows
+            << "cols" << configuration.cols
+            << "channels" << configuration.channels
+            << "blockSize" << configuration.blockSize
+            << "leftScanSteps" << configuration.leftScanSteps
+            << "rightScanSteps" << configuration.rightScanSteps
+            << "algorithmName" << configuration.algorithmName
+            << "numThreads" << configuration.numThreads
+            << "openMpStripHeight" << configuration.openMpStripHeight
+            << "frameTimeMs" << configuration.frameTimeMs
+            << "}";
+    }
+    storage << "]";
+
+    storage.release();
+}
+
+void AutoTuneConfigurations::set(const AutoTuneConfiguration_t& configuration) {
+    for (AutoTuneConfiguration_t& existing : this->configurations_) {
+        if ((existing.rows == configuration.rows)
+            &&
+            (existing.cols == configuration.cols)
+            &&
+            (existing.channels == configuration.channels)
+            &&
+            (existing.blockSize == configuration.blockSize)
+            &&
+            (existing.leftScanSteps == configuration.leftScanSteps)
+            &&
+            (existing.rightScanSteps == configuration.rightScanSteps)) {
+            existing = configuration;
+            return;
+        }
+    }
+
+    this->configurations_.emplace_back(configuration);
+}
+
+AutoTuneConfiguration_t AutoTuneConfigurations::select(
+        int rows,
+        int cols,
+        int channels,
+        const DisparityMapAlgorithmParameters_t& parameters) const {
+    // Frames of a similar size favour the same backend, since launch and transfer overheads
+    //   are amortized over a similar number of pixels.
+    const AutoTuneConfiguration_t* closest = nullptr;
+    double closestDistance = std::numeric_limits<double>::max();
+    double numPixels = static_cast<double>(rows) * cols;
+
+    for (const AutoTuneConfiguration_t& configuration : this->configurations_) {
+        if (!hasSameParameters(configuration, channels, parameters)) {
+            continue;
+        }
+
+        double distance = std::abs(std::log((static_cast<double>(configuration.rows) * configuration.cols) / numPixels));
+        if ((configuration.rows == rows) && (configuration.cols == cols)) {
+            return configuration;
+        } else if (distance < closestDistance) {
+            closest = &configuration;
+            closestDistance = distance;
+        }
+    }
+
+    if (closest != nullptr) {
+        return *closest;
+    }
+
+    AutoTuneConfiguration_t configuration;
+    configuration.rows = rows;
+    configuration.cols = cols;
+    configuration.channels = channels;
+    configuration.blockSize = parameters.blockSize;
+    configuration.leftScanSteps = parameters.leftScanSteps;
+    configuration.rightScanSteps = parameters.rightScanSteps;
+    return configuration;
+}
+
+const std::vector<AutoTuneConfiguration_t>& AutoTuneConfigurations::getConfigurations() const {
+    return this->configurations_;
+}
+
+std::string AutoTuneConfigurations::getDefaultPath() {
+    std::string directory = CacheDirectory::getDefault();
+    return directory.empty() ? std::string("autotune.yml") : (directory + "/autotune.yml");
+}
+
+bool AutoTuneConfigurations::hasSameParameters(
+        const AutoTuneConfiguration_t& configuration,
+        int channels,
+        const DisparityMapAlgorithmParameters_t& parameters) {
+    return (configuration.channels == channels)
+        && (configuration.blockSize == parameters.blockSize)
+        && (configuration.leftScanSteps == parameters.leftScanSteps)
+        && (configuration.rightScanSteps == parameters.rightScanSteps);
+}
@@ -0,0 +1,17 @@
+#include "../include/CacheDirectory.hpp"
+
+#include <cstdlib>
+
+std::string CacheDirectory::getDefault() {
+    const char* xdgCacheHome = getenv("XDG_CACHE_HOME");
+    if ((xdgCacheHome != nullptr) && (xdgCacheHome[0] != '\0')) {
+        return std::string(xdgCacheHome) + "/StereoVisionMultiWay";
+    }
+
+    const char* home = getenv("HOME");
+    if ((home != nullptr) && (home[0] != '\0')) {
+        return std::string(home) + "/.cache/StereoVisionMultiWay";
+    }
+
+    return std::string();
+}
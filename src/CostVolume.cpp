@@ -0,0 +1,92 @@
+#include "../include/CostVolume.hpp"
+
+#include <algorithm>
+#include <string>
+
+void CostVolume::configure(
+        int rows,
+        int cols,
+        int leftScanSteps,
+        int rightScanSteps,
+        int windowRows) {
+    if ((rows < 0) || (cols < 0) || (leftScanSteps < 0) || (rightScanSteps < 0)) {
+        throw std::runtime_error("Error: the cost volume dimensions are negative.");
+    }
+
+    if (windowRows < 0) {
+        throw std::runtime_error("Error: the cost volume window is negative.");
+    }
+
+    this->rows_ = rows;
+    this->cols_ = cols;
+    this->numDisparities_ = leftScanSteps + rightScanSteps + 1;
+    this->leftScanSteps_ = leftScanSteps;
+    this->windowRows_ = windowRows;
+    this->numSlots_ = std::max(1, (windowRows > 0) ? std::min(windowRows, rows) : rows);
+
+    size_t elementsPerLine = ALIGNMENT / sizeof(uint16_t);
+    size_t rowElements = static_cast<size_t>(cols) * this->numDisparities_;
+    this->rowStride_ = ((rowElements + elementsPerLine - 1) / elementsPerLine) * elementsPerLine;
+
+    // resize() keeps the capacity, so a smaller frame reuses the buffer.
+    this->data_.resize(this->rowStride_ * this->numSlots_);
+    this->maxAvailableRow_ = 0;
+}
+
+int CostVolume::getRows() const {
+    return this->rows_;
+}
+
+int CostVolume::getCols() const {
+    return this->cols_;
+}
+
+int CostVolume::getNumDisparities() const {
+    return this->numDisparities_;
+}
+
+int CostVolume::getLeftScanSteps() const {
+    return this->leftScanSteps_;
+}
+
+int CostVolume::getWindowRows() const {
+    return this->windowRows_;
+}
+
+size_t CostVolume::getRowStride() const {
+    return this->rowStride_;
+}
+
+int CostVolume::getMinAvailableRow() const {
+    return std::max(0, this->maxAvailableRow_ - this->numSlots_);
+}
+
+int CostVolume::getMaxAvailableRow() const {
+    return this->maxAvailableRow_;
+}
+
+bool CostVolume::hasRow(int y) const {
+    return (y >= this->getMinAvailableRow()) && (y < this->maxAvailableRow_);
+}
+
+const uint16_t* CostVolume::getRow(int y) const {
+    if (!this->hasRow(y)) {
+        throw std::runtime_error("Error: row "
+            + std::to_string(y)
+            + " is not in the cost volume, which holds rows ["
+            + std::to_string(this->getMinAvailableRow())
+            + ", "
+            + std::to_string(this->maxAvailableRow_)
+            + ").");
+    }
+
+    return this->data_.data() + (this->getSlot(y) * this->rowStride_);
+}
+
+void CostVolume::beginFrame() {
+    this->maxAvailableRow_ = 0;
+}
+
+void CostVolume::setRowsComplete(int maxY) {
+    this->maxAvailableRow_ = maxY;
+}
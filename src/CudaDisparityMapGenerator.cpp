@@ -1,5 +1,6 @@
 #include "../include/CudaDisparityMapGenerator.hpp"
 #include "../include/CudaFunctions.h"
+#include "../include/DisparityMapBackendRegistry.hpp"
 
 #include <iostream>
 
@@ -29,15 +30,18 @@ void CudaDisparityMapGenerator::computeDisparity(
         const cv::Mat& leftImage,
         const cv::Mat& rightImage,
         cv::Mat& disparity) {
+    // Color input is converted on the host, before upload.
+    const cv::Mat& leftGray = GrayscaleConverter::ensureGray(leftImage, this->leftGrayImage_);
+    const cv::Mat& rightGray = GrayscaleConverter::ensureGray(rightImage, this->rightGrayImage_);
 
     computeDisparityCuda(
-        leftImage.rows,
-        leftImage.cols,
+        leftGray.rows,
+        leftGray.cols,
         this->parameters_.blockSize,
         this->parameters_.leftScanSteps,
         this->parameters_.rightScanSteps,
-        leftImage.data,
-        rightImage.data,
+        leftGray.data,
+        rightGray.data,
         reinterpret_cast<float*>(disparity.data));
 }
 
@@ -57,5 +61,31 @@ void CudaDisparityMapGenerator::ensureParametersValid() {
     if (this->parameters_.rightScanSteps < 0) {
         throw std::runtime_error("Error: right scan steps is negative.");
     }
+
+    int disparityRange = this->parameters_.leftScanSteps + this->parameters_.rightScanSteps + 1;
+    if (disparityRange > MAX_DISPARITY_RANGE) {
+        throw std::runtime_error("Error: a disparity range of " + std::to_string(disparityRange) + " is larger than the supported " + std::to_string(MAX_DISPARITY_RANGE) + ".");
+    }
+}
+
+static DisparityMapBackendInfo_t createBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "CUDA";
+    info.description = "Scalar CUDA kernel, one thread per pixel.";
+    info.requiredDevices = { "cuda" };
+    info.isDeviceAvailable = []() { return getCudaDeviceCount() > 0; };
+    // The kernel keeps the costs of a pixel in a fixed array.
+    info.maxDisparityRange = CudaDisparityMapGenerator::MAX_DISPARITY_RANGE;
+    // The device buffers are shared by every instance.
+    info.reentrant = false;
+    info.fixedCostMs = 2.0;
+    info.nanosecondsPerComparison = 0.01;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<CudaDisparityMapGenerator>(parameters);
+    };
+    return info;
 }
 
+static DisparityMapBackendRegistration registration(createBackendInfo());
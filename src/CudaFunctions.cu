@@ -135,6 +135,15 @@ static uint8_t* leftCudaData = NULL;
 static uint8_t* rightCudaData = NULL;
 static float* disparityCudaData = NULL;
 
+int getCudaDeviceCount() {
+    int numDevices = 0;
+    if (cudaGetDeviceCount(&numDevices) != cudaSuccess) {
+        return 0;
+    }
+
+    return numDevices;
+}
+
 void destroyCudaMemoryBuffers() {
     if (leftCudaData != NULL) {
         cudaFree(leftCudaData);
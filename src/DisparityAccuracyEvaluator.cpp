@@ -0,0 +1,176 @@
+#include "../include/DisparityAccuracyEvaluator.hpp"
+
+#include <cmath>
+#include <sstream>
+
+DisparityAccuracyEvaluator::DisparityAccuracyEvaluator(
+        const cv::Mat& leftGroundTruth,
+        const cv::Mat& rightGroundTruth,
+        float scale,
+        const std::vector<float>& thresholds)
+        : thresholds_(thresholds) {
+    if (scale <= 0) {
+        throw std::runtime_error("Error: the ground truth scale must be positive.");
+    }
+
+    if (leftGroundTruth.empty()) {
+        throw std::runtime_error("Error: the ground truth is empty.");
+    }
+
+    if ((!rightGroundTruth.empty())
+        &&
+        ((rightGroundTruth.rows != leftGroundTruth.rows) || (rightGroundTruth.cols != leftGroundTruth.cols))) {
+        throw std::runtime_error("Error: the left and right ground truth are not the same size.");
+    }
+
+    this->groundTruth_ = toDisparity(leftGroundTruth, scale);
+    cv::Mat rightDisparity = rightGroundTruth.empty() ? cv::Mat() : toDisparity(rightGroundTruth, scale);
+
+    this->regions_ = cv::Mat(leftGroundTruth.rows, leftGroundTruth.cols, CV_8UC1);
+    for (int y = 0; y < this->groundTruth_.rows; y++) {
+        const float* groundTruthRow = this->groundTruth_.ptr<float>(y);
+        uint8_t* regionRow = this->regions_.ptr<uint8_t>(y);
+
+        for (int x = 0; x < this->groundTruth_.cols; x++) {
+            float d = groundTruthRow[x];
+            if (d == 0) {
+                regionRow[x] = UNKNOWN;
+                continue;
+            }
+
+            if (rightDisparity.empty()) {
+                regionRow[x] = NON_OCCLUDED;
+                continue;
+            }
+
+            // A visible pixel lands on a right pixel that agrees on its disparity.
+            int rightX = static_cast<int>(std::lround(x - d));
+            float rightD = (rightX >= 0) ? rightDisparity.ptr<float>(y)[rightX] : 0;
+            regionRow[x] = ((rightD != 0) && (std::abs(rightD - d) <= OCCLUSION_TOLERANCE))
+                ? NON_OCCLUDED
+                : OCCLUDED;
+        }
+    }
+}
+
+std::vector<float> DisparityAccuracyEvaluator::parseThresholds(const std::string& thresholds) {
+    std::vector<float> values;
+    std::stringstream stream(thresholds);
+    std::string value;
+    while (std::getline(stream, value, ',')) {
+        try {
+            values.push_back(std::stof(value));
+        } catch (const std::exception&) {
+            throw std::runtime_error("Error: could not parse accuracy threshold '" + value + "'.");
+        }
+
+        if (values.back() <= 0) {
+            throw std::runtime_error("Error: accuracy thresholds must be positive.");
+        }
+    }
+
+    if (values.empty()) {
+        throw std::runtime_error("Error: no accuracy thresholds were given.");
+    }
+
+    return values;
+}
+
+const std::vector<float>& DisparityAccuracyEvaluator::getThresholds() const {
+    return this->thresholds_;
+}
+
+DisparityAccuracy_t DisparityAccuracyEvaluator::evaluate(const cv::Mat& disparity) const {
+    if ((disparity.type() != CV_32FC1)
+        ||
+        (disparity.rows != this->groundTruth_.rows)
+        ||
+        (disparity.cols != this->groundTruth_.cols)) {
+        throw std::runtime_error("Error: the disparity does not match the size of the ground truth.");
+    }
+
+    int numThresholds = static_cast<int>(this->thresholds_.size());
+    std::vector<int> nonOccludedBadPixels(numThresholds, 0);
+    std::vector<int> allBadPixels(numThresholds, 0);
+    double nonOccludedAbsoluteError = 0;
+    double nonOccludedSquaredError = 0;
+    double allAbsoluteError = 0;
+    double allSquaredError = 0;
+
+    DisparityAccuracy_t accuracy;
+
+    for (int y = 0; y < disparity.rows; y++) {
+        const float* disparityRow = disparity.ptr<float>(y);
+        const float* groundTruthRow = this->groundTruth_.ptr<float>(y);
+        const uint8_t* regionRow = this->regions_.ptr<uint8_t>(y);
+
+        for (int x = 0; x < disparity.cols; x++) {
+            if (regionRow[x] == UNKNOWN) {
+                continue;
+            }
+
+            double error = std::abs(static_cast<double>(disparityRow[x]) - groundTruthRow[x]);
+            bool nonOccluded = (regionRow[x] == NON_OCCLUDED);
+
+            accuracy.all.numPixels++;
+            allAbsoluteError += error;
+            allSquaredError += error * error;
+            if (nonOccluded) {
+                accuracy.nonOccluded.numPixels++;
+                nonOccludedAbsoluteError += error;
+                nonOccludedSquaredError += error * error;
+            }
+
+            for (int i = 0; i < numThresholds; i++) {
+                if (error > this->thresholds_[i]) {
+                    allBadPixels[i]++;
+                    if (nonOccluded) {
+                        nonOccludedBadPixels[i]++;
+                    }
+                }
+            }
+        }
+    }
+
+    this->finishRegion(accuracy.nonOccluded, nonOccludedBadPixels, nonOccludedAbsoluteError, nonOccludedSquaredError);
+    this->finishRegion(accuracy.all, allBadPixels, allAbsoluteError, allSquaredError);
+
+    return accuracy;
+}
+
+cv::Mat DisparityAccuracyEvaluator::toDisparity(const cv::Mat& groundTruth, float scale) {
+    if ((groundTruth.type() != CV_8UC1) && (groundTruth.type() != CV_16UC1)) {
+        throw std::runtime_error("Error: ground truth must be a single channel 8 or 16 bit image.");
+    }
+
+    cv::Mat disparity(groundTruth.rows, groundTruth.cols, CV_32FC1);
+    for (int y = 0; y < groundTruth.rows; y++) {
+        float* disparityRow = disparity.ptr<float>(y);
+        for (int x = 0; x < groundTruth.cols; x++) {
+            float value = (groundTruth.type() == CV_8UC1)
+                ? groundTruth.ptr<uint8_t>(y)[x]
+                : groundTruth.ptr<uint16_t>(y)[x];
+            disparityRow[x] = value / scale;
+        }
+    }
+
+    return disparity;
+}
+
+void DisparityAccuracyEvaluator::finishRegion(
+        DisparityRegionAccuracy_t& region,
+        const std::vector<int>& numBadPixels,
+        double sumAbsoluteError,
+        double sumSquaredError) const {
+    region.badPixelPercentages.resize(numBadPixels.size(), 0);
+    if (region.numPixels == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < numBadPixels.size(); i++) {
+        region.badPixelPercentages[i] = 100.0 * numBadPixels[i] / region.numPixels;
+    }
+
+    region.meanAbsoluteError = sumAbsoluteError / region.numPixels;
+    region.rootMeanSquaredError = std::sqrt(sumSquaredError / region.numPixels);
+}
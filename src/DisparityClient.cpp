@@ -0,0 +1,195 @@
+#include "../include/DisparityClient.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+DisparityClient::DisparityClient(const std::string& socketPath) {
+    struct sockaddr_un address;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Error: socket path '" + socketPath + "' is too long.");
+    }
+
+    this->socketFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (this->socketFd_ < 0) {
+        throw std::runtime_error("Error: could not create a socket: " + std::string(strerror(errno)) + ".");
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    DisparityServiceProtocol::copyString(socketPath, address.sun_path, sizeof(address.sun_path));
+
+    if (connect(this->socketFd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        ::close(this->socketFd_);
+        throw std::runtime_error("Error: could not connect to the disparity service at '" + socketPath + "': " + std::string(strerror(error)) + ".");
+    }
+}
+
+DisparityClient::~DisparityClient() {
+    try {
+        this->close();
+    } catch (const std::exception&) {
+    }
+
+    ::close(this->socketFd_);
+}
+
+void DisparityClient::open(
+        const DisparityMapAlgorithmParameters_t& parameters,
+        int width,
+        int height,
+        int numSlots) {
+    if (this->sharedMemory_ != nullptr) {
+        throw std::runtime_error("Error: the disparity client is already open.");
+    }
+
+    DisparityServiceMessage_t request;
+    memset(&request, 0, sizeof(request));
+    request.type = static_cast<uint32_t>(DisparityServiceMessageType::Open);
+    request.width = width;
+    request.height = height;
+    request.numSlots = numSlots;
+    request.blockSize = parameters.blockSize;
+    request.leftScanSteps = parameters.leftScanSteps;
+    request.rightScanSteps = parameters.rightScanSteps;
+    DisparityServiceProtocol::copyString(parameters.algorithmName, request.algorithmName, sizeof(request.algorithmName));
+    DisparityServiceProtocol::sendMessage(this->socketFd_, request);
+
+    DisparityServiceMessage_t reply;
+    int sharedMemoryFd;
+    this->receiveReply(reply, &sharedMemoryFd);
+
+    if ((reply.type != static_cast<uint32_t>(DisparityServiceMessageType::Opened)) || (sharedMemoryFd < 0)) {
+        if (sharedMemoryFd >= 0) {
+            ::close(sharedMemoryFd);
+        }
+
+        throw std::runtime_error("Error: the disparity service did not send shared memory.");
+    }
+
+    this->layout_ = DisparityServiceProtocol::computeSlotLayout(width, height);
+    this->sharedMemorySize_ = this->layout_.slotSize * numSlots;
+
+    void* mapping = mmap(nullptr, this->sharedMemorySize_, PROT_READ | PROT_WRITE, MAP_SHARED, sharedMemoryFd, 0);
+    ::close(sharedMemoryFd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Error: could not map shared memory: " + std::string(strerror(errno)) + ".");
+    }
+
+    this->sharedMemory_ = static_cast<uint8_t*>(mapping);
+    this->width_ = width;
+    this->height_ = height;
+    this->numSlots_ = numSlots;
+    this->oldestSlot_ = 0;
+    this->numSlotsAcquired_ = 0;
+    this->numSlotsSubmitted_ = 0;
+}
+
+void DisparityClient::close() {
+    if (this->sharedMemory_ == nullptr) {
+        return;
+    }
+
+    munmap(this->sharedMemory_, this->sharedMemorySize_);
+    this->sharedMemory_ = nullptr;
+
+    DisparityServiceMessage_t request;
+    memset(&request, 0, sizeof(request));
+    request.type = static_cast<uint32_t>(DisparityServiceMessageType::Close);
+    DisparityServiceProtocol::sendMessage(this->socketFd_, request);
+}
+
+int DisparityClient::acquireSlot(cv::Mat& leftImage, cv::Mat& rightImage) {
+    if (this->sharedMemory_ == nullptr) {
+        throw std::runtime_error("Error: the disparity client is not open.");
+    }
+
+    if (this->numSlotsAcquired_ >= this->numSlots_) {
+        throw std::runtime_error("Error: all slots are in flight. Wait for a disparity first.");
+    }
+
+    int slot = (this->oldestSlot_ + this->numSlotsAcquired_) % this->numSlots_;
+    this->numSlotsAcquired_++;
+
+    uint8_t* slotData = this->sharedMemory_ + (this->layout_.slotSize * slot);
+    leftImage = cv::Mat(this->height_, this->width_, CV_8UC1, slotData + this->layout_.leftImageOffset);
+    rightImage = cv::Mat(this->height_, this->width_, CV_8UC1, slotData + this->layout_.rightImageOffset);
+    return slot;
+}
+
+void DisparityClient::submit(int slot) {
+    int expectedSlot = (this->oldestSlot_ + this->numSlotsSubmitted_) % this->numSlots_;
+    if ((this->numSlotsSubmitted_ >= this->numSlotsAcquired_) || (slot != expectedSlot)) {
+        throw std::runtime_error("Error: slots must be submitted in the order they were acquired.");
+    }
+
+    DisparityServiceMessage_t request;
+    memset(&request, 0, sizeof(request));
+    request.type = static_cast<uint32_t>(DisparityServiceMessageType::Submit);
+    request.slot = slot;
+    DisparityServiceProtocol::sendMessage(this->socketFd_, request);
+
+    this->numSlotsSubmitted_++;
+}
+
+int DisparityClient::waitForDisparity(cv::Mat& disparity, double* computeTimeMs) {
+    if (this->numSlotsSubmitted_ == 0) {
+        throw std::runtime_error("Error: no slots have been submitted.");
+    }
+
+    DisparityServiceMessage_t reply;
+    if (!DisparityServiceProtocol::receiveMessage(this->socketFd_, reply)) {
+        throw std::runtime_error("Error: the disparity service closed the connection.");
+    }
+
+    // A failed frame still frees its slot, so that the ring stays usable.
+    if ((reply.type == static_cast<uint32_t>(DisparityServiceMessageType::Error))
+        &&
+        (reply.slot == this->oldestSlot_)) {
+        this->oldestSlot_ = (this->oldestSlot_ + 1) % this->numSlots_;
+        this->numSlotsAcquired_--;
+        this->numSlotsSubmitted_--;
+    }
+
+    if (reply.type == static_cast<uint32_t>(DisparityServiceMessageType::Error)) {
+        reply.errorMessage[sizeof(reply.errorMessage) - 1] = '\0';
+        throw std::runtime_error(std::string(reply.errorMessage));
+    }
+
+    if ((reply.type != static_cast<uint32_t>(DisparityServiceMessageType::Completed))
+        ||
+        (reply.slot != this->oldestSlot_)) {
+        throw std::runtime_error("Error: unexpected reply from the disparity service.");
+    }
+
+    if (computeTimeMs != nullptr) {
+        *computeTimeMs = reply.computeTimeMs;
+    }
+
+    uint8_t* slotData = this->sharedMemory_ + (this->layout_.slotSize * reply.slot);
+    disparity = cv::Mat(this->height_, this->width_, CV_32FC1, slotData + this->layout_.disparityOffset);
+
+    this->oldestSlot_ = (this->oldestSlot_ + 1) % this->numSlots_;
+    this->numSlotsAcquired_--;
+    this->numSlotsSubmitted_--;
+    return reply.slot;
+}
+
+int DisparityClient::getNumSlotsInFlight() const {
+    return this->numSlotsSubmitted_;
+}
+
+void DisparityClient::receiveReply(DisparityServiceMessage_t& reply, int* fileDescriptor) {
+    if (!DisparityServiceProtocol::receiveMessage(this->socketFd_, reply, fileDescriptor)) {
+        throw std::runtime_error("Error: the disparity service closed the connection.");
+    }
+
+    if (reply.type == static_cast<uint32_t>(DisparityServiceMessageType::Error)) {
+        reply.errorMessage[sizeof(reply.errorMessage) - 1] = '\0';
+        throw std::runtime_error(std::string(reply.errorMessage));
+    }
+}
@@ -0,0 +1,88 @@
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include "../include/DisparityMapAlgorithmParameters.hpp"
+#include "../include/DisparityServer.hpp"
+#include "../include/DisparityServiceProtocol.hpp"
+
+static DisparityServer* runningServer = nullptr;
+
+void handleTerminationSignal(int) {
+    if (runningServer != nullptr) {
+        runningServer->stop();
+    }
+}
+
+int main(int argc, char** argv) {
+
+    const cv::String commandLineKeys = 
+        "{help h usage ?   |         | This program serves disparity maps to local clients over a Unix socket and shared memory.}"
+        "{socketPath       |         | The Unix socket to listen on. Defaults to $XDG_RUNTIME_DIR/StereoVisionMultiWay.sock.}"
+        "{warmUpAlgorithms |         | The algorithms to initialize before accepting clients, comma-separated.}"
+        "{warmUpWidth      |     640 | The frame width used to warm up the algorithms.}"
+        "{warmUpHeight     |     480 | The frame height used to warm up the algorithms.}"
+        "{blockSize        |       7 | The block size used to warm up the algorithms.}"
+        "{leftScanSteps    |      50 | The left scan steps used to warm up the algorithms.}"
+        "{rightScanSteps   |      50 | The right scan steps used to warm up the algorithms.}";
+
+    cv::CommandLineParser parser(argc, argv, commandLineKeys);
+
+    if (!parser.check()) {
+        parser.printMessage();
+        parser.printErrors();
+        return 1;
+    }
+
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 1;
+    }
+
+    std::string socketPath = std::string(parser.get<cv::String>("socketPath"));
+    if (socketPath.empty()) {
+        socketPath = DisparityServiceProtocol::getDefaultSocketPath();
+    }
+
+    DisparityMapAlgorithmParameters_t templateParameters;
+    templateParameters.blockSize = parser.get<int>("blockSize");
+    templateParameters.leftScanSteps = parser.get<int>("leftScanSteps");
+    templateParameters.rightScanSteps = parser.get<int>("rightScanSteps");
+    std::string warmUpAlgorithmsStr = std::string(parser.get<cv::String>("warmUpAlgorithms"));
+    int warmUpWidth = parser.get<int>("warmUpWidth");
+    int warmUpHeight = parser.get<int>("warmUpHeight");
+
+    DisparityServer server(socketPath, templateParameters);
+
+    std::stringstream stream(warmUpAlgorithmsStr);
+    while (stream.good()) {
+        std::string algorithmName;
+        std::getline(stream, algorithmName, ',');
+        if (algorithmName.empty()) {
+            continue;
+        }
+
+        std::cout << "Warming up " << algorithmName << "..." << std::endl;
+        DisparityMapAlgorithmParameters_t warmUpParameters(templateParameters);
+        warmUpParameters.algorithmName = algorithmName;
+        server.warmUp(warmUpParameters, warmUpWidth, warmUpHeight);
+    }
+
+    runningServer = &server;
+    signal(SIGINT, handleTerminationSignal);
+    signal(SIGTERM, handleTerminationSignal);
+
+    std::cout << "Listening on " << socketPath << "..." << std::endl;
+    server.run();
+    runningServer = nullptr;
+
+    std::cout << "Graceful termination" << std::endl;
+
+    return 0;
+}
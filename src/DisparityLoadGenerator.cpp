@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "../include/DisparityClient.hpp"
+#include "../include/DisparityMapAlgorithmParameters.hpp"
+#include "../include/DisparityServiceProtocol.hpp"
+
+// Submits numFrames frames, keeping up to pipelineDepth in flight,
+//   and records the latency from submission to completion of each one.
+void runClient(
+        const std::string& socketPath,
+        const DisparityMapAlgorithmParameters_t& parameters,
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        int numFrames,
+        int pipelineDepth,
+        std::vector<double>& latenciesMs,
+        std::vector<double>& computeTimesMs) {
+    DisparityClient client(socketPath);
+    client.open(parameters, leftImage.cols, leftImage.rows, pipelineDepth);
+
+    std::vector<std::chrono::high_resolution_clock::time_point> submitTimes(pipelineDepth);
+    int numSubmitted = 0;
+    int numCompleted = 0;
+
+    while (numCompleted < numFrames) {
+        while ((numSubmitted < numFrames) && (client.getNumSlotsInFlight() < pipelineDepth)) {
+            cv::Mat slotLeftImage;
+            cv::Mat slotRightImage;
+            int slot = client.acquireSlot(slotLeftImage, slotRightImage);
+
+            // Writing the frame is part of the client's cost, as a camera driver would.
+            submitTimes[slot] = std::chrono::high_resolution_clock::now();
+            leftImage.copyTo(slotLeftImage);
+            rightImage.copyTo(slotRightImage);
+            client.submit(slot);
+            numSubmitted++;
+        }
+
+        cv::Mat disparity;
+        double computeTimeMs;
+        int slot = client.waitForDisparity(disparity, &computeTimeMs);
+        std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+        latenciesMs.emplace_back(std::chrono::duration_cast<std::chrono::microseconds>(end-submitTimes[slot]).count() / 1000.0);
+        computeTimesMs.emplace_back(computeTimeMs);
+        numCompleted++;
+    }
+
+    client.close();
+}
+
+double computePercentile(const std::vector<double>& sortedValues, double percentile) {
+    size_t index = static_cast<size_t>(percentile * (sortedValues.size() - 1) + 0.5);
+    return sortedValues[index];
+}
+
+int main(int argc, char** argv) {
+
+    const cv::String commandLineKeys = 
+        "{help h usage ? |          | This program measures the throughput and latency of a running DisparityDaemon.}"
+        "{leftImage      |   <none> | The left image to submit.}"
+        "{rightImage     |   <none> | The right image to submit.}"
+        "{algorithmName  |   <none> | The algorithm the daemon should use.}"
+        "{socketPath     |          | The daemon's Unix socket. Defaults to $XDG_RUNTIME_DIR/StereoVisionMultiWay.sock.}"
+        "{blockSize      |        7 | The maximum block size to use for matching.}"
+        "{leftScanSteps  |       50 | The number of blocks to scan to the left.}"
+        "{rightScanSteps |       50 | The number of blocks to scan to the right.}"
+        "{numClients     |        1 | The number of concurrent clients.}"
+        "{numFrames      |      200 | The number of frames each client submits.}"
+        "{pipelineDepth  |        2 | The number of frames each client keeps in flight.}";
+
+    cv::CommandLineParser parser(argc, argv, commandLineKeys);
+
+    if (!parser.check()) {
+        parser.printMessage();
+        parser.printErrors();
+        return 1;
+    }
+
+    if (parser.has("help")
+        || (!parser.has("leftImage"))
+        || (!parser.has("rightImage"))
+        || (!parser.has("algorithmName"))) {
+        parser.printMessage();
+        return 1;
+    }
+
+    std::string socketPath = std::string(parser.get<cv::String>("socketPath"));
+    if (socketPath.empty()) {
+        socketPath = DisparityServiceProtocol::getDefaultSocketPath();
+    }
+
+    DisparityMapAlgorithmParameters_t parameters;
+    parameters.blockSize = parser.get<int>("blockSize");
+    parameters.leftScanSteps = parser.get<int>("leftScanSteps");
+    parameters.rightScanSteps = parser.get<int>("rightScanSteps");
+    parameters.leftImageFilePath = std::string(parser.get<cv::String>("leftImage"));
+    parameters.rightImageFilePath = std::string(parser.get<cv::String>("rightImage"));
+    parameters.algorithmName = std::string(parser.get<cv::String>("algorithmName"));
+    int numClients = parser.get<int>("numClients");
+    int numFrames = parser.get<int>("numFrames");
+    int pipelineDepth = parser.get<int>("pipelineDepth");
+
+    if ((numClients < 1) || (numFrames < 1) || (pipelineDepth < 1)) {
+        throw std::runtime_error("Error. numClients, numFrames and pipelineDepth must be positive.");
+    }
+
+    cv::Mat leftImage = cv::imread(parameters.leftImageFilePath, cv::IMREAD_GRAYSCALE);
+    cv::Mat rightImage = cv::imread(parameters.rightImageFilePath, cv::IMREAD_GRAYSCALE);
+
+    if ((leftImage.rows == 0)
+            ||
+        (leftImage.cols == 0)
+            ||
+        (leftImage.rows != rightImage.rows)
+            ||
+        (leftImage.cols != rightImage.cols)) {
+        throw std::runtime_error("Error. The input images are empty or differ in size.");
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Running load test with the following parameters:" << std::endl;
+    std::cout << "\tAlgorithm Name: " << parameters.algorithmName << "." << std::endl;
+    std::cout << "\tSocket Path: " << socketPath << "." << std::endl;
+    std::cout << "\tImage Size: (" << leftImage.rows << "x" << leftImage.cols << ")." << std::endl;
+    std::cout << "\tNumber of clients: " << numClients << std::endl;
+    std::cout << "\tFrames per client: " << numFrames << std::endl;
+    std::cout << "\tPipeline Depth: " << pipelineDepth << std::endl;
+
+    std::vector<std::vector<double>> latenciesMs(numClients);
+    std::vector<std::vector<double>> computeTimesMs(numClients);
+    std::vector<std::string> errors;
+    std::mutex errorsMutex;
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> clientThreads;
+    for (int i = 0; i < numClients; i++) {
+        clientThreads.emplace_back([&, i]() {
+            try {
+                runClient(socketPath, parameters, leftImage, rightImage, numFrames, pipelineDepth, latenciesMs[i], computeTimesMs[i]);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(errorsMutex);
+                errors.emplace_back("Client " + std::to_string(i) + ": " + e.what());
+            }
+        });
+    }
+
+    for (std::thread& clientThread : clientThreads) {
+        clientThread.join();
+    }
+
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+    double elapsedSeconds = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() / 1000000.0;
+
+    for (const std::string& error : errors) {
+        std::cout << error << std::endl;
+    }
+
+    std::vector<double> allLatenciesMs;
+    double totalComputeTimeMs = 0;
+    for (int i = 0; i < numClients; i++) {
+        allLatenciesMs.insert(allLatenciesMs.end(), latenciesMs[i].begin(), latenciesMs[i].end());
+        for (double computeTimeMs : computeTimesMs[i]) {
+            totalComputeTimeMs += computeTimeMs;
+        }
+    }
+
+    if (allLatenciesMs.empty()) {
+        throw std::runtime_error("Error. No frames completed.");
+    }
+
+    std::sort(allLatenciesMs.begin(), allLatenciesMs.end());
+    double meanLatencyMs = 0;
+    for (double latencyMs : allLatenciesMs) {
+        meanLatencyMs += latencyMs;
+    }
+    meanLatencyMs /= allLatenciesMs.size();
+
+    std::cout << "Results:" << std::endl;
+    std::cout << "\tFrames completed: " << allLatenciesMs.size() << std::endl;
+    std::cout << "\tThroughput: " << allLatenciesMs.size() / elapsedSeconds << " frames/s" << std::endl;
+    std::cout << "\tMean latency: " << meanLatencyMs << " ms" << std::endl;
+    std::cout << "\tp50 latency: " << computePercentile(allLatenciesMs, 0.50) << " ms" << std::endl;
+    std::cout << "\tp95 latency: " << computePercentile(allLatenciesMs, 0.95) << " ms" << std::endl;
+    std::cout << "\tp99 latency: " << computePercentile(allLatenciesMs, 0.99) << " ms" << std::endl;
+    std::cout << "\tMax latency: " << allLatenciesMs.back() << " ms" << std::endl;
+    std::cout << "\tMean server compute time: " << totalComputeTimeMs / allLatenciesMs.size() << " ms" << std::endl;
+
+    std::cout << "Graceful termination" << std::endl;
+
+    return errors.empty() ? 0 : 1;
+}
@@ -0,0 +1,306 @@
+#include "../include/DisparityMapBackendRegistry.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <sstream>
+#include <unistd.h>
+#include <utility>
+
+#include <omp.h>
+
+#include <opencv2/core.hpp>
+
+#include "../include/MatchConfidence.hpp"
+#include "../include/SubpixelRefiner.hpp"
+
+DisparityMapBackendRegistry& DisparityMapBackendRegistry::getInstance() {
+    // Constructed on first use, so that registrations in other translation units can run in any order.
+    static DisparityMapBackendRegistry registry;
+    return registry;
+}
+
+void DisparityMapBackendRegistry::registerBackend(const DisparityMapBackendInfo_t& info) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    for (const DisparityMapBackendInfo_t& existing : this->backends_) {
+        if (caseInsensitiveStringsEqual(existing.name, info.name)) {
+            throw std::runtime_error("Error: the algorithm '" + info.name + "' is registered twice.");
+        }
+    }
+
+    this->backends_.emplace_back(info);
+}
+
+std::vector<DisparityMapBackendInfo_t> DisparityMapBackendRegistry::getBackends() {
+    this->loadPlugins();
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->backends_;
+}
+
+std::vector<std::string> DisparityMapBackendRegistry::getNames() {
+    this->loadPlugins();
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    std::vector<std::string> names;
+    for (const DisparityMapBackendInfo_t& info : this->backends_) {
+        names.push_back(info.name);
+    }
+
+    return names;
+}
+
+bool DisparityMapBackendRegistry::find(const std::string& name, DisparityMapBackendInfo_t& info) {
+    if (this->findRegistered(name, info)) {
+        return true;
+    }
+
+    this->loadPlugins();
+    return this->findRegistered(name, info);
+}
+
+void DisparityMapBackendRegistry::loadPlugins() {
+    std::call_once(this->pluginsLoaded_, [this]() {
+        const std::string prefix = "libDisparityBackend";
+        const std::string suffix = ".so";
+
+        for (const std::string& directory : getPluginDirectories()) {
+            DIR* dir = opendir(directory.c_str());
+            if (dir == nullptr) {
+                continue;
+            }
+
+            // Sorted, so that backends register in the same order on every run.
+            std::vector<std::string> fileNames;
+            for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+                std::string fileName(entry->d_name);
+                if ((fileName.size() > prefix.size() + suffix.size())
+                    &&
+                    (fileName.compare(0, prefix.size(), prefix) == 0)
+                    &&
+                    (fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0)) {
+                    fileNames.emplace_back(fileName);
+                }
+            }
+            closedir(dir);
+            std::sort(fileNames.begin(), fileNames.end());
+
+            for (const std::string& fileName : fileNames) {
+                std::string path = directory + "/" + fileName;
+                if (dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL) == nullptr) {
+                    std::lock_guard<std::mutex> lock(this->mutex_);
+                    this->pluginErrors_.emplace_back(dlerror());
+                }
+            }
+        }
+    });
+}
+
+std::vector<std::string> DisparityMapBackendRegistry::getPluginErrors() const {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->pluginErrors_;
+}
+
+std::vector<std::string> DisparityMapBackendRegistry::getPluginDirectories() {
+    std::vector<std::string> directories;
+
+    const char* pluginPath = getenv("STEREO_VISION_PLUGIN_PATH");
+    if ((pluginPath != nullptr) && (pluginPath[0] != '\0')) {
+        std::stringstream stream(pluginPath);
+        std::string directory;
+        while (std::getline(stream, directory, ':')) {
+            if (!directory.empty()) {
+                directories.emplace_back(directory);
+            }
+        }
+
+        return directories;
+    }
+
+    // By default, plugins are installed next to the running executable.
+    char selfPath[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", selfPath, sizeof(selfPath) - 1);
+    if (length > 0) {
+        selfPath[length] = '\0';
+        std::string path(selfPath);
+        directories.emplace_back(path.substr(0, path.rfind('/')));
+    }
+
+    return directories;
+}
+
+bool DisparityMapBackendRegistry::findRegistered(const std::string& name, DisparityMapBackendInfo_t& info) const {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    for (const DisparityMapBackendInfo_t& existing : this->backends_) {
+        if (caseInsensitiveStringsEqual(existing.name, name)) {
+            info = existing;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string DisparityMapBackendRegistry::checkSupport(
+        const DisparityMapBackendInfo_t& info,
+        const DisparityMapAlgorithmParameters_t& parameters,
+        int inputType) {
+    std::string algorithm = "the '" + info.name + "' algorithm";
+
+    int disparityRange = parameters.leftScanSteps + parameters.rightScanSteps + 1;
+    if ((info.maxDisparityRange > 0) && (disparityRange > info.maxDisparityRange)) {
+        return "A disparity range of " + std::to_string(disparityRange) + " is not supported by " + algorithm
+            + ", which supports at most " + std::to_string(info.maxDisparityRange) + ".";
+    }
+
+    if ((info.maxBlockSize > 0) && (parameters.blockSize > info.maxBlockSize)) {
+        return "A block size of " + std::to_string(parameters.blockSize) + " is not supported by " + algorithm
+            + ", which supports at most " + std::to_string(info.maxBlockSize) + ".";
+    }
+
+    if (std::find(info.inputTypes.begin(), info.inputTypes.end(), inputType) == info.inputTypes.end()) {
+        return "Input images of type " + cv::typeToString(inputType) + " are not supported by " + algorithm + ".";
+    }
+
+    if ((!parameters.rectificationMapsPath.empty()) && (!info.supportsRectification)) {
+        return "Rectification maps are not supported by " + algorithm + ".";
+    }
+
+    if ((SubpixelRefiner::parse(parameters.subpixelInterpolation) != SubpixelInterpolation::Parabolic)
+        &&
+        (!info.supportsSubpixelInterpolation)) {
+        return "Subpixel interpolation other than 'parabolic' is not supported by " + algorithm + ".";
+    }
+
+    if (((parameters.medianFilterSize > 0) || (parameters.speckleMaxSize > 0))
+        &&
+        (!info.supportsPostProcessing)) {
+        return "Median and speckle filtering are not supported by " + algorithm + ".";
+    }
+
+    if ((parameters.incrementalTileSize > 0) && (!info.supportsIncremental)) {
+        return "Incremental recomputation is not supported by " + algorithm + ".";
+    }
+
+    if (parameters.costVolumeEnabled && (!info.supportsCostVolume)) {
+        return "Cost volumes are not supported by " + algorithm + ".";
+    }
+
+    if ((MatchConfidence::parse(parameters.confidenceMeasure) != ConfidenceMeasure::None)
+        &&
+        (!info.supportsConfidence)) {
+        return "Confidence maps are not supported by " + algorithm + ".";
+    }
+
+    return std::string();
+}
+
+bool DisparityMapBackendRegistry::isAvailable(const DisparityMapBackendInfo_t& info) {
+    for (const std::string& instructionSet : info.requiredInstructionSets) {
+        if (!isInstructionSetSupported(instructionSet)) {
+            return false;
+        }
+    }
+
+    return (!info.isDeviceAvailable) || info.isDeviceAvailable();
+}
+
+double DisparityMapBackendRegistry::estimateFrameTimeMs(
+        const DisparityMapBackendInfo_t& info,
+        const DisparityMapAlgorithmParameters_t& parameters,
+        int rows,
+        int cols) {
+    // Every pixel compares its block against each candidate that fits in the row.
+    double numCandidates = std::min(parameters.leftScanSteps + parameters.rightScanSteps + 1, cols);
+    double numComparisons = static_cast<double>(rows) * cols
+        * parameters.blockSize * parameters.blockSize
+        * numCandidates;
+
+    double matchingMs = numComparisons * info.nanosecondsPerComparison * 1e-6;
+    if (info.scalesWithOpenMpThreads) {
+        matchingMs /= omp_get_max_threads();
+    }
+
+    return info.fixedCostMs + matchingMs;
+}
+
+std::vector<DisparityMapBackendInfo_t> DisparityMapBackendRegistry::findSupporting(
+        const DisparityMapAlgorithmParameters_t& parameters,
+        int rows,
+        int cols,
+        int inputType) {
+    std::vector<std::pair<double, DisparityMapBackendInfo_t>> candidates;
+    for (const DisparityMapBackendInfo_t& info : this->getBackends()) {
+        if (info.selectable
+            &&
+            checkSupport(info, parameters, inputType).empty()
+            &&
+            isAvailable(info)) {
+            candidates.emplace_back(estimateFrameTimeMs(info, parameters, rows, cols), info);
+        }
+    }
+
+    std::stable_sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const std::pair<double, DisparityMapBackendInfo_t>& a, const std::pair<double, DisparityMapBackendInfo_t>& b) {
+            return a.first < b.first;
+        });
+
+    std::vector<DisparityMapBackendInfo_t> supporting;
+    for (const std::pair<double, DisparityMapBackendInfo_t>& candidate : candidates) {
+        supporting.emplace_back(candidate.second);
+    }
+
+    return supporting;
+}
+
+DisparityMapBackendInfo_t DisparityMapBackendRegistry::selectFastest(
+        const DisparityMapAlgorithmParameters_t& parameters,
+        int rows,
+        int cols,
+        int inputType) {
+    std::vector<DisparityMapBackendInfo_t> supporting = this->findSupporting(parameters, rows, cols, inputType);
+    if (supporting.empty()) {
+        throw std::runtime_error("Error: no available algorithm supports the requested parameters.");
+    }
+
+    return supporting.front();
+}
+
+bool DisparityMapBackendRegistry::isInstructionSetSupported(const std::string& instructionSet) {
+    // __builtin_cpu_supports() only takes string literals.
+    if (instructionSet == "sse4.2") {
+        return __builtin_cpu_supports("sse4.2");
+    } else if (instructionSet == "avx") {
+        return __builtin_cpu_supports("avx");
+    } else if (instructionSet == "avx2") {
+        return __builtin_cpu_supports("avx2");
+    } else if (instructionSet == "fma") {
+        return __builtin_cpu_supports("fma");
+    } else if (instructionSet == "avx512f") {
+        return __builtin_cpu_supports("avx512f");
+    } else if (instructionSet == "avx512bw") {
+        return __builtin_cpu_supports("avx512bw");
+    }
+
+    return false;
+}
+
+bool DisparityMapBackendRegistry::caseInsensitiveStringsEqual(
+        const std::string& s1,
+        const std::string& s2) {
+    if (s1.size() != s2.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < s1.size(); i++) {
+        if (toupper(s1[i]) != toupper(s2[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,104 @@
+#include "../include/DisparityMapGenerator.hpp"
+#include "../include/GrayscaleConverter.hpp"
+
+#include <string>
+
+void DisparityMapGenerator::computeDisparityAt(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        const std::vector<cv::Point>& points,
+        std::vector<float>& disparities,
+        std::vector<int>* costs) {
+    bool parallel = this->beginSparseQuery();
+
+    int numPoints = static_cast<int>(points.size());
+    for (int i = 0; i < numPoints; i++) {
+        if ((points[i].x < 0)
+            ||
+            (points[i].y < 0)
+            ||
+            (points[i].x >= leftImage.cols)
+            ||
+            (points[i].y >= leftImage.rows)) {
+            throw std::runtime_error("Error: query point ("
+                + std::to_string(points[i].x)
+                + ", "
+                + std::to_string(points[i].y)
+                + ") is outside of the image.");
+        }
+    }
+
+    const cv::Mat& leftGray = GrayscaleConverter::ensureGray(leftImage, this->sparseLeftGrayImage_);
+    const cv::Mat& rightGray = GrayscaleConverter::ensureGray(rightImage, this->sparseRightGrayImage_);
+
+    disparities.resize(numPoints);
+    if (costs != nullptr) {
+        costs->resize(numPoints);
+    }
+
+    #pragma omp parallel for if(parallel) default(none) shared(leftGray, rightGray, points, disparities, costs, numPoints)
+    for (int i = 0; i < numPoints; i++) {
+        this->computeDisparitySpan(
+            leftGray,
+            rightGray,
+            points[i].y,
+            points[i].x,
+            points[i].x + 1,
+            &disparities[i],
+            (costs != nullptr) ? &(*costs)[i] : nullptr);
+    }
+}
+
+void DisparityMapGenerator::computeDisparityAt(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        const std::vector<cv::Rect>& regions,
+        cv::Mat& disparity,
+        cv::Mat* costs) {
+    bool parallel = this->beginSparseQuery();
+
+    const cv::Mat& leftGray = GrayscaleConverter::ensureGray(leftImage, this->sparseLeftGrayImage_);
+    const cv::Mat& rightGray = GrayscaleConverter::ensureGray(rightImage, this->sparseRightGrayImage_);
+
+    disparity.create(leftImage.rows, leftImage.cols, CV_32FC1);
+    if (costs != nullptr) {
+        costs->create(leftImage.rows, leftImage.cols, CV_32SC1);
+    }
+
+    cv::Rect imageRect(0, 0, leftImage.cols, leftImage.rows);
+
+    for (size_t i = 0; i < regions.size(); i++) {
+        cv::Rect region = regions[i] & imageRect;
+
+        if (region.width <= 0) {
+            continue;
+        }
+
+        #pragma omp parallel for if(parallel) default(none) shared(leftGray, rightGray, disparity, costs, region)
+        for (int y = region.y; y < region.y + region.height; y++) {
+            this->computeDisparitySpan(
+                leftGray,
+                rightGray,
+                y,
+                region.x,
+                region.x + region.width,
+                disparity.ptr<float>(y) + region.x,
+                (costs != nullptr) ? costs->ptr<int>(y) + region.x : nullptr);
+        }
+    }
+}
+
+bool DisparityMapGenerator::beginSparseQuery() {
+    throw std::runtime_error("Error: sparse disparity queries are not supported by this algorithm.");
+}
+
+void DisparityMapGenerator::computeDisparitySpan(
+        const cv::Mat& leftGray,
+        const cv::Mat& rightGray,
+        int y,
+        int minX,
+        int maxX,
+        float* disparities,
+        int* costs) {
+    throw std::runtime_error("Error: sparse disparity queries are not supported by this algorithm.");
+}
@@ -1,49 +1,43 @@
-#include "../include/CudaDisparityMapGenerator.hpp"
-#include "../include/CudaSimdDisparityMapGenerator.hpp"
 #include "../include/DisparityMapGeneratorFactory.hpp"
-#include "../include/SingleThreadedDisparityMapGenerator.hpp"
-#include "../include/SingleThreadedSimdDisparityMapGenerator.hpp"
-#include "../include/OpenClDisparityMapGenerator.hpp"
-#include "../include/OpenMpThreadedDisparityMapGenerator.hpp"
-#include "../include/OpenMpThreadedSimdDisparityMapGenerator.hpp"
+
+#include <opencv2/core.hpp>
+
+#include "../include/DisparityMapBackendRegistry.hpp"
 
 std::unique_ptr<DisparityMapGenerator> DisparityMapGeneratorFactory::create(
         const DisparityMapAlgorithmParameters_t& parameters) {
-    
-    if (this->caseInsensitiveStringsEqual(parameters.algorithmName, "SingleThreaded")) {
-        return std::make_unique<SingleThreadedDisparityMapGenerator>(parameters);
-    } else if (this->caseInsensitiveStringsEqual(parameters.algorithmName, "SingleThreadedSimd")) {
-      return std::make_unique<SingleThreadedSimdDisparityMapGenerator>(parameters);  
-    } else if (this->caseInsensitiveStringsEqual(parameters.algorithmName, "OpenMP")) {
-        return std::make_unique<OpenMpThreadedDisparityMapGenerator>(parameters);
-    } else if (this->caseInsensitiveStringsEqual(parameters.algorithmName, "OpenMPSimd")) {
-        return std::make_unique<OpenMpThreadedSimdDisparityMapGenerator>(parameters);
-    } else if (this->caseInsensitiveStringsEqual(parameters.algorithmName, "CUDA")) {
-        return std::make_unique<CudaDisparityMapGenerator>(parameters);
-    } else if (this->caseInsensitiveStringsEqual(parameters.algorithmName, "CUDASimd")) {
-        return std::make_unique<CudaSimdDisparityMapGenerator>(parameters);  
-    } else if (this->caseInsensitiveStringsEqual(parameters.algorithmName, "OpenCL")) {
-        return std::make_unique<OpenClDisparityMapGenerator>(parameters);
-    } else {
+    DisparityMapBackendRegistry& registry = DisparityMapBackendRegistry::getInstance();
+
+    DisparityMapBackendInfo_t info;
+    if (!registry.find(parameters.algorithmName, info)) {
+        std::vector<std::string> names = registry.getNames();
+        std::string validOptions;
+        for (size_t i = 0; i < names.size(); i++) {
+            if (i > 0) {
+                validOptions += (i + 1 == names.size()) ? ", and " : ",";
+            }
+            validOptions += "'" + names[i] + "'";
+        }
+
+        // A backend may be missing because its plugin could not load.
+        std::string pluginErrors;
+        for (const std::string& error : registry.getPluginErrors()) {
+            pluginErrors += "\nPlugin not loaded: " + error;
+        }
+
         throw std::runtime_error("Unrecognized algorithmName '" 
             + parameters.algorithmName
             + "'.\n"
-            + "Valid Options are 'SingleThreaded','SingleThreadedSimd','OpenMP','OpenMPSimd','CUDA', and 'OpenCL'.");
+            + "Valid Options are " + validOptions + "."
+            + pluginErrors);
     }
-}
 
-bool DisparityMapGeneratorFactory::caseInsensitiveStringsEqual(
-        const std::string& s1,
-        const std::string& s2) {
-    if (s1.size() != s2.size()) {
-        return false;
-    }
-
-    for (size_t i = 0; i < s1.size(); i++) {
-        if (toupper(s1[i]) != toupper(s2[i])) {
-            return false;
-        }
+    // The input type is only known per frame, and every backend takes gray input.
+    // Unsupported options are rejected here, since the backends would silently ignore them.
+    std::string unsupported = DisparityMapBackendRegistry::checkSupport(info, parameters, CV_8UC1);
+    if (!unsupported.empty()) {
+        throw std::runtime_error(unsupported);
     }
 
-    return true;
+    return info.create(parameters);
 }
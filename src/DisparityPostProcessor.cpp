@@ -0,0 +1,287 @@
+#include "../include/DisparityPostProcessor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Selection networks from N. Devillard, "Fast median search: an ANSI C implementation".
+// After the compare-exchanges, the middle element holds the median.
+static const int MEDIAN_NETWORK_3X3[][2] = {
+    {1, 2}, {4, 5}, {7, 8}, {0, 1}, {3, 4}, {6, 7}, {1, 2}, {4, 5}, {7, 8}, {0, 3},
+    {5, 8}, {4, 7}, {3, 6}, {1, 4}, {2, 5}, {4, 7}, {4, 2}, {6, 4}, {4, 2}
+};
+
+static const int MEDIAN_NETWORK_5X5[][2] = {
+    {0, 1}, {3, 4}, {2, 4}, {2, 3}, {6, 7}, {5, 7}, {5, 6}, {9, 10}, {8, 10}, {8, 9},
+    {12, 13}, {11, 13}, {11, 12}, {15, 16}, {14, 16}, {14, 15}, {18, 19}, {17, 19}, {17, 18}, {21, 22},
+    {20, 22}, {20, 21}, {23, 24}, {2, 5}, {3, 6}, {0, 6}, {0, 3}, {4, 7}, {1, 7}, {1, 4},
+    {11, 14}, {8, 14}, {8, 11}, {12, 15}, {9, 15}, {9, 12}, {13, 16}, {10, 16}, {10, 13}, {20, 23},
+    {17, 23}, {17, 20}, {21, 24}, {18, 24}, {18, 21}, {19, 22}, {8, 17}, {9, 18}, {0, 18}, {0, 9},
+    {10, 19}, {1, 19}, {1, 10}, {11, 20}, {2, 20}, {2, 11}, {12, 21}, {3, 21}, {3, 12}, {13, 22},
+    {4, 22}, {4, 13}, {14, 23}, {5, 23}, {5, 14}, {15, 24}, {6, 24}, {6, 15}, {7, 16}, {7, 19},
+    {13, 21}, {15, 23}, {7, 13}, {7, 15}, {1, 9}, {3, 11}, {5, 17}, {11, 17}, {9, 17}, {4, 10},
+    {6, 12}, {7, 14}, {4, 6}, {4, 7}, {12, 14}, {10, 14}, {6, 7}, {10, 12}, {6, 10}, {6, 17},
+    {12, 17}, {7, 17}, {7, 10}, {12, 18}, {7, 12}, {10, 18}, {12, 20}, {10, 20}, {10, 12}
+};
+
+static inline float minValue(float a, float b) { return std::min(a, b); }
+static inline float maxValue(float a, float b) { return std::max(a, b); }
+static inline __m256 minValue(__m256 a, __m256 b) { return _mm256_min_ps(a, b); }
+static inline __m256 maxValue(__m256 a, __m256 b) { return _mm256_max_ps(a, b); }
+
+// The same network sorts scalars at the borders and 8 pixels at a time in the interior.
+template <typename T, int NumSteps>
+static inline T selectMedian(T* values, int numValues, const int (&network)[NumSteps][2]) {
+    for (int i = 0; i < NumSteps; i++) {
+        T low = minValue(values[network[i][0]], values[network[i][1]]);
+        T high = maxValue(values[network[i][0]], values[network[i][1]]);
+        values[network[i][0]] = low;
+        values[network[i][1]] = high;
+    }
+
+    return values[numValues / 2];
+}
+
+template <typename T>
+static inline T selectMedian(T* values, int radius) {
+    return (radius == 1)
+        ? selectMedian(values, 9, MEDIAN_NETWORK_3X3)
+        : selectMedian(values, 25, MEDIAN_NETWORK_5X5);
+}
+
+DisparityPostProcessor::DisparityPostProcessor(const DisparityMapAlgorithmParameters_t& parameters)
+        : speckleMaxSize_(parameters.speckleMaxSize),
+          speckleMaxDifference_(parameters.speckleMaxDifference),
+          speckleNewValue_(parameters.speckleNewValue) {
+    if ((parameters.medianFilterSize != 0)
+        &&
+        (parameters.medianFilterSize != 3)
+        &&
+        (parameters.medianFilterSize != 5)) {
+        throw std::runtime_error("Error: the median filter size must be 0, 3 or 5.");
+    }
+
+    if (parameters.speckleMaxSize < 0) {
+        throw std::runtime_error("Error: the maximum speckle size is negative.");
+    }
+
+    if (parameters.speckleMaxDifference < 0) {
+        throw std::runtime_error("Error: the maximum speckle difference is negative.");
+    }
+
+    this->medianRadius_ = parameters.medianFilterSize / 2;
+}
+
+bool DisparityPostProcessor::isEnabled() const {
+    return this->isMedianFilterEnabled() || this->isSpeckleFilterEnabled();
+}
+
+bool DisparityPostProcessor::isMedianFilterEnabled() const {
+    return (this->medianRadius_ > 0);
+}
+
+bool DisparityPostProcessor::isSpeckleFilterEnabled() const {
+    return (this->speckleMaxSize_ > 0);
+}
+
+int DisparityPostProcessor::getMedianRadius() const {
+    return this->medianRadius_;
+}
+
+void DisparityPostProcessor::beginFrame(int rows, int cols) {
+    this->frameCols_ = cols;
+
+    if (this->isSpeckleFilterEnabled()) {
+        size_t numPixels = static_cast<size_t>(rows) * cols;
+        this->speckleParents_.resize(numPixels);
+        this->speckleRoots_.resize(numPixels);
+        this->speckleSizes_.resize(numPixels);
+    }
+}
+
+void DisparityPostProcessor::medianFilterRows(
+        const cv::Mat& source,
+        int minY,
+        int maxY,
+        cv::Mat& destination) const {
+    int radius = this->medianRadius_;
+    int width = source.cols;
+
+    if (radius == 0) {
+        for (int y = minY; y < maxY; y++) {
+            std::copy(source.ptr<float>(y), source.ptr<float>(y) + width, destination.ptr<float>(y));
+        }
+        return;
+    }
+
+    int diameter = (2 * radius) + 1;
+    const float* rows[5];
+
+    for (int y = minY; y < maxY; y++) {
+        for (int dy = 0; dy < diameter; dy++) {
+            rows[dy] = source.ptr<float>(std::min(std::max(y + dy - radius, 0), source.rows - 1));
+        }
+
+        float* output = destination.ptr<float>(y);
+
+        // Pixels whose window crosses the left or right edge replicate the border.
+        int simdMinX = radius;
+        int simdMaxX = width - radius - SIMD_WIDTH;
+        for (int x = 0; x < width; x++) {
+            if ((x >= simdMinX) && (x <= simdMaxX)) {
+                __m256 window[25];
+                for (int dy = 0; dy < diameter; dy++) {
+                    for (int dx = 0; dx < diameter; dx++) {
+                        window[(dy * diameter) + dx] = _mm256_loadu_ps(rows[dy] + x + dx - radius);
+                    }
+                }
+
+                _mm256_storeu_ps(output + x, selectMedian(window, radius));
+                x += SIMD_WIDTH - 1;
+                continue;
+            }
+
+            float window[25];
+            for (int dy = 0; dy < diameter; dy++) {
+                for (int dx = 0; dx < diameter; dx++) {
+                    window[(dy * diameter) + dx] = rows[dy][std::min(std::max(x + dx - radius, 0), width - 1)];
+                }
+            }
+
+            output[x] = selectMedian(window, radius);
+        }
+    }
+}
+
+void DisparityPostProcessor::labelSpeckleRows(const cv::Mat& disparity, int minY, int maxY) {
+    if (!this->isSpeckleFilterEnabled()) {
+        return;
+    }
+
+    int width = this->frameCols_;
+    for (int y = minY; y < maxY; y++) {
+        const float* row = disparity.ptr<float>(y);
+        const float* previousRow = (y > minY) ? disparity.ptr<float>(y - 1) : nullptr;
+
+        for (int x = 0; x < width; x++) {
+            int index = (y * width) + x;
+            this->speckleParents_[index] = index;
+
+            if ((x > 0) && (this->isSimilar(row[x], row[x - 1]))) {
+                this->unite(index, index - 1);
+            }
+
+            if ((previousRow != nullptr) && (this->isSimilar(row[x], previousRow[x]))) {
+                this->unite(index, index - width);
+            }
+        }
+    }
+}
+
+void DisparityPostProcessor::removeSpeckles(cv::Mat& disparity, int stripHeight) {
+    if (!this->isSpeckleFilterEnabled()) {
+        return;
+    }
+
+    int width = this->frameCols_;
+    int rows = disparity.rows;
+
+    for (int seamY = stripHeight; seamY < rows; seamY += stripHeight) {
+        const float* above = disparity.ptr<float>(seamY - 1);
+        const float* below = disparity.ptr<float>(seamY);
+        for (int x = 0; x < width; x++) {
+            if (this->isSimilar(above[x], below[x])) {
+                this->unite((seamY * width) + x, ((seamY - 1) * width) + x);
+            }
+        }
+    }
+
+    int numPixels = rows * width;
+    int speckleMaxSize = this->speckleMaxSize_;
+    float speckleNewValue = this->speckleNewValue_;
+    std::vector<int>& roots = this->speckleRoots_;
+    std::vector<int>& sizes = this->speckleSizes_;
+
+    #pragma omp parallel default(none) shared(disparity, numPixels, width, speckleMaxSize, speckleNewValue, roots, sizes)
+    {
+        #pragma omp for
+        for (int i = 0; i < numPixels; i++) {
+            roots[i] = this->findRootReadOnly(i);
+            sizes[i] = 0;
+        }
+
+        #pragma omp for
+        for (int i = 0; i < numPixels; i++) {
+            #pragma omp atomic
+            sizes[roots[i]]++;
+        }
+
+        #pragma omp for
+        for (int i = 0; i < numPixels; i++) {
+            if (sizes[roots[i]] <= speckleMaxSize) {
+                disparity.ptr<float>(i / width)[i % width] = speckleNewValue;
+            }
+        }
+    }
+}
+
+void DisparityPostProcessor::apply(const cv::Mat& rawDisparity, cv::Mat& disparity) {
+    const cv::Mat* source = &rawDisparity;
+    if (this->isMedianFilterEnabled() && (rawDisparity.data == disparity.data)) {
+        rawDisparity.copyTo(this->rawDisparity_);
+        source = &this->rawDisparity_;
+    }
+
+    int rows = rawDisparity.rows;
+    int numStrips = (rows + STRIP_HEIGHT - 1) / STRIP_HEIGHT;
+    this->beginFrame(rows, rawDisparity.cols);
+
+    #pragma omp parallel for schedule(dynamic) default(none) shared(source, disparity, rows, numStrips)
+    for (int strip = 0; strip < numStrips; strip++) {
+        int minY = strip * STRIP_HEIGHT;
+        int maxY = std::min(rows, minY + STRIP_HEIGHT);
+
+        if (source->data != disparity.data) {
+            this->medianFilterRows(*source, minY, maxY, disparity);
+        }
+
+        this->labelSpeckleRows(disparity, minY, maxY);
+    }
+
+    this->removeSpeckles(disparity, STRIP_HEIGHT);
+}
+
+bool DisparityPostProcessor::isSimilar(float a, float b) const {
+    // Pixels already holding the replacement value are not part of any region.
+    return (a != this->speckleNewValue_)
+        && (b != this->speckleNewValue_)
+        && (std::abs(a - b) <= this->speckleMaxDifference_);
+}
+
+int DisparityPostProcessor::findRoot(int index) {
+    while (this->speckleParents_[index] != index) {
+        this->speckleParents_[index] = this->speckleParents_[this->speckleParents_[index]];
+        index = this->speckleParents_[index];
+    }
+
+    return index;
+}
+
+int DisparityPostProcessor::findRootReadOnly(int index) const {
+    while (this->speckleParents_[index] != index) {
+        index = this->speckleParents_[index];
+    }
+
+    return index;
+}
+
+void DisparityPostProcessor::unite(int a, int b) {
+    int rootA = this->findRoot(a);
+    int rootB = this->findRoot(b);
+
+    // Linking to the lower index keeps every root inside the strip that first labelled it.
+    if (rootA < rootB) {
+        this->speckleParents_[rootB] = rootA;
+    } else if (rootB < rootA) {
+        this->speckleParents_[rootA] = rootB;
+    }
+}
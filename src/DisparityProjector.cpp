@@ -0,0 +1,149 @@
+#include "../include/DisparityProjector.hpp"
+
+DisparityProjector::DisparityProjector(
+        double focalLength,
+        double baseline,
+        double principalPointX,
+        double principalPointY,
+        float minDisparity)
+        : focalLength_(static_cast<float>(focalLength)),
+          focalLengthTimesBaseline_(static_cast<float>(focalLength * baseline)),
+          principalPointX_(static_cast<float>(principalPointX)),
+          principalPointY_(static_cast<float>(principalPointY)),
+          minDisparity_(minDisparity) {
+    if (focalLength <= 0) {
+        throw std::runtime_error("Error: the focal length must be positive.");
+    }
+
+    if (baseline <= 0) {
+        throw std::runtime_error("Error: the baseline must be positive.");
+    }
+
+    if (minDisparity < 0) {
+        throw std::runtime_error("Error: the minimum projected disparity is negative.");
+    }
+}
+
+DisparityProjector DisparityProjector::fromParameters(
+        const DisparityMapAlgorithmParameters_t& parameters,
+        int imageRows,
+        int imageCols) {
+    return DisparityProjector(
+        parameters.focalLength,
+        parameters.baseline,
+        (parameters.principalPointX < 0) ? (imageCols - 1) / 2.0 : parameters.principalPointX,
+        (parameters.principalPointY < 0) ? (imageRows - 1) / 2.0 : parameters.principalPointY,
+        parameters.minProjectedDisparity);
+}
+
+void DisparityProjector::computeDepthRows(const cv::Mat& disparity, int minY, int maxY, cv::Mat& depth) const {
+    int width = disparity.cols;
+    __m256 focalLengthTimesBaseline = _mm256_set1_ps(this->focalLengthTimesBaseline_);
+    __m256 minDisparity = _mm256_set1_ps(this->minDisparity_);
+
+    for (int y = minY; y < maxY; y++) {
+        const float* disparityRow = disparity.ptr<float>(y);
+        float* depthRow = depth.ptr<float>(y);
+
+        int x = 0;
+        for (; x + SIMD_WIDTH <= width; x += SIMD_WIDTH) {
+            __m256 d = _mm256_loadu_ps(disparityRow + x);
+            __m256 valid = _mm256_cmp_ps(d, minDisparity, _CMP_GT_OQ);
+            __m256 z = _mm256_div_ps(focalLengthTimesBaseline, d);
+            _mm256_storeu_ps(depthRow + x, _mm256_and_ps(z, valid));
+        }
+
+        for (; x < width; x++) {
+            float d = disparityRow[x];
+            depthRow[x] = (d > this->minDisparity_) ? this->focalLengthTimesBaseline_ / d : 0.0f;
+        }
+    }
+}
+
+void DisparityProjector::projectRows(
+        const cv::Mat& disparity,
+        const cv::Mat& intensity,
+        const cv::Mat& confidence,
+        float minConfidence,
+        int minY,
+        int maxY,
+        std::vector<PointXYZI_t>& points) const {
+    int width = disparity.cols;
+    float inverseFocalLength = 1.0f / this->focalLength_;
+
+    __m256 focalLengthTimesBaseline = _mm256_set1_ps(this->focalLengthTimesBaseline_);
+    __m256 minDisparity = _mm256_set1_ps(this->minDisparity_);
+    __m256 minConfidenceVector = _mm256_set1_ps(minConfidence);
+    __m256 inverseFocalLengthVector = _mm256_set1_ps(inverseFocalLength);
+    __m256 laneOffsets = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+
+    alignas(32) float xs[SIMD_WIDTH];
+    alignas(32) float ys[SIMD_WIDTH];
+    alignas(32) float zs[SIMD_WIDTH];
+    alignas(32) float intensities[SIMD_WIDTH];
+
+    for (int y = minY; y < maxY; y++) {
+        const float* disparityRow = disparity.ptr<float>(y);
+        const uint8_t* intensityRow = intensity.empty() ? nullptr : intensity.ptr<uint8_t>(y);
+        const float* confidenceRow = confidence.empty() ? nullptr : confidence.ptr<float>(y);
+        float rayY = (y - this->principalPointY_) * inverseFocalLength;
+        __m256 rayYVector = _mm256_set1_ps(rayY);
+
+        int x = 0;
+        for (; x + SIMD_WIDTH <= width; x += SIMD_WIDTH) {
+            __m256 d = _mm256_loadu_ps(disparityRow + x);
+            __m256 valid = _mm256_cmp_ps(d, minDisparity, _CMP_GT_OQ);
+            if (confidenceRow != nullptr) {
+                valid = _mm256_and_ps(
+                    valid,
+                    _mm256_cmp_ps(_mm256_loadu_ps(confidenceRow + x), minConfidenceVector, _CMP_GE_OQ));
+            }
+
+            int validMask = _mm256_movemask_ps(valid);
+            if (validMask == 0) {
+                continue;
+            }
+
+            __m256 z = _mm256_div_ps(focalLengthTimesBaseline, d);
+            __m256 rayX = _mm256_mul_ps(
+                _mm256_sub_ps(
+                    _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets),
+                    _mm256_set1_ps(this->principalPointX_)),
+                inverseFocalLengthVector);
+
+            _mm256_store_ps(xs, _mm256_mul_ps(rayX, z));
+            _mm256_store_ps(ys, _mm256_mul_ps(rayYVector, z));
+            _mm256_store_ps(zs, z);
+
+            if (intensityRow != nullptr) {
+                __m128i pixels = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(intensityRow + x));
+                _mm256_store_ps(intensities, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(pixels)));
+            } else {
+                _mm256_store_ps(intensities, _mm256_setzero_ps());
+            }
+
+            // Only the valid lanes are packed into the output.
+            for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+                if (validMask & (1 << lane)) {
+                    points.push_back({xs[lane], ys[lane], zs[lane], intensities[lane]});
+                }
+            }
+        }
+
+        for (; x < width; x++) {
+            float d = disparityRow[x];
+            if ((d <= this->minDisparity_)
+                ||
+                ((confidenceRow != nullptr) && (confidenceRow[x] < minConfidence))) {
+                continue;
+            }
+
+            float z = this->focalLengthTimesBaseline_ / d;
+            points.push_back({
+                ((x - this->principalPointX_) * inverseFocalLength) * z,
+                rayY * z,
+                z,
+                (intensityRow != nullptr) ? static_cast<float>(intensityRow[x]) : 0.0f});
+        }
+    }
+}
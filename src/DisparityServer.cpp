@@ -0,0 +1,332 @@
+#include "../include/DisparityServer.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
+#include "../include/DisparityMapGeneratorFactory.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+DisparityServer::DisparityServer(
+        const std::string& socketPath,
+        const DisparityMapAlgorithmParameters_t& templateParameters)
+        : socketPath_(socketPath), templateParameters_(templateParameters), stopRequested_(false) {
+    struct sockaddr_un address;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Error: socket path '" + socketPath + "' is too long.");
+    }
+
+    this->listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (this->listenFd_ < 0) {
+        throw std::runtime_error("Error: could not create the service socket: " + std::string(strerror(errno)) + ".");
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    DisparityServiceProtocol::copyString(socketPath, address.sun_path, sizeof(address.sun_path));
+
+    // A socket left behind by a previous instance would make bind() fail.
+    unlink(socketPath.c_str());
+
+    if ((bind(this->listenFd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+        ||
+        (listen(this->listenFd_, 16) != 0)) {
+        int error = errno;
+        close(this->listenFd_);
+        throw std::runtime_error("Error: could not listen on '" + socketPath + "': " + std::string(strerror(error)) + ".");
+    }
+}
+
+DisparityServer::~DisparityServer() {
+    this->stop();
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        for (std::pair<const int, std::thread>& clientThread : this->clientThreads_) {
+            shutdown(clientThread.first, SHUT_RDWR);
+        }
+    }
+
+    // The client threads take the mutex on their way out, so it must not be held while joining.
+    for (std::pair<const int, std::thread>& clientThread : this->clientThreads_) {
+        clientThread.second.join();
+    }
+
+    for (int clientFd : this->finishedClientFds_) {
+        close(clientFd);
+    }
+
+    if (this->listenFd_ >= 0) {
+        close(this->listenFd_);
+        unlink(this->socketPath_.c_str());
+    }
+}
+
+void DisparityServer::warmUp(
+        const DisparityMapAlgorithmParameters_t& parameters,
+        int width,
+        int height) {
+    std::unique_ptr<DisparityMapGenerator> generator = this->acquireGenerator(parameters);
+    std::mutex* backendMutex = this->findBackendMutex(parameters.algorithmName);
+
+    cv::Mat blankImage(height, width, CV_8UC1, cv::Scalar(0));
+    cv::Mat disparity(height, width, CV_32FC1);
+    {
+        std::unique_lock<std::mutex> backendLock;
+        if (backendMutex != nullptr) {
+            backendLock = std::unique_lock<std::mutex>(*backendMutex);
+        }
+
+        generator->computeDisparity(blankImage, blankImage, disparity);
+    }
+
+    this->releaseGenerator(parameters, std::move(generator));
+}
+
+void DisparityServer::run() {
+    struct pollfd listenPoll;
+    listenPoll.fd = this->listenFd_;
+    listenPoll.events = POLLIN;
+
+    // poll() wakes up periodically to notice stop() and reap finished clients.
+    while (!this->stopRequested_.load()) {
+        this->joinFinishedClients();
+
+        int ready = poll(&listenPoll, 1, 200);
+        if (ready <= 0) {
+            continue;
+        }
+
+        int clientFd = accept4(this->listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        int sessionId = this->nextSessionId_++;
+        this->clientThreads_.emplace(clientFd, std::thread(&DisparityServer::serveClient, this, clientFd, sessionId));
+    }
+
+    this->joinFinishedClients();
+}
+
+void DisparityServer::stop() {
+    this->stopRequested_.store(true);
+}
+
+int DisparityServer::getNumIdleGenerators() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return static_cast<int>(this->idleGenerators_.size());
+}
+
+void DisparityServer::serveClient(int clientFd, int sessionId) {
+    DisparityMapAlgorithmParameters_t parameters(this->templateParameters_);
+    std::unique_ptr<DisparityMapGenerator> generator;
+    uint8_t* sharedMemory = nullptr;
+    size_t sharedMemorySize = 0;
+
+    try {
+        DisparityServiceMessage_t openMessage;
+        if ((!DisparityServiceProtocol::receiveMessage(clientFd, openMessage))
+            ||
+            (openMessage.type != static_cast<uint32_t>(DisparityServiceMessageType::Open))) {
+            throw std::runtime_error("Error: expected an Open request.");
+        }
+
+        if ((openMessage.width <= 0) || (openMessage.height <= 0) || (openMessage.numSlots <= 0)) {
+            throw std::runtime_error("Error: the frame size and number of slots must be positive.");
+        }
+
+        openMessage.algorithmName[sizeof(openMessage.algorithmName) - 1] = '\0';
+        parameters.algorithmName = std::string(openMessage.algorithmName);
+        parameters.blockSize = openMessage.blockSize;
+        parameters.leftScanSteps = openMessage.leftScanSteps;
+        parameters.rightScanSteps = openMessage.rightScanSteps;
+        generator = this->acquireGenerator(parameters);
+
+        // The name is unlinked right away. The mapping lives on through the
+        //   descriptor passed to the client, and is released when both sides unmap it.
+        std::string sharedMemoryName = "/StereoVisionMultiWay-" + std::to_string(getpid()) + "-" + std::to_string(sessionId);
+        int sharedMemoryFd = shm_open(sharedMemoryName.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (sharedMemoryFd < 0) {
+            throw std::runtime_error("Error: could not create shared memory: " + std::string(strerror(errno)) + ".");
+        }
+        shm_unlink(sharedMemoryName.c_str());
+
+        DisparityServiceSlotLayout_t layout = DisparityServiceProtocol::computeSlotLayout(openMessage.width, openMessage.height);
+        sharedMemorySize = layout.slotSize * openMessage.numSlots;
+
+        void* mapping = MAP_FAILED;
+        if (ftruncate(sharedMemoryFd, sharedMemorySize) == 0) {
+            mapping = mmap(nullptr, sharedMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED, sharedMemoryFd, 0);
+        }
+
+        if (mapping == MAP_FAILED) {
+            close(sharedMemoryFd);
+            throw std::runtime_error("Error: could not map shared memory: " + std::string(strerror(errno)) + ".");
+        }
+        sharedMemory = static_cast<uint8_t*>(mapping);
+
+        DisparityServiceMessage_t reply(openMessage);
+        reply.type = static_cast<uint32_t>(DisparityServiceMessageType::Opened);
+        DisparityServiceProtocol::sendMessage(clientFd, reply, sharedMemoryFd);
+        close(sharedMemoryFd);
+
+        this->processFrames(clientFd, *generator, this->findBackendMutex(parameters.algorithmName), sharedMemory, openMessage);
+    } catch (const std::exception& e) {
+        // The client may already be gone, in which case there is nobody left to tell.
+        try {
+            sendError(clientFd, -1, e.what());
+        } catch (const std::exception&) {
+        }
+    }
+
+    if (sharedMemory != nullptr) {
+        munmap(sharedMemory, sharedMemorySize);
+    }
+
+    if (generator != nullptr) {
+        this->releaseGenerator(parameters, std::move(generator));
+    }
+
+    // The descriptor is closed once the thread is joined, so that it cannot be
+    //   reused by a new client while still keyed in clientThreads_.
+    shutdown(clientFd, SHUT_RDWR);
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->finishedClientFds_.emplace_back(clientFd);
+}
+
+void DisparityServer::processFrames(
+        int clientFd,
+        DisparityMapGenerator& generator,
+        std::mutex* backendMutex,
+        uint8_t* sharedMemory,
+        const DisparityServiceMessage_t& openMessage) {
+    DisparityServiceSlotLayout_t layout = DisparityServiceProtocol::computeSlotLayout(openMessage.width, openMessage.height);
+
+    DisparityServiceMessage_t message;
+    while (DisparityServiceProtocol::receiveMessage(clientFd, message)) {
+        if (message.type == static_cast<uint32_t>(DisparityServiceMessageType::Close)) {
+            return;
+        }
+
+        if (message.type != static_cast<uint32_t>(DisparityServiceMessageType::Submit)) {
+            throw std::runtime_error("Error: unexpected request type " + std::to_string(message.type) + ".");
+        }
+
+        if ((message.slot < 0) || (message.slot >= openMessage.numSlots)) {
+            sendError(clientFd, message.slot, "Error: slot " + std::to_string(message.slot) + " is out of range.");
+            continue;
+        }
+
+        // The generators read and write the shared memory in place.
+        uint8_t* slot = sharedMemory + (layout.slotSize * message.slot);
+        cv::Mat leftImage(openMessage.height, openMessage.width, CV_8UC1, slot + layout.leftImageOffset);
+        cv::Mat rightImage(openMessage.height, openMessage.width, CV_8UC1, slot + layout.rightImageOffset);
+        cv::Mat disparity(openMessage.height, openMessage.width, CV_32FC1, slot + layout.disparityOffset);
+
+        // The time spent waiting for another client's frame is not part of the compute time.
+        std::unique_lock<std::mutex> backendLock;
+        if (backendMutex != nullptr) {
+            backendLock = std::unique_lock<std::mutex>(*backendMutex);
+        }
+
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        try {
+            generator.computeDisparity(leftImage, rightImage, disparity);
+        } catch (const std::exception& e) {
+            backendLock = std::unique_lock<std::mutex>();
+            sendError(clientFd, message.slot, e.what());
+            continue;
+        }
+        std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+        backendLock = std::unique_lock<std::mutex>();
+
+        DisparityServiceMessage_t reply;
+        memset(&reply, 0, sizeof(reply));
+        reply.type = static_cast<uint32_t>(DisparityServiceMessageType::Completed);
+        reply.slot = message.slot;
+        reply.computeTimeMs = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() / 1000.0;
+        DisparityServiceProtocol::sendMessage(clientFd, reply);
+    }
+}
+
+std::unique_ptr<DisparityMapGenerator> DisparityServer::acquireGenerator(
+        const DisparityMapAlgorithmParameters_t& parameters) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        std::multimap<std::string, std::unique_ptr<DisparityMapGenerator>>::iterator it
+            = this->idleGenerators_.find(computeGeneratorKey(parameters));
+
+        if (it != this->idleGenerators_.end()) {
+            std::unique_ptr<DisparityMapGenerator> generator = std::move(it->second);
+            this->idleGenerators_.erase(it);
+            return generator;
+        }
+    }
+
+    // Creating a generator can be slow (e.g. OpenCL context creation), so it happens outside the lock.
+    DisparityMapGeneratorFactory factory;
+    return factory.create(parameters);
+}
+
+void DisparityServer::releaseGenerator(
+        const DisparityMapAlgorithmParameters_t& parameters,
+        std::unique_ptr<DisparityMapGenerator> generator) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->idleGenerators_.emplace(computeGeneratorKey(parameters), std::move(generator));
+}
+
+void DisparityServer::joinFinishedClients() {
+    std::vector<int> finishedClientFds;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        finishedClientFds.swap(this->finishedClientFds_);
+    }
+
+    for (int clientFd : finishedClientFds) {
+        std::map<int, std::thread>::iterator it = this->clientThreads_.find(clientFd);
+        it->second.join();
+
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->clientThreads_.erase(it);
+        close(clientFd);
+    }
+}
+
+std::mutex* DisparityServer::findBackendMutex(const std::string& algorithmName) {
+    // Unknown names fail in acquireGenerator() already.
+    DisparityMapBackendInfo_t info;
+    if ((!DisparityMapBackendRegistry::getInstance().find(algorithmName, info)) || info.reentrant) {
+        return nullptr;
+    }
+
+    return &this->nonReentrantMutex_;
+}
+
+std::string DisparityServer::computeGeneratorKey(const DisparityMapAlgorithmParameters_t& parameters) {
+    std::string algorithmName(parameters.algorithmName);
+    for (char& c : algorithmName) {
+        c = static_cast<char>(toupper(c));
+    }
+
+    return algorithmName
+        + ":" + std::to_string(parameters.blockSize)
+        + ":" + std::to_string(parameters.leftScanSteps)
+        + ":" + std::to_string(parameters.rightScanSteps);
+}
+
+void DisparityServer::sendError(int clientFd, int slot, const std::string& errorMessage) {
+    DisparityServiceMessage_t reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.type = static_cast<uint32_t>(DisparityServiceMessageType::Error);
+    reply.slot = slot;
+    DisparityServiceProtocol::copyString(errorMessage, reply.errorMessage, sizeof(reply.errorMessage));
+    DisparityServiceProtocol::sendMessage(clientFd, reply);
+}
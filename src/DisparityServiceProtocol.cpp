@@ -0,0 +1,177 @@
+#include "../include/DisparityServiceProtocol.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+DisparityServiceSlotLayout_t DisparityServiceProtocol::computeSlotLayout(int width, int height) {
+    const size_t alignment = 64;
+    size_t numPixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+    size_t imageBytes = ((numPixels + alignment - 1) / alignment) * alignment;
+    size_t disparityBytes = ((numPixels * sizeof(float) + alignment - 1) / alignment) * alignment;
+
+    DisparityServiceSlotLayout_t layout;
+    layout.leftImageOffset = 0;
+    layout.rightImageOffset = imageBytes;
+    layout.disparityOffset = 2 * imageBytes;
+    layout.slotSize = (2 * imageBytes) + disparityBytes;
+    return layout;
+}
+
+void DisparityServiceProtocol::sendMessage(
+        int socketFd,
+        const DisparityServiceMessage_t& message,
+        int fileDescriptor) {
+    sendBytes(socketFd, &message, sizeof(message), fileDescriptor);
+}
+
+bool DisparityServiceProtocol::receiveMessage(
+        int socketFd,
+        DisparityServiceMessage_t& message,
+        int* fileDescriptor) {
+    return receiveBytes(socketFd, &message, sizeof(message), fileDescriptor);
+}
+
+void DisparityServiceProtocol::sendBytes(
+        int socketFd,
+        const void* data,
+        size_t size,
+        int fileDescriptor) {
+    struct iovec iov;
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = size;
+
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+
+    // Must be correctly aligned for cmsghdr.
+    union {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+
+    if (fileDescriptor >= 0) {
+        header.msg_control = control.buffer;
+        header.msg_controllen = sizeof(control.buffer);
+
+        struct cmsghdr* controlMessage = CMSG_FIRSTHDR(&header);
+        controlMessage->cmsg_level = SOL_SOCKET;
+        controlMessage->cmsg_type = SCM_RIGHTS;
+        controlMessage->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(controlMessage), &fileDescriptor, sizeof(int));
+    }
+
+    // The descriptor travels with the first chunk. The rest of a partial send is finished off without it.
+    ssize_t sent;
+    do {
+        sent = sendmsg(socketFd, &header, MSG_NOSIGNAL);
+    } while ((sent < 0) && (errno == EINTR));
+
+    if (sent < 0) {
+        throw std::runtime_error("Error: could not send on socket: " + std::string(strerror(errno)) + ".");
+    }
+
+    const char* remaining = static_cast<const char*>(data) + sent;
+    size_t remainingBytes = size - sent;
+    while (remainingBytes > 0) {
+        sent = send(socketFd, remaining, remainingBytes, MSG_NOSIGNAL);
+        if ((sent < 0) && (errno == EINTR)) {
+            continue;
+        }
+
+        if (sent <= 0) {
+            throw std::runtime_error("Error: could not send on socket: " + std::string(strerror(errno)) + ".");
+        }
+
+        remaining += sent;
+        remainingBytes -= sent;
+    }
+}
+
+bool DisparityServiceProtocol::receiveBytes(
+        int socketFd,
+        void* data,
+        size_t size,
+        int* fileDescriptor) {
+    if (fileDescriptor != nullptr) {
+        *fileDescriptor = -1;
+    }
+
+    char* destination = static_cast<char*>(data);
+    size_t receivedBytes = 0;
+
+    while (receivedBytes < size) {
+        struct iovec iov;
+        iov.iov_base = destination + receivedBytes;
+        iov.iov_len = size - receivedBytes;
+
+        union {
+            char buffer[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+
+        struct msghdr header;
+        memset(&header, 0, sizeof(header));
+        header.msg_iov = &iov;
+        header.msg_iovlen = 1;
+        header.msg_control = control.buffer;
+        header.msg_controllen = sizeof(control.buffer);
+
+        ssize_t received = recvmsg(socketFd, &header, MSG_CMSG_CLOEXEC);
+        if ((received < 0) && (errno == EINTR)) {
+            continue;
+        }
+
+        if (received < 0) {
+            throw std::runtime_error("Error: could not receive on socket: " + std::string(strerror(errno)) + ".");
+        }
+
+        if (received == 0) {
+            if (receivedBytes == 0) {
+                return false;
+            }
+
+            throw std::runtime_error("Error: the connection closed mid-message.");
+        }
+
+        for (struct cmsghdr* controlMessage = CMSG_FIRSTHDR(&header);
+                controlMessage != nullptr;
+                controlMessage = CMSG_NXTHDR(&header, controlMessage)) {
+            if ((controlMessage->cmsg_level == SOL_SOCKET) && (controlMessage->cmsg_type == SCM_RIGHTS)) {
+                int receivedFd;
+                memcpy(&receivedFd, CMSG_DATA(controlMessage), sizeof(int));
+
+                if (fileDescriptor != nullptr) {
+                    *fileDescriptor = receivedFd;
+                } else {
+                    close(receivedFd);
+                }
+            }
+        }
+
+        receivedBytes += received;
+    }
+
+    return true;
+}
+
+void DisparityServiceProtocol::copyString(const std::string& source, char* destination, size_t destinationSize) {
+    size_t length = std::min(source.size(), destinationSize - 1);
+    memcpy(destination, source.data(), length);
+    destination[length] = '\0';
+}
+
+std::string DisparityServiceProtocol::getDefaultSocketPath() {
+    const char* runtimeDirectory = getenv("XDG_RUNTIME_DIR");
+    if ((runtimeDirectory != nullptr) && (runtimeDirectory[0] != '\0')) {
+        return std::string(runtimeDirectory) + "/StereoVisionMultiWay.sock";
+    }
+
+    return "/tmp/StereoVisionMultiWay.sock";
+}
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <omp.h>
+#include <stdexcept>
+#include <string>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include "../include/DisparityMapAlgorithmParameters.hpp"
+#include "../include/DisparityMapGenerator.hpp"
+#include "../include/DisparityMapGeneratorFactory.hpp"
+#include "../include/DisparityServiceProtocol.hpp"
+#include "../include/SharedMemoryShardTransport.hpp"
+#include "../include/SocketShardTransport.hpp"
+
+// Computes one band. The generator is kept across requests, and only recreated when the parameters change.
+void computeBand(
+        const ShardRequest_t& request,
+        const cv::Mat& leftRows,
+        const cv::Mat& rightRows,
+        std::unique_ptr<DisparityMapGenerator>& generator,
+        DisparityMapAlgorithmParameters_t& parameters,
+        cv::Mat& disparity,
+        ShardResult_t& result) {
+    std::string algorithmName(request.algorithmName, strnlen(request.algorithmName, sizeof(request.algorithmName)));
+
+    if ((generator == nullptr) || (parameters.algorithmName != algorithmName)) {
+        parameters.algorithmName = algorithmName;
+        parameters.blockSize = request.blockSize;
+        parameters.leftScanSteps = request.leftScanSteps;
+        parameters.rightScanSteps = request.rightScanSteps;
+
+        DisparityMapGeneratorFactory factory;
+        generator = factory.create(parameters);
+    } else if ((parameters.blockSize != request.blockSize)
+        || (parameters.leftScanSteps != request.leftScanSteps)
+        || (parameters.rightScanSteps != request.rightScanSteps)) {
+        parameters.blockSize = request.blockSize;
+        parameters.leftScanSteps = request.leftScanSteps;
+        parameters.rightScanSteps = request.rightScanSteps;
+        generator->setParameters(parameters);
+    }
+
+    disparity.create(request.inputRows, request.width, CV_32FC1);
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    generator->computeDisparity(leftRows, rightRows, disparity);
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+    result.computeTimeMs = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() / 1000.0;
+}
+
+int main(int argc, char** argv) {
+
+    const cv::String commandLineKeys = 
+        "{help h usage ? |              | This program computes row bands for the Sharded algorithm. It is normally started by the coordinator.}"
+        "{transport      | sharedMemory | The transport to use: sharedMemory or socket.}"
+        "{fd             |           -1 | For sharedMemory, the inherited Unix socket connected to the coordinator.}"
+        "{connect        |              | For socket, the coordinator's host:port.}"
+        "{numThreads     |            0 | The number of OpenMP threads to use. 0 keeps the runtime default.}";
+
+    cv::CommandLineParser parser(argc, argv, commandLineKeys);
+
+    if (!parser.check()) {
+        parser.printMessage();
+        parser.printErrors();
+        return 1;
+    }
+
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 1;
+    }
+
+    std::string transportName = std::string(parser.get<cv::String>("transport"));
+    int numThreads = parser.get<int>("numThreads");
+    if (numThreads > 0) {
+        omp_set_num_threads(numThreads);
+    }
+
+    std::unique_ptr<ShardTransport> transport;
+    if (transportName == "sharedMemory") {
+        int fd = parser.get<int>("fd");
+        if (fd < 0) {
+            throw std::runtime_error("Error. --fd is required for the sharedMemory transport.");
+        }
+
+        transport = std::make_unique<SharedMemoryShardTransport>(fd);
+    } else if (transportName == "socket") {
+        std::string address = std::string(parser.get<cv::String>("connect"));
+        transport = std::make_unique<SocketShardTransport>(SocketShardTransport::connectTo(address));
+    } else {
+        throw std::runtime_error("Error. Unrecognized transport '" + transportName + "'.");
+    }
+
+    std::unique_ptr<DisparityMapGenerator> generator;
+    DisparityMapAlgorithmParameters_t parameters;
+    cv::Mat disparity;
+    cv::Mat leftRows;
+    cv::Mat rightRows;
+    ShardRequest_t request;
+
+    while (transport->receiveRequest(request, leftRows, rightRows)) {
+        if (request.type == static_cast<uint32_t>(ShardRequestType::Shutdown)) {
+            break;
+        }
+
+        ShardResult_t result;
+        memset(&result, 0, sizeof(result));
+        result.width = request.width;
+        result.outputRows = request.outputRows;
+
+        try {
+            computeBand(request, leftRows, rightRows, generator, parameters, disparity, result);
+        } catch (const std::exception& e) {
+            // setParameters() may have kept the rejected parameters, so the generator is created again.
+            generator.reset();
+            result.status = 1;
+            DisparityServiceProtocol::copyString(e.what(), result.errorMessage, sizeof(result.errorMessage));
+        }
+
+        cv::Mat outputRows = (result.status == 0)
+            ? disparity.rowRange(request.outputRowOffset, request.outputRowOffset + request.outputRows)
+            : cv::Mat();
+        transport->sendResult(result, outputRows);
+    }
+
+    return 0;
+}
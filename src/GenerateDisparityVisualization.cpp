@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -11,18 +12,39 @@
 #include "../include/DisparityMapAlgorithmParameters.hpp"
 #include "../include/DisparityMapGenerator.hpp"
 #include "../include/DisparityMapGeneratorFactory.hpp"
+#include "../include/DisparityProjector.hpp"
+#include "../include/GrayscaleConverter.hpp"
+#include "../include/OpenMpThreadedSimdDisparityMapGenerator.hpp"
+#include "../include/PointCloudWriter.hpp"
 
 int main(int argc, char** argv) {
 
     const cv::String commandLineKeys = 
-        "{help h usage ?  |                         | This program takes in two images and generates a disparity map.}"
-        "{leftImage       |                  <none> | The left image to process.}"
-        "{rightImage      |                  <none> | The right image to proces.}"
-        "{algorithmName   |                  <none> | The algorithm name to use.}"
-        "{outputPath      |           disparity.png | The output path to which to write the image.}"
-        "{blockSize       |                       7 | The maximum block size to use for matching.}"
-        "{leftScanSteps   |                      50 | The number of blocks to scan to the left.}"
-        "{rightScanSteps  |                      50 | The number of blocks to scan to the right.}";
+        "{help h usage ?        |                         | This program takes in two images and generates a disparity map.}"
+        "{leftImage             |                  <none> | The left image to process.}"
+        "{rightImage            |                  <none> | The right image to proces.}"
+        "{algorithmName         |                  <none> | The algorithm name to use.}"
+        "{outputPath            |           disparity.png | The output path to which to write the image.}"
+        "{blockSize             |                       7 | The maximum block size to use for matching.}"
+        "{leftScanSteps         |                      50 | The number of blocks to scan to the left.}"
+        "{rightScanSteps        |                      50 | The number of blocks to scan to the right.}"
+        "{rectificationMaps     |                         | Fixed-point remap tables (leftMap1, leftMap2, rightMap1, rightMap2) to rectify the raw input with. OpenMPSimd only.}"
+        "{colorInput            |                   false | Pass 3-channel BGR images to the generator, which converts them to gray itself.}"
+        "{subpixelInterpolation |               parabolic | Subpixel fit: parabolic, equiangular or none. Only OpenMPSimd supports other than parabolic.}"
+        "{medianFilterSize      |                       0 | Median filter the disparity: 0 (off), 3 or 5. OpenMPSimd only.}"
+        "{speckleMaxSize        |                       0 | Remove similar regions of at most this many pixels. 0 disables it. OpenMPSimd only.}"
+        "{speckleMaxDifference  |                       1 | The largest disparity step within a speckle region.}"
+        "{confidenceMeasure     |                    none | Rate each match while searching: none, peakRatio or curvature. OpenMPSimd only.}"
+        "{minConfidence         |                       0 | Matches below this confidence are left unrefined and out of point clouds.}"
+        "{confidencePath        |                         | Optionally write the confidence as an 8-bit PNG, scaled to its maximum.}"
+        "{focalLength           |                       0 | Focal length of the rectified pair in pixels, for depth and point cloud output.}"
+        "{baseline              |                       0 | Baseline of the rectified pair. Depth and points are in its units.}"
+        "{principalPointX       |                      -1 | Principal point column. Negative selects the image centre.}"
+        "{principalPointY       |                      -1 | Principal point row. Negative selects the image centre.}"
+        "{minProjectedDisparity |                       0 | Pixels with a disparity at or below this are left out of depth and point clouds.}"
+        "{depthPath             |                         | Optionally write depth as a 16-bit PNG, in thousandths of the baseline unit.}"
+        "{pointCloudPath        |                         | Optionally write the points of valid pixels to this file.}"
+        "{pointCloudFormat      |                     ply | The point cloud format: ply (binary) or raw (packed float x, y, z, intensity).}";
 
     cv::CommandLineParser parser(argc, argv, commandLineKeys);
 
@@ -44,10 +66,27 @@ int main(int argc, char** argv) {
     parameters.blockSize = parser.get<int>("blockSize");
     parameters.leftScanSteps = parser.get<int>("leftScanSteps");
     parameters.rightScanSteps = parser.get<int>("rightScanSteps");
+    parameters.subpixelInterpolation = std::string(parser.get<cv::String>("subpixelInterpolation"));
+    parameters.medianFilterSize = parser.get<int>("medianFilterSize");
+    parameters.speckleMaxSize = parser.get<int>("speckleMaxSize");
+    parameters.speckleMaxDifference = parser.get<float>("speckleMaxDifference");
+    parameters.confidenceMeasure = std::string(parser.get<cv::String>("confidenceMeasure"));
+    parameters.minConfidence = parser.get<float>("minConfidence");
+    parameters.focalLength = parser.get<double>("focalLength");
+    parameters.baseline = parser.get<double>("baseline");
+    parameters.principalPointX = parser.get<double>("principalPointX");
+    parameters.principalPointY = parser.get<double>("principalPointY");
+    parameters.minProjectedDisparity = parser.get<float>("minProjectedDisparity");
+    std::string confidencePath = std::string(parser.get<cv::String>("confidencePath"));
+    std::string depthPath = std::string(parser.get<cv::String>("depthPath"));
+    std::string pointCloudPath = std::string(parser.get<cv::String>("pointCloudPath"));
+    std::string pointCloudFormat = std::string(parser.get<cv::String>("pointCloudFormat"));
     parameters.leftImageFilePath = std::string(parser.get<cv::String>("leftImage"));
     parameters.rightImageFilePath = std::string(parser.get<cv::String>("rightImage"));
     parameters.outputPath = std::string(parser.get<cv::String>("outputPath"));
     parameters.algorithmName = std::string(parser.get<cv::String>("algorithmName"));
+    parameters.rectificationMapsPath = std::string(parser.get<cv::String>("rectificationMaps"));
+    int imreadFlags = parser.get<bool>("colorInput") ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
 
     std::cout << "Creating disparity generator..." << std::endl;
 
@@ -63,7 +102,7 @@ int main(int argc, char** argv) {
         << "'..." 
         << std::endl;
 
-    cv::Mat leftImage = cv::imread(parameters.leftImageFilePath, cv::IMREAD_GRAYSCALE);
+    cv::Mat leftImage = cv::imread(parameters.leftImageFilePath, imreadFlags);
     
     std::cout 
         << "Reading in right image from '" 
@@ -71,7 +110,7 @@ int main(int argc, char** argv) {
         << "'..." 
         << std::endl;
 
-    cv::Mat rightImage = cv::imread(parameters.rightImageFilePath, cv::IMREAD_GRAYSCALE);
+    cv::Mat rightImage = cv::imread(parameters.rightImageFilePath, imreadFlags);
 
     if ((leftImage.rows == 0)
             ||
@@ -106,8 +145,98 @@ int main(int argc, char** argv) {
 
     cv::Mat disparityImage(leftImage.rows, leftImage.cols, CV_32FC1);
 
+    // OpenMPSimd projects depth and streams the points out as it finishes each strip.
+    //   The others are projected afterwards.
+    OpenMpThreadedSimdDisparityMapGenerator* streamingGenerator =
+        dynamic_cast<OpenMpThreadedSimdDisparityMapGenerator*>(generator.get());
+    if ((streamingGenerator != nullptr) && (!depthPath.empty())) {
+        streamingGenerator->setDepthOutputEnabled(true);
+    }
+
+    std::shared_ptr<PointCloudWriter> pointCloudWriter;
+    if (!pointCloudPath.empty()) {
+        pointCloudWriter = std::make_shared<PointCloudWriter>(
+            pointCloudPath,
+            PointCloudWriter::parseFormat(pointCloudFormat));
+
+        if (streamingGenerator != nullptr) {
+            streamingGenerator->setPointCloudWriter(pointCloudWriter);
+        }
+    }
+
     generator->computeDisparity(leftImage, rightImage, disparityImage);
 
+    if (pointCloudWriter != nullptr) {
+        if (streamingGenerator == nullptr) {
+            cv::Mat leftGrayImage;
+            std::vector<PointXYZI_t> points;
+            DisparityProjector::fromParameters(parameters, disparityImage.rows, disparityImage.cols).projectRows(
+                disparityImage,
+                GrayscaleConverter::ensureGray(leftImage, leftGrayImage),
+                cv::Mat(),
+                0.0f,
+                0,
+                disparityImage.rows,
+                points);
+            pointCloudWriter->writePoints(points.data(), points.size());
+        }
+
+        pointCloudWriter->close();
+        std::cout << "Wrote " << pointCloudWriter->getNumPoints() << " points to " << pointCloudPath << "." << std::endl;
+    }
+
+    if (!confidencePath.empty()) {
+        OpenMpThreadedSimdDisparityMapGenerator* ratingGenerator =
+            dynamic_cast<OpenMpThreadedSimdDisparityMapGenerator*>(generator.get());
+        if ((ratingGenerator == nullptr) || ratingGenerator->getConfidence().empty()) {
+            throw std::runtime_error("Error. A confidence output needs the OpenMPSimd algorithm and a confidence measure.");
+        }
+
+        const cv::Mat& confidence = ratingGenerator->getConfidence();
+        float maxConfidence = 0.0f;
+        for (int y = 0; y < confidence.rows; y++) {
+            for (int x = 0; x < confidence.cols; x++) {
+                maxConfidence = std::max(confidence.at<float>(y, x), maxConfidence);
+            }
+        }
+
+        float scale = (maxConfidence > 0.0f) ? (255.0f / maxConfidence) : 0.0f;
+        cv::Mat confidenceImage(confidence.rows, confidence.cols, CV_8UC1);
+        for (int y = 0; y < confidence.rows; y++) {
+            for (int x = 0; x < confidence.cols; x++) {
+                confidenceImage.at<uint8_t>(y, x) = static_cast<uint8_t>(std::round(confidence.at<float>(y, x) * scale));
+            }
+        }
+
+        std::cout << "Writing confidence to " << confidencePath << "..." << std::endl;
+        cv::imwrite(confidencePath, confidenceImage);
+    }
+
+    if (!depthPath.empty()) {
+        cv::Mat depth;
+        if (streamingGenerator != nullptr) {
+            depth = streamingGenerator->getDepth();
+        } else {
+            depth.create(disparityImage.rows, disparityImage.cols, CV_32FC1);
+            DisparityProjector::fromParameters(parameters, disparityImage.rows, disparityImage.cols).computeDepthRows(
+                disparityImage,
+                0,
+                disparityImage.rows,
+                depth);
+        }
+
+        cv::Mat depthImage(depth.rows, depth.cols, CV_16UC1);
+        for (int y = 0; y < depth.rows; y++) {
+            for (int x = 0; x < depth.cols; x++) {
+                float value = std::round(depth.at<float>(y, x) * 1000.0f);
+                depthImage.at<uint16_t>(y, x) = static_cast<uint16_t>(std::min(value, 65535.0f));
+            }
+        }
+
+        std::cout << "Writing depth to " << depthPath << "..." << std::endl;
+        cv::imwrite(depthPath, depthImage);
+    }
+
     std::cout << "Computation complete. Generating output image..." << std::endl;
     
     float maxDisparity = std::numeric_limits<float>::min();
@@ -0,0 +1,103 @@
+#include "../include/GrayscaleConverter.hpp"
+
+#include <cstring>
+
+void GrayscaleConverter::convertRows(const cv::Mat& image, int minY, int maxY, uint8_t* destination) {
+    ensureSupportedType(image);
+
+    for (int y = minY; y < maxY; y++) {
+        uint8_t* output = destination + ((y - minY) * image.cols);
+
+        if (image.type() == CV_8UC1) {
+            memcpy(output, image.ptr<uint8_t>(y), image.cols * sizeof(uint8_t));
+        } else {
+            convertRowSimd(image.ptr<uint8_t>(y), image.cols, output);
+        }
+    }
+}
+
+const cv::Mat& GrayscaleConverter::ensureGray(const cv::Mat& image, cv::Mat& buffer) {
+    ensureSupportedType(image);
+
+    if (image.type() == CV_8UC1) {
+        return image;
+    }
+
+    buffer.create(image.rows, image.cols, CV_8UC1);
+    convertRows(image, 0, image.rows, buffer.data);
+    return buffer;
+}
+
+void GrayscaleConverter::ensureSupportedType(const cv::Mat& image) {
+    if ((image.type() != CV_8UC1)
+        &&
+        (image.type() != CV_8UC3)) {
+        throw std::runtime_error("Error: input images must be 8-bit grayscale (CV_8UC1) or BGR (CV_8UC3).");
+    }
+}
+
+void GrayscaleConverter::convertRowSimd(const uint8_t* source, int width, uint8_t* destination) {
+    // Byte shuffles that gather one channel of 16 interleaved BGR pixels out of each of
+    //   the three 16-byte chunks they span. -1 zeroes the byte, so the three results can be ORed.
+    const __m128i blueShuffle0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i blueShuffle1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i blueShuffle2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i greenShuffle0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i greenShuffle1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i greenShuffle2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i redShuffle0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i redShuffle1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i redShuffle2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+    // Blue and green are weighted together by one madd, red and the rounding term by another.
+    const __m256i blueGreenWeights = _mm256_set1_epi32((GREEN_WEIGHT << 16) | BLUE_WEIGHT);
+    const __m256i redRoundingWeights = _mm256_set1_epi32(((1 << (WEIGHT_BITS - 1)) << 16) | RED_WEIGHT);
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    int x = 0;
+    for (; x + SIMD_PIXELS <= width; x += SIMD_PIXELS) {
+        const uint8_t* pixels = source + (3 * x);
+        __m128i chunk0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels));
+        __m128i chunk1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + 16));
+        __m128i chunk2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + 32));
+
+        __m128i blue = _mm_or_si128(
+            _mm_or_si128(_mm_shuffle_epi8(chunk0, blueShuffle0), _mm_shuffle_epi8(chunk1, blueShuffle1)),
+            _mm_shuffle_epi8(chunk2, blueShuffle2));
+        __m128i green = _mm_or_si128(
+            _mm_or_si128(_mm_shuffle_epi8(chunk0, greenShuffle0), _mm_shuffle_epi8(chunk1, greenShuffle1)),
+            _mm_shuffle_epi8(chunk2, greenShuffle2));
+        __m128i red = _mm_or_si128(
+            _mm_or_si128(_mm_shuffle_epi8(chunk0, redShuffle0), _mm_shuffle_epi8(chunk1, redShuffle1)),
+            _mm_shuffle_epi8(chunk2, redShuffle2));
+
+        __m256i blueWide = _mm256_cvtepu8_epi16(blue);
+        __m256i greenWide = _mm256_cvtepu8_epi16(green);
+        __m256i redWide = _mm256_cvtepu8_epi16(red);
+
+        // unpacklo holds pixels 0-3 and 8-11, unpackhi pixels 4-7 and 12-15.
+        __m256i lumaLow = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(blueWide, greenWide), blueGreenWeights),
+            _mm256_madd_epi16(_mm256_unpacklo_epi16(redWide, ones), redRoundingWeights));
+        __m256i lumaHigh = _mm256_add_epi32(
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(blueWide, greenWide), blueGreenWeights),
+            _mm256_madd_epi16(_mm256_unpackhi_epi16(redWide, ones), redRoundingWeights));
+
+        // Packing within each 128-bit lane puts the pixels back in order,
+        //   leaving 0-7 in the low quadword of lane 0 and 8-15 in that of lane 1.
+        __m256i luma16 = _mm256_packus_epi32(
+            _mm256_srli_epi32(lumaLow, WEIGHT_BITS),
+            _mm256_srli_epi32(lumaHigh, WEIGHT_BITS));
+        __m256i luma8 = _mm256_packus_epi16(luma16, luma16);
+        luma8 = _mm256_permute4x64_epi64(luma8, _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(destination + x),
+            _mm256_castsi256_si128(luma8));
+    }
+
+    for (; x < width; x++) {
+        const uint8_t* pixel = source + (3 * x);
+        destination[x] = toGray(pixel[0], pixel[1], pixel[2]);
+    }
+}
@@ -0,0 +1,152 @@
+#include "../include/HybridDisparityMapGenerator.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
+
+#include <chrono>
+#include <future>
+
+HybridDisparityMapGenerator::HybridDisparityMapGenerator(
+        const DisparityMapAlgorithmParameters_t& parameters)
+        : parameters_(parameters) {
+    this->ensureParametersValid();
+
+    // The CPU path always computes the full disparity for its rows.
+    DisparityMapAlgorithmParameters_t cpuParameters(parameters);
+    cpuParameters.incrementalTileSize = 0;
+
+    this->openClGenerator_ = std::make_unique<OpenClDisparityMapGenerator>(parameters);
+    this->cpuGenerator_ = std::make_unique<OpenMpThreadedSimdDisparityMapGenerator>(cpuParameters);
+    this->openClRowFraction_ = parameters.hybridOpenClRowFraction;
+}
+
+void HybridDisparityMapGenerator::setParameters(
+        const DisparityMapAlgorithmParameters_t& parameters) {
+    this->parameters_ = parameters;
+    this->ensureParametersValid();
+
+    DisparityMapAlgorithmParameters_t cpuParameters(parameters);
+    cpuParameters.incrementalTileSize = 0;
+
+    this->openClGenerator_->setParameters(parameters);
+    this->cpuGenerator_->setParameters(cpuParameters);
+
+    // The cost per row depends on the parameters, so the old measurements no longer apply.
+    this->openClRowFraction_ = parameters.hybridOpenClRowFraction;
+    this->openClRowsPerSecond_ = 0;
+    this->cpuRowsPerSecond_ = 0;
+}
+
+const DisparityMapAlgorithmParameters_t& HybridDisparityMapGenerator::getParameters() const {
+    return this->parameters_;
+}
+
+void HybridDisparityMapGenerator::computeDisparity(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        cv::Mat& disparity) {
+    // OpenCL takes the top rows, the CPU the rest.
+    // Both read the whole image, so the seam rows match either backend run alone.
+    int openClRows = this->computeOpenClRows(leftImage.rows);
+    int cpuRows = leftImage.rows - openClRows;
+
+    // Both sides write into the disparity at once, so it must not be reallocated under either.
+    disparity.create(leftImage.rows, leftImage.cols, CV_32FC1);
+
+    // The OpenCL side runs on its own thread, so that its completion time
+    //   can be measured while the OpenMP threads work on the CPU rows.
+    std::future<double> openClSeconds = std::async(
+        std::launch::async,
+        [this, &leftImage, &rightImage, &disparity, openClRows]() {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            if (openClRows > 0) {
+                this->openClGenerator_->enqueueDisparity(leftImage, rightImage, 0, openClRows);
+                this->openClGenerator_->dequeueDisparity(disparity);
+            }
+            std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double>(end - start).count();
+        });
+
+    std::chrono::high_resolution_clock::time_point cpuStart = std::chrono::high_resolution_clock::now();
+    if (cpuRows > 0) {
+        std::vector<cv::Rect> cpuRegion(1, cv::Rect(0, openClRows, leftImage.cols, cpuRows));
+        this->cpuGenerator_->computeDisparityAt(leftImage, rightImage, cpuRegion, disparity);
+    }
+    std::chrono::high_resolution_clock::time_point cpuEnd = std::chrono::high_resolution_clock::now();
+    double cpuSeconds = std::chrono::duration<double>(cpuEnd - cpuStart).count();
+
+    // get() rethrows any OpenCL error on this thread.
+    this->updateRowFraction(openClRows, openClSeconds.get(), cpuRows, cpuSeconds);
+}
+
+double HybridDisparityMapGenerator::getOpenClRowFraction() const {
+    return this->openClRowFraction_;
+}
+
+void HybridDisparityMapGenerator::ensureParametersValid() {
+    if ((this->parameters_.hybridOpenClRowFraction < 0)
+        ||
+        (this->parameters_.hybridOpenClRowFraction > 1)) {
+        throw std::runtime_error("Error: the hybrid OpenCL row fraction must be between 0 and 1.");
+    }
+}
+
+int HybridDisparityMapGenerator::computeOpenClRows(int imageHeight) const {
+    // A fraction of exactly 0 or 1 runs one side alone, and is never adapted.
+    if (this->openClRowFraction_ <= 0) {
+        return 0;
+    }
+
+    if (this->openClRowFraction_ >= 1) {
+        return imageHeight;
+    }
+
+    int minRows = std::min(MIN_ROWS_PER_SIDE, imageHeight / 2);
+    int openClRows = static_cast<int>((this->openClRowFraction_ * imageHeight) + 0.5);
+
+    return std::max(minRows, std::min(imageHeight - minRows, openClRows));
+}
+
+void HybridDisparityMapGenerator::updateRowFraction(
+        int openClRows,
+        double openClSeconds,
+        int cpuRows,
+        double cpuSeconds) {
+    if ((openClRows == 0) || (cpuRows == 0) || (openClSeconds <= 0) || (cpuSeconds <= 0)) {
+        return;
+    }
+
+    // Smooth the measured throughputs, so that a single noisy frame does not swing the split.
+    double openClRowsPerSecond = openClRows / openClSeconds;
+    double cpuRowsPerSecond = cpuRows / cpuSeconds;
+
+    this->openClRowsPerSecond_ = (this->openClRowsPerSecond_ > 0)
+        ? (0.5 * this->openClRowsPerSecond_) + (0.5 * openClRowsPerSecond)
+        : openClRowsPerSecond;
+    this->cpuRowsPerSecond_ = (this->cpuRowsPerSecond_ > 0)
+        ? (0.5 * this->cpuRowsPerSecond_) + (0.5 * cpuRowsPerSecond)
+        : cpuRowsPerSecond;
+
+    // Both sides finish together when each one's share of rows matches its share of throughput.
+    this->openClRowFraction_ = this->openClRowsPerSecond_ / (this->openClRowsPerSecond_ + this->cpuRowsPerSecond_);
+}
+
+static DisparityMapBackendInfo_t createBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "Hybrid";
+    info.description = "Splits rows between OpenCL and OpenMPSimd, balanced by their measured speed.";
+    info.requiredInstructionSets = { "avx2" };
+    info.requiredDevices = { "opencl" };
+    info.isDeviceAvailable = []() { return !OpenClDisparityMapGenerator::listAvailableDevices().empty(); };
+    // The smaller limits of the two sides, which are OpenMPSimd's.
+    info.maxDisparityRange = OpenMpThreadedSimdDisparityMapGenerator::MAX_DISPARITY_RANGE;
+    info.maxBlockSize = OpenMpThreadedSimdDisparityMapGenerator::MAX_BLOCK_SIZE;
+    info.fixedCostMs = 1.5;
+    info.nanosecondsPerComparison = 0.004;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<HybridDisparityMapGenerator>(parameters);
+    };
+    return info;
+}
+
+static DisparityMapBackendRegistration registration(createBackendInfo());
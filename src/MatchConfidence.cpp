@@ -0,0 +1,19 @@
+#include "../include/MatchConfidence.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+ConfidenceMeasure MatchConfidence::parse(const std::string& name) {
+    std::string lowerName(name);
+    std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+
+    if (lowerName == "none") {
+        return ConfidenceMeasure::None;
+    } else if (lowerName == "peakratio") {
+        return ConfidenceMeasure::PeakRatio;
+    } else if (lowerName == "curvature") {
+        return ConfidenceMeasure::Curvature;
+    }
+
+    throw std::runtime_error("Error: unrecognized confidence measure '" + name + "'. Valid options are 'none', 'peakRatio' and 'curvature'.");
+}
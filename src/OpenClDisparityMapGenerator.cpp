@@ -1,22 +1,28 @@
 #include "../include/OpenClDisparityMapGenerator.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
+#include "OpenClFunctionsSource.hpp"
 
+#include <cstring>
 #include <iostream>
 
 OpenClDisparityMapGenerator::OpenClDisparityMapGenerator(
-        const DisparityMapAlgorithmParameters_t& parameters)
-        : parameters_(parameters) {
+        const DisparityMapAlgorithmParameters_t& parameters,
+        OpenClKernelVariant kernelVariant)
+        : parameters_(parameters), kernelVariant_(kernelVariant) {
     this->ensureParametersValid();
 }
 
 OpenClDisparityMapGenerator::~OpenClDisparityMapGenerator() {
-    if (this->openClKernelCreated_) {
-        this->cleanOclKernel();
-        this->openClKernelCreated_ = false;
+    if (this->openClContextCreated_) {
+        this->cleanOcl();
+        this->openClContextCreated_ = false;
     }
 }
 
 void OpenClDisparityMapGenerator::setParameters(
         const DisparityMapAlgorithmParameters_t& parameters) {
+    // Device selection is fixed once the first frame has been processed.
+    // The specialized kernel for the new parameters is picked up (or built) on the next frame.
     this->parameters_ = parameters;
     this->ensureParametersValid();
 }
@@ -29,58 +35,186 @@ void OpenClDisparityMapGenerator::computeDisparity(
         const cv::Mat& leftImage,
         const cv::Mat& rightImage,
         cv::Mat& disparity) {
-    if (!this->openClKernelCreated_) {
-        this->imageWidth_ = leftImage.cols;
-        this->imageHeight_ = leftImage.rows;
-        this->initializeOclKernel();
+    if (this->numFramesInFlight_ > 0) {
+        throw std::runtime_error("Error: computeDisparity() called while frames are in flight. Dequeue them first.");
     }
-    
-    size_t numPixels = this->imageWidth_ * this->imageHeight_;
-    size_t localItemSize = 100;
 
-    cl_int ret = clEnqueueWriteBuffer(
-        this->oclCommandQueue_,       
-        this->oclLeftImageData_,
-        CL_TRUE,                     // blocking write
-        0,                           // offset
-        numPixels * sizeof(uint8_t), // size
-        leftImage.data,              // buffer
-        0,                           // num_events_in_wait_list
-        NULL,                        // event_wait_list
-        NULL);                       // event
+    this->enqueueDisparity(leftImage, rightImage);
+    this->dequeueDisparity(disparity);
+}
 
-    ret = clEnqueueWriteBuffer(
-        this->oclCommandQueue_,       
-        this->oclRightImageData_,
-        CL_TRUE,                     // blocking write
-        0,                           // offset
-        numPixels * sizeof(uint8_t), // size
-        rightImage.data,             // buffer
-        0,                           // num_events_in_wait_list
-        NULL,                        // event_wait_list
-        NULL);                       // event
-
-    ret = clEnqueueNDRangeKernel(
-        this->oclCommandQueue_,
-        this->oclKernel_,
-        1,              // dimensions
-        NULL,           // global work offset
-        &numPixels,     // global work size
-        &localItemSize, // local work size
-        0,              // num_events_in_wait_list
-        NULL,           // event_wait_list (NULL == don't wait)
-        NULL);          // event (could be used in another kernel's wait_list)
+void OpenClDisparityMapGenerator::enqueueDisparity(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage) {
+    this->enqueueDisparity(leftImage, rightImage, 0, leftImage.rows);
+}
 
-    ret = clEnqueueReadBuffer(
-        this->oclCommandQueue_,
-        this->oclDisparityData_,
-        CL_TRUE,                    // blocking read
-        0,                          // offset
-        numPixels * sizeof(float),  // size
-        disparity.data,             // output data
-        0,                          // num_events_in_wait_list
-        NULL,                       // event_wait_list
-        NULL);                      // event
+void OpenClDisparityMapGenerator::enqueueDisparity(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        int rowMinY,
+        int numRows) {
+    if ((rowMinY < 0) || (numRows < 0) || (rowMinY + numRows > leftImage.rows)) {
+        throw std::runtime_error("Error: the requested rows are outside the image.");
+    }
+
+    GrayscaleConverter::ensureSupportedType(leftImage);
+    GrayscaleConverter::ensureSupportedType(rightImage);
+
+    if (!this->openClContextCreated_) {
+        this->initializeOclDevices();
+    }
+
+    this->ensureBufferSetsAllocated(leftImage.cols, leftImage.rows);
+
+    if (this->numFramesInFlight_ >= this->numBufferSets_) {
+        throw std::runtime_error("Error: all OpenCL buffer sets are in flight. Dequeue a frame first.");
+    }
+
+    int bufferSetIndex = (this->nextBufferSet_ + this->numFramesInFlight_) % this->numBufferSets_;
+    std::vector<int> bandRows = this->computeBandRows(numRows);
+
+    int bandMinY = rowMinY;
+    try {
+        for (size_t i = 0; i < this->oclDevices_.size(); i++) {
+            OclBufferSet_t& bufferSet = this->oclDevices_[i].bufferSets[bufferSetIndex];
+            bufferSet.bandMinY = bandMinY;
+            bufferSet.bandNumRows = bandRows[i];
+
+            if (bandRows[i] > 0) {
+                this->enqueueBand(
+                    this->oclDevices_[i],
+                    bufferSet,
+                    bandMinY,
+                    bandRows[i],
+                    leftImage,
+                    rightImage);
+            }
+
+            bandMinY += bandRows[i];
+        }
+    } catch (const std::exception&) {
+        // The frame never goes in flight, so no dequeue would release the bands already enqueued.
+        for (OclDevice_t& device : this->oclDevices_) {
+            this->releaseBandEvents(device.bufferSets[bufferSetIndex]);
+        }
+
+        throw;
+    }
+
+    this->numFramesInFlight_++;
+}
+
+void OpenClDisparityMapGenerator::dequeueDisparity(cv::Mat& disparity) {
+    if (this->numFramesInFlight_ == 0) {
+        throw std::runtime_error("Error: no OpenCL frames are in flight.");
+    }
+
+    // The image size cannot change while frames are in flight, so it is the size of this frame too.
+    disparity.create(this->imageHeight_, this->imageWidth_, CV_32FC1);
+
+    for (OclDevice_t& device : this->oclDevices_) {
+        OclBufferSet_t& bufferSet = device.bufferSets[this->nextBufferSet_];
+        if (bufferSet.bandNumRows == 0) {
+            continue;
+        }
+
+        cl_int ret = clWaitForEvents(1, &bufferSet.readEvent);
+        if (ret != CL_SUCCESS) {
+            // The frame is dropped, so that its events are released and the next one can still be dequeued.
+            for (OclDevice_t& droppedDevice : this->oclDevices_) {
+                this->releaseBandEvents(droppedDevice.bufferSets[this->nextBufferSet_]);
+            }
+
+            this->nextBufferSet_ = (this->nextBufferSet_ + 1) % this->numBufferSets_;
+            this->numFramesInFlight_--;
+            this->checkOclError(ret, "clWaitForEvents");
+        }
+
+        // Row by row, since the disparity may be a region of a larger Mat.
+        for (int y = 0; y < bufferSet.bandNumRows; y++) {
+            memcpy(
+                disparity.ptr<float>(bufferSet.bandMinY + y),
+                bufferSet.disparityHost + (static_cast<size_t>(y) * this->imageWidth_),
+                this->imageWidth_ * sizeof(float));
+        }
+
+        // Smooth the measured throughput, so that a single noisy frame does not swing the split.
+        cl_ulong kernelStart;
+        cl_ulong kernelEnd;
+        ret = clGetEventProfilingInfo(bufferSet.kernelEvent, CL_PROFILING_COMMAND_START, sizeof(kernelStart), &kernelStart, NULL);
+        ret |= clGetEventProfilingInfo(bufferSet.kernelEvent, CL_PROFILING_COMMAND_END, sizeof(kernelEnd), &kernelEnd, NULL);
+        if ((ret == CL_SUCCESS) && (kernelEnd > kernelStart)) {
+            double rowsPerSecond = bufferSet.bandNumRows * 1e9 / static_cast<double>(kernelEnd - kernelStart);
+            device.rowsPerSecond = (device.rowsPerSecond > 0)
+                ? (0.5 * device.rowsPerSecond) + (0.5 * rowsPerSecond)
+                : rowsPerSecond;
+        }
+
+        this->releaseBandEvents(bufferSet);
+    }
+
+    this->nextBufferSet_ = (this->nextBufferSet_ + 1) % this->numBufferSets_;
+    this->numFramesInFlight_--;
+}
+
+int OpenClDisparityMapGenerator::getNumFramesInFlight() const {
+    return this->numFramesInFlight_;
+}
+
+std::vector<std::string> OpenClDisparityMapGenerator::getDeviceNames() const {
+    std::vector<std::string> names;
+    for (const OclDevice_t& device : this->oclDevices_) {
+        names.emplace_back(device.name);
+    }
+
+    return names;
+}
+
+std::vector<std::string> OpenClDisparityMapGenerator::listAvailableDevices() {
+    std::vector<std::string> descriptions;
+
+    cl_uint numPlatforms = 0;
+    if ((clGetPlatformIDs(0, NULL, &numPlatforms) != CL_SUCCESS) || (numPlatforms == 0)) {
+        return descriptions;
+    }
+
+    std::vector<cl_platform_id> platformIds(numPlatforms);
+    clGetPlatformIDs(numPlatforms, platformIds.data(), NULL);
+
+    for (cl_platform_id platformId : platformIds) {
+        std::string platformName = getOclInfoString(platformId, NULL, CL_PLATFORM_NAME);
+
+        cl_uint numDevices = 0;
+        if ((clGetDeviceIDs(platformId, CL_DEVICE_TYPE_ALL, 0, NULL, &numDevices) != CL_SUCCESS) || (numDevices == 0)) {
+            continue;
+        }
+
+        std::vector<cl_device_id> deviceIds(numDevices);
+        clGetDeviceIDs(platformId, CL_DEVICE_TYPE_ALL, numDevices, deviceIds.data(), NULL);
+
+        for (cl_device_id deviceId : deviceIds) {
+            cl_device_type deviceType = 0;
+            cl_uint computeUnits = 0;
+            clGetDeviceInfo(deviceId, CL_DEVICE_TYPE, sizeof(deviceType), &deviceType, NULL);
+            clGetDeviceInfo(deviceId, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(computeUnits), &computeUnits, NULL);
+
+            std::string typeName = "other";
+            if (deviceType & CL_DEVICE_TYPE_CPU) {
+                typeName = "cpu";
+            } else if (deviceType & CL_DEVICE_TYPE_GPU) {
+                typeName = "gpu";
+            } else if (deviceType & CL_DEVICE_TYPE_ACCELERATOR) {
+                typeName = "accelerator";
+            }
+
+            descriptions.emplace_back(platformName
+                + ": " + getOclInfoString(NULL, deviceId, CL_DEVICE_NAME)
+                + " (" + typeName + ", " + std::to_string(computeUnits) + " compute units)");
+        }
+    }
+
+    return descriptions;
 }
 
 void OpenClDisparityMapGenerator::ensureParametersValid() {
@@ -99,149 +233,816 @@ void OpenClDisparityMapGenerator::ensureParametersValid() {
     if (this->parameters_.rightScanSteps < 0) {
         throw std::runtime_error("Error: right scan steps is negative.");
     }
+
+    int disparityRange = this->parameters_.leftScanSteps + this->parameters_.rightScanSteps + 1;
+    if (disparityRange > MAX_DISPARITY_RANGE) {
+        throw std::runtime_error("Error: a disparity range of " + std::to_string(disparityRange) + " is larger than the supported " + std::to_string(MAX_DISPARITY_RANGE) + ".");
+    }
+
+    if (this->parameters_.openClNumBufferSets < 1) {
+        throw std::runtime_error("Error: at least one OpenCL buffer set is required.");
+    }
+
+    // Keeps the 16-bit per-lane sums of the vectorized kernel from overflowing.
+    int blockChunks = (this->parameters_.blockSize + 15) / 16;
+    if ((this->kernelVariant_ == OpenClKernelVariant::Vectorized)
+        &&
+        (this->parameters_.blockSize * blockChunks > 257)) {
+        throw std::runtime_error("Error: block size is too large for the vectorized OpenCL kernel.");
+    }
+
+    const std::string& deviceType = this->parameters_.openClDeviceType;
+    if ((deviceType != "default")
+        && (deviceType != "cpu")
+        && (deviceType != "gpu")
+        && (deviceType != "accelerator")
+        && (deviceType != "all")) {
+        throw std::runtime_error("Error: unrecognized OpenCL device type '" + deviceType + "'.");
+    }
+
+    if (this->parameters_.openClMaxDevices < 0) {
+        throw std::runtime_error("Error: OpenCL max devices is negative.");
+    }
+
+    const std::string& fission = this->parameters_.openClDeviceFission;
+    if ((!fission.empty())
+        && (fission != "numa")
+        && ((fission.compare(0, 8, "equally:") != 0) || (atoi(fission.c_str() + 8) <= 0))) {
+        throw std::runtime_error("Error: unrecognized OpenCL device fission '" + fission + "'.");
+    }
 }
 
-void OpenClDisparityMapGenerator::initializeOclKernel() {
-    int numPixels = this->imageWidth_ * this->imageHeight_;
-
-    std::ifstream openclProgramFile("OpenClFunctions.cl");
-    std::stringstream buf;
-    buf << openclProgramFile.rdbuf();
-    std::string openclProgramText = buf.str();
-
-    cl_int ret = clGetPlatformIDs(
-            1,                     // num_entries
-            &this->oclPlatformId_,
-            &this->oclNumPlatforms_);
-
-    ret = clGetDeviceIDs(
-            this->oclPlatformId_,
-            CL_DEVICE_TYPE_DEFAULT, // CL_DEVICE_TYPE_GPU, CL_DEVICE_TYPE_CPU (CPU needs drivers)
-            1,                      // num_entries
-            &this->oclDeviceId_,
-            &this->oclNumDevices_);
-
-    this->oclContext_ = clCreateContext(
-            NULL,             // context properties
-            1,                // num devices
-            &this->oclDeviceId_, 
-            NULL,             // callback for reporting errors
-            NULL,             // user_data for error callback
-            &ret);
-
-    this->oclCommandQueue_ = clCreateCommandQueue(
-            this->oclContext_,
-            this->oclDeviceId_,
-            0,                 // properties (no profiling, no out-of-order)
-            &ret);
-
-    this->oclLeftImageData_ = clCreateBuffer(
-            this->oclContext_,
-            CL_MEM_READ_ONLY,
-            numPixels * sizeof(uint8_t),
-            NULL,              // buffer preallocated by the host
-            &ret);
-
-    this->oclRightImageData_ = clCreateBuffer(
-            this->oclContext_,
-            CL_MEM_READ_ONLY,
-            numPixels * sizeof(uint8_t),
-            NULL, 
-            &ret);
-
-    this->oclDisparityData_ = clCreateBuffer(
-            this->oclContext_,
-            CL_MEM_WRITE_ONLY,
-            numPixels * sizeof(float),
-            NULL,
-            &ret);
-
-    const char* programTxt = openclProgramText.c_str();
-    size_t sz = openclProgramText.size();
-    this->oclProgram_ = clCreateProgramWithSource(
-            this->oclContext_,
-            1, // count (e.g. number of programs)
-            static_cast<const char**>(&programTxt),
-            static_cast<const size_t*>(&sz),
-            &ret);
-
-    ret = clBuildProgram(
-            this->oclProgram_, 
-            1, 
-            &this->oclDeviceId_, 
-            NULL,   // program build options
-            NULL,   // error callback
-            NULL);  // user data for error callback
+void OpenClDisparityMapGenerator::initializeOclDevices() {
+    std::vector<cl_device_id> deviceIds = this->selectOclDevices();
+    if (deviceIds.empty()) {
+        throw std::runtime_error("Error: no OpenCL device matches the requested platform, device name and type.");
+    }
+
+    for (cl_device_id parentDeviceId : deviceIds) {
+        std::string parentName = getOclInfoString(NULL, parentDeviceId, CL_DEVICE_NAME);
+        std::vector<cl_device_id> subDeviceIds = this->partitionOclDevice(parentDeviceId);
+
+        bool isSubDevice = !subDeviceIds.empty();
+        if (!isSubDevice) {
+            subDeviceIds.emplace_back(parentDeviceId);
+        }
+
+        for (size_t i = 0; i < subDeviceIds.size(); i++) {
+            OclDevice_t device;
+            device.deviceId = subDeviceIds[i];
+            device.isSubDevice = isSubDevice;
+            device.name = isSubDevice
+                ? parentName + " [sub-device " + std::to_string(i) + "]"
+                : parentName;
+            device.rowsPerSecond = 0;
+
+            cl_int ret;
+            device.context = clCreateContext(
+                    NULL,             // context properties
+                    1,                // num devices
+                    &device.deviceId, 
+                    NULL,             // callback for reporting errors
+                    NULL,             // user_data for error callback
+                    &ret);
+            this->checkOclError(ret, "clCreateContext");
+
+            // Separate in-order queues for upload, compute and download,
+            //   so that transfers of one frame can overlap the kernel of another.
+            // Kernel profiling drives the band balancing across devices.
+            device.uploadQueue = clCreateCommandQueue(
+                    device.context,
+                    device.deviceId,
+                    0,                 // properties (no profiling, no out-of-order)
+                    &ret);
+            this->checkOclError(ret, "clCreateCommandQueue");
+
+            device.computeQueue = clCreateCommandQueue(
+                    device.context,
+                    device.deviceId,
+                    CL_QUEUE_PROFILING_ENABLE,
+                    &ret);
+            this->checkOclError(ret, "clCreateCommandQueue");
+
+            device.downloadQueue = clCreateCommandQueue(
+                    device.context,
+                    device.deviceId,
+                    0,
+                    &ret);
+            this->checkOclError(ret, "clCreateCommandQueue");
+
+            this->oclDevices_.emplace_back(device);
+        }
+    }
+
+    this->openClContextCreated_ = true;
+}
+
+std::vector<cl_device_id> OpenClDisparityMapGenerator::selectOclDevices() {
+    cl_device_type deviceType = CL_DEVICE_TYPE_DEFAULT;
+    if (this->parameters_.openClDeviceType == "cpu") {
+        deviceType = CL_DEVICE_TYPE_CPU;
+    } else if (this->parameters_.openClDeviceType == "gpu") {
+        deviceType = CL_DEVICE_TYPE_GPU;
+    } else if (this->parameters_.openClDeviceType == "accelerator") {
+        deviceType = CL_DEVICE_TYPE_ACCELERATOR;
+    } else if (this->parameters_.openClDeviceType == "all") {
+        deviceType = CL_DEVICE_TYPE_ALL;
+    }
+
+    std::vector<cl_device_id> selectedDeviceIds;
+    size_t maxDevices = (this->parameters_.openClMaxDevices > 0)
+        ? static_cast<size_t>(this->parameters_.openClMaxDevices)
+        : std::numeric_limits<size_t>::max();
+
+    cl_uint numPlatforms = 0;
+    cl_int ret = clGetPlatformIDs(0, NULL, &numPlatforms);
+    if ((ret != CL_SUCCESS) || (numPlatforms == 0)) {
+        throw std::runtime_error("Error: no OpenCL platforms are available.");
+    }
+
+    std::vector<cl_platform_id> platformIds(numPlatforms);
+    clGetPlatformIDs(numPlatforms, platformIds.data(), NULL);
+
+    for (cl_platform_id platformId : platformIds) {
+        std::string platformName = getOclInfoString(platformId, NULL, CL_PLATFORM_NAME);
+        if (platformName.find(this->parameters_.openClPlatformName) == std::string::npos) {
+            continue;
+        }
+
+        cl_uint numDevices = 0;
+        ret = clGetDeviceIDs(platformId, deviceType, 0, NULL, &numDevices);
+        if ((ret != CL_SUCCESS) || (numDevices == 0)) {
+            continue;
+        }
+
+        std::vector<cl_device_id> deviceIds(numDevices);
+        clGetDeviceIDs(platformId, deviceType, numDevices, deviceIds.data(), NULL);
+
+        for (cl_device_id deviceId : deviceIds) {
+            std::string deviceName = getOclInfoString(NULL, deviceId, CL_DEVICE_NAME);
+            if (deviceName.find(this->parameters_.openClDeviceName) == std::string::npos) {
+                continue;
+            }
+
+            if (selectedDeviceIds.size() < maxDevices) {
+                selectedDeviceIds.emplace_back(deviceId);
+            }
+        }
+    }
 
+    return selectedDeviceIds;
+}
+
+std::vector<cl_device_id> OpenClDisparityMapGenerator::partitionOclDevice(cl_device_id deviceId) {
+    std::vector<cl_device_id> subDeviceIds;
+    const std::string& fission = this->parameters_.openClDeviceFission;
+    if (fission.empty()) {
+        return subDeviceIds;
+    }
+
+    cl_device_partition_property properties[3];
+    if (fission == "numa") {
+        properties[0] = CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN;
+        properties[1] = CL_DEVICE_AFFINITY_DOMAIN_NUMA;
+    } else {
+        properties[0] = CL_DEVICE_PARTITION_EQUALLY;
+        properties[1] = atoi(fission.c_str() + 8);
+    }
+    properties[2] = 0;
+
+    // Devices that cannot be partitioned this way (e.g. a single NUMA node) are used whole.
+    cl_uint numSubDevices = 0;
+    cl_int ret = clCreateSubDevices(deviceId, properties, 0, NULL, &numSubDevices);
+    if ((ret != CL_SUCCESS) || (numSubDevices == 0)) {
+        return subDeviceIds;
+    }
+
+    subDeviceIds.resize(numSubDevices);
+    ret = clCreateSubDevices(deviceId, properties, numSubDevices, subDeviceIds.data(), NULL);
     if (ret != CL_SUCCESS) {
-        size_t length;
-        char buffer[8192];
-        clGetProgramBuildInfo(
-            this->oclProgram_,
-            this->oclDeviceId_,
-            CL_PROGRAM_BUILD_LOG,
-            sizeof(buffer),
-            buffer,
-            &length);
-
-        std::string error(buffer);
-        throw std::runtime_error(error);
-    }
-    
-    this->oclKernel_ = clCreateKernel(this->oclProgram_, "computeDisparityOpenClKernel", &ret);
+        subDeviceIds.clear();
+    }
+
+    return subDeviceIds;
+}
+
+void OpenClDisparityMapGenerator::ensureBufferSetsAllocated(int imageWidth, int imageHeight) {
+    bool sizeChanged = ((imageWidth != this->imageWidth_) || (imageHeight != this->imageHeight_));
+    bool countChanged = (this->numBufferSets_ != this->parameters_.openClNumBufferSets);
+
+    if ((!sizeChanged) && (!countChanged)) {
+        return;
+    }
+
+    if (this->numFramesInFlight_ > 0) {
+        throw std::runtime_error("Error: the image size or buffer count cannot change while frames are in flight.");
+    }
+
+    this->imageWidth_ = imageWidth;
+    this->imageHeight_ = imageHeight;
+    this->numBufferSets_ = this->parameters_.openClNumBufferSets;
+    this->nextBufferSet_ = 0;
+
+    for (OclDevice_t& device : this->oclDevices_) {
+        this->releaseBufferSets(device);
+        this->createBufferSets(device);
+    }
+}
+
+std::vector<int> OpenClDisparityMapGenerator::computeBandRows(int numRows) {
+    // Until every device has been measured, split the rows evenly.
+    bool allMeasured = true;
+    double totalRowsPerSecond = 0;
+    for (const OclDevice_t& device : this->oclDevices_) {
+        allMeasured = allMeasured && (device.rowsPerSecond > 0);
+        totalRowsPerSecond += device.rowsPerSecond;
+    }
+
+    std::vector<int> bandRows(this->oclDevices_.size(), 0);
+    int assignedRows = 0;
+    for (size_t i = 0; i < this->oclDevices_.size(); i++) {
+        double share = allMeasured
+            ? this->oclDevices_[i].rowsPerSecond / totalRowsPerSecond
+            : 1.0 / static_cast<double>(this->oclDevices_.size());
+
+        bandRows[i] = (i == this->oclDevices_.size() - 1)
+            ? numRows - assignedRows
+            : std::min(numRows - assignedRows, static_cast<int>(share * numRows + 0.5));
+        assignedRows += bandRows[i];
+    }
+
+    return bandRows;
+}
+
+void OpenClDisparityMapGenerator::enqueueBand(
+        OclDevice_t& device,
+        OclBufferSet_t& bufferSet,
+        int bandMinY,
+        int bandNumRows,
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage) {
+    const OclSpecializedKernel_t& specializedKernel = this->getSpecializedKernel(device);
+
+    // The band's input includes maxBlockStep rows of halo on either side.
+    int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
+    int inputMinY = std::max(0, bandMinY - maxBlockStep);
+    int inputMaxY = std::min(this->imageHeight_, bandMinY + bandNumRows + maxBlockStep);
+    size_t numInputPixels = (inputMaxY - inputMinY) * this->imageWidth_;
+    size_t numOutputPixels = bandNumRows * this->imageWidth_;
 
+    // Color input is converted to gray while it is staged, so no intermediate frame is written.
+    GrayscaleConverter::convertRows(leftImage, inputMinY, inputMaxY, bufferSet.leftImageHost);
+    GrayscaleConverter::convertRows(rightImage, inputMinY, inputMaxY, bufferSet.rightImageHost);
+
+    // A failure after the first enqueue releases the events created so far, since no dequeue will.
+    cl_event writeEvents[2] = { NULL, NULL };
+    auto checkBandError = [this, &writeEvents, &bufferSet](cl_int ret, const std::string& operation) {
+        if (ret != CL_SUCCESS) {
+            for (cl_event writeEvent : writeEvents) {
+                if (writeEvent != NULL) {
+                    clReleaseEvent(writeEvent);
+                }
+            }
+
+            this->releaseBandEvents(bufferSet);
+            checkOclError(ret, operation);
+        }
+    };
+
+    cl_int ret = clEnqueueWriteBuffer(
+        device.uploadQueue,       
+        bufferSet.leftImageData,
+        CL_FALSE,                         // non-blocking write
+        0,                                // offset
+        numInputPixels * sizeof(uint8_t), // size
+        bufferSet.leftImageHost,          // pinned buffer
+        0,                                // num_events_in_wait_list
+        NULL,                             // event_wait_list
+        &writeEvents[0]);                 // event
+    checkBandError(ret, "clEnqueueWriteBuffer");
+
+    ret = clEnqueueWriteBuffer(
+        device.uploadQueue,       
+        bufferSet.rightImageData,
+        CL_FALSE,                         // non-blocking write
+        0,                                // offset
+        numInputPixels * sizeof(uint8_t), // size
+        bufferSet.rightImageHost,         // pinned buffer
+        0,                                // num_events_in_wait_list
+        NULL,                             // event_wait_list
+        &writeEvents[1]);                 // event
+    checkBandError(ret, "clEnqueueWriteBuffer");
+
+    // Kernel arguments are captured at enqueue time, so they can be rebound per buffer set.
     ret = clSetKernelArg(
-            this->oclKernel_, 
+            specializedKernel.kernel, 
+            5, 
+            sizeof(cl_mem), 
+            &(bufferSet.leftImageData));
+    ret |= clSetKernelArg(
+            specializedKernel.kernel, 
+            6, 
+            sizeof(cl_mem), 
+            &(bufferSet.rightImageData));
+    ret |= clSetKernelArg(
+            specializedKernel.kernel, 
+            7, 
+            sizeof(cl_mem), 
+            &(bufferSet.disparityData));
+    ret |= clSetKernelArg(
+            specializedKernel.kernel, 
+            8, 
+            sizeof(int), 
+            &bandMinY);
+    ret |= clSetKernelArg(
+            specializedKernel.kernel, 
+            9, 
+            sizeof(int), 
+            &bandNumRows);
+    checkBandError(ret, "clSetKernelArg");
+
+    if ((specializedKernel.useTiledKernel) || (this->kernelVariant_ == OpenClKernelVariant::Vectorized)) {
+        // Round the global size up, the kernel discards the out-of-band work items.
+        size_t globalWorkSize[2];
+        globalWorkSize[0] = ((this->imageWidth_ + specializedKernel.localWorkSize[0] - 1) / specializedKernel.localWorkSize[0]) * specializedKernel.localWorkSize[0];
+        globalWorkSize[1] = ((bandNumRows + specializedKernel.localWorkSize[1] - 1) / specializedKernel.localWorkSize[1]) * specializedKernel.localWorkSize[1];
+
+        ret = clEnqueueNDRangeKernel(
+            device.computeQueue,
+            specializedKernel.kernel,
+            2,                               // dimensions
+            NULL,                            // global work offset
+            globalWorkSize,                  // global work size
+            specializedKernel.localWorkSize, // local work size
+            2,                               // num_events_in_wait_list
+            writeEvents,                     // event_wait_list
+            &bufferSet.kernelEvent);         // event
+    } else {
+        ret = clEnqueueNDRangeKernel(
+            device.computeQueue,
+            specializedKernel.kernel,
+            1,                       // dimensions
+            NULL,                    // global work offset
+            &numOutputPixels,        // global work size
+            NULL,                    // local work size (NULL == let the runtime pick a divisor)
+            2,                       // num_events_in_wait_list
+            writeEvents,             // event_wait_list
+            &bufferSet.kernelEvent); // event
+    }
+    checkBandError(ret, "clEnqueueNDRangeKernel");
+
+    ret = clEnqueueReadBuffer(
+        device.downloadQueue,
+        bufferSet.disparityData,
+        CL_FALSE,                         // non-blocking read
+        0,                                // offset
+        numOutputPixels * sizeof(float),  // size
+        bufferSet.disparityHost,          // pinned buffer
+        1,                                // num_events_in_wait_list
+        &bufferSet.kernelEvent,           // event_wait_list
+        &bufferSet.readEvent);            // event
+    checkBandError(ret, "clEnqueueReadBuffer");
+
+    // Queues are not guaranteed to start work until flushed.
+    clFlush(device.uploadQueue);
+    clFlush(device.computeQueue);
+    clFlush(device.downloadQueue);
+
+    clReleaseEvent(writeEvents[0]);
+    clReleaseEvent(writeEvents[1]);
+}
+
+std::string OpenClDisparityMapGenerator::computeBuildOptions() const {
+    return "-DSPECIALIZED_BLOCK_SIZE=" + std::to_string(this->parameters_.blockSize)
+        + " -DSPECIALIZED_LEFT_SCAN_STEPS=" + std::to_string(this->parameters_.leftScanSteps)
+        + " -DSPECIALIZED_RIGHT_SCAN_STEPS=" + std::to_string(this->parameters_.rightScanSteps)
+        + " -DSPECIALIZED_IMAGE_WIDTH=" + std::to_string(this->imageWidth_)
+        + " -DSPECIALIZED_IMAGE_HEIGHT=" + std::to_string(this->imageHeight_);
+}
+
+const OpenClDisparityMapGenerator::OclSpecializedKernel_t& OpenClDisparityMapGenerator::getSpecializedKernel(
+        OclDevice_t& device) {
+    std::string buildOptions = this->computeBuildOptions();
+
+    std::map<std::string, OclSpecializedKernel_t>::iterator it = device.specializedKernels.find(buildOptions);
+    if (it != device.specializedKernels.end()) {
+        return it->second;
+    }
+
+    OclSpecializedKernel_t specializedKernel;
+    this->buildSpecializedKernel(device, buildOptions, specializedKernel);
+    return device.specializedKernels.emplace(buildOptions, specializedKernel).first->second;
+}
+
+void OpenClDisparityMapGenerator::buildSpecializedKernel(
+        OclDevice_t& device,
+        const std::string& buildOptions,
+        OclSpecializedKernel_t& specializedKernel) {
+    std::string cacheDirectory;
+    if (this->parameters_.openClBinaryCacheEnabled) {
+        cacheDirectory = this->parameters_.openClBinaryCacheDirectory.empty()
+            ? OpenClProgramCache::getDefaultCacheDirectory()
+            : this->parameters_.openClBinaryCacheDirectory;
+    }
+
+    OpenClProgramCache programCache(cacheDirectory);
+    specializedKernel.program = programCache.buildProgram(
+            device.context,
+            device.deviceId,
+            OPENCL_FUNCTIONS_SOURCE,
+            buildOptions);
+
+    cl_int ret;
+    if (this->kernelVariant_ == OpenClKernelVariant::Vectorized) {
+        specializedKernel.kernel = clCreateKernel(specializedKernel.program, "computeDisparityOpenClKernelVectorized", &ret);
+        this->checkOclError(ret, "clCreateKernel");
+        specializedKernel.useTiledKernel = false;
+        this->selectWorkGroupSize(device, specializedKernel);
+    } else {
+        specializedKernel.kernel = clCreateKernel(specializedKernel.program, "computeDisparityOpenClKernelTiled", &ret);
+        this->checkOclError(ret, "clCreateKernel");
+        specializedKernel.useTiledKernel = this->selectTiledWorkGroupSize(device, specializedKernel);
+    }
+
+    if (specializedKernel.useTiledKernel) {
+        ret = clSetKernelArg(
+                specializedKernel.kernel,
+                10,
+                specializedKernel.leftTileBytes,
+                NULL);  // local memory, allocated per work-group
+        ret |= clSetKernelArg(
+                specializedKernel.kernel,
+                11,
+                specializedKernel.rightTileBytes,
+                NULL);
+        this->checkOclError(ret, "clSetKernelArg");
+    } else if (this->kernelVariant_ == OpenClKernelVariant::Scalar) {
+        clReleaseKernel(specializedKernel.kernel);
+        specializedKernel.kernel = clCreateKernel(specializedKernel.program, "computeDisparityOpenClKernel", &ret);
+        this->checkOclError(ret, "clCreateKernel");
+    }
+
+    // The specialized kernels ignore these, but they are still part of the signature.
+    ret = clSetKernelArg(
+            specializedKernel.kernel, 
             0, 
             sizeof(int), 
             &(this->imageHeight_));
-    ret = clSetKernelArg(
-            this->oclKernel_, 
+    ret |= clSetKernelArg(
+            specializedKernel.kernel, 
             1, 
             sizeof(int), 
             &(this->imageWidth_));
-    ret = clSetKernelArg(
-            this->oclKernel_, 
+    ret |= clSetKernelArg(
+            specializedKernel.kernel, 
             2, 
             sizeof(int), 
             &(this->parameters_.blockSize));
-    ret = clSetKernelArg(
-            this->oclKernel_, 
+    ret |= clSetKernelArg(
+            specializedKernel.kernel, 
             3, 
             sizeof(int), 
             &(this->parameters_.leftScanSteps));
-    ret = clSetKernelArg(
-            this->oclKernel_, 
+    ret |= clSetKernelArg(
+            specializedKernel.kernel, 
             4, 
             sizeof(int), 
             &(this->parameters_.rightScanSteps));
-    ret = clSetKernelArg(
-            this->oclKernel_, 
-            5, 
-            sizeof(cl_mem), 
-            &(this->oclLeftImageData_));
-    ret = clSetKernelArg(
-            this->oclKernel_, 
-            6, 
-            sizeof(cl_mem), 
-            &(this->oclRightImageData_));
-    ret = clSetKernelArg(
-            this->oclKernel_, 
-            7, 
-            sizeof(cl_mem), 
-            &(this->oclDisparityData_));
+    this->checkOclError(ret, "clSetKernelArg");
+}
+
+bool OpenClDisparityMapGenerator::selectTiledWorkGroupSize(
+        OclDevice_t& device,
+        OclSpecializedKernel_t& specializedKernel) {
+    size_t kernelMaxWorkGroupSize;
+    size_t maxWorkItemSizes[3];
+    cl_ulong localMemSize;
 
-    this->openClKernelCreated_ = true;
+    cl_int ret = clGetKernelWorkGroupInfo(
+            specializedKernel.kernel,
+            device.deviceId,
+            CL_KERNEL_WORK_GROUP_SIZE,
+            sizeof(kernelMaxWorkGroupSize),
+            &kernelMaxWorkGroupSize,
+            NULL);
+    ret |= clGetDeviceInfo(
+            device.deviceId,
+            CL_DEVICE_MAX_WORK_ITEM_SIZES,
+            sizeof(maxWorkItemSizes),
+            maxWorkItemSizes,
+            NULL);
+    ret |= clGetDeviceInfo(
+            device.deviceId,
+            CL_DEVICE_LOCAL_MEM_SIZE,
+            sizeof(localMemSize),
+            &localMemSize,
+            NULL);
+    this->checkOclError(ret, "querying work-group limits");
+
+    int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
+    int scanWidth = this->parameters_.leftScanSteps + this->parameters_.rightScanSteps;
+
+    // Start from a 16x16 tile and shrink it until it fits the device.
+    // Rows are halved first, as wide tiles keep the global loads contiguous.
+    size_t localX = std::min<size_t>(16, maxWorkItemSizes[0]);
+    size_t localY = std::min<size_t>(16, maxWorkItemSizes[1]);
+
+    while (true) {
+        size_t tileHeight = localY + (2 * maxBlockStep);
+        size_t leftTileWidth = localX + (2 * maxBlockStep);
+        size_t rightTileWidth = leftTileWidth + scanWidth;
+
+        specializedKernel.leftTileBytes = tileHeight * leftTileWidth;
+        specializedKernel.rightTileBytes = tileHeight * rightTileWidth;
+
+        bool fitsWorkGroup = ((localX * localY) <= kernelMaxWorkGroupSize);
+        bool fitsLocalMem = ((specializedKernel.leftTileBytes + specializedKernel.rightTileBytes) <= localMemSize);
+        if (fitsWorkGroup && fitsLocalMem) {
+            break;
+        }
+
+        if (localY > 1) {
+            localY /= 2;
+        } else if (localX > 1) {
+            localX /= 2;
+        } else {
+            return false;
+        }
+    }
+
+    specializedKernel.localWorkSize[0] = localX;
+    specializedKernel.localWorkSize[1] = localY;
+    return true;
+}
+
+void OpenClDisparityMapGenerator::selectWorkGroupSize(
+        OclDevice_t& device,
+        OclSpecializedKernel_t& specializedKernel) {
+    size_t kernelMaxWorkGroupSize;
+    cl_int ret = clGetKernelWorkGroupInfo(
+            specializedKernel.kernel,
+            device.deviceId,
+            CL_KERNEL_WORK_GROUP_SIZE,
+            sizeof(kernelMaxWorkGroupSize),
+            &kernelMaxWorkGroupSize,
+            NULL);
+    this->checkOclError(ret, "clGetKernelWorkGroupInfo");
+
+    specializedKernel.localWorkSize[0] = std::min<size_t>(16, kernelMaxWorkGroupSize);
+    specializedKernel.localWorkSize[1] = std::max<size_t>(1, std::min<size_t>(16, kernelMaxWorkGroupSize / specializedKernel.localWorkSize[0]));
+}
+
+void OpenClDisparityMapGenerator::createBufferSets(OclDevice_t& device) {
+    size_t numPixels = this->imageWidth_ * this->imageHeight_;
+    size_t imageBufferSize = numPixels + VECTOR_LOAD_PADDING;
+    cl_int ret;
+
+    device.bufferSets.resize(this->numBufferSets_);
+
+    for (OclBufferSet_t& bufferSet : device.bufferSets) {
+        bufferSet.leftImageData = clCreateBuffer(
+                device.context,
+                CL_MEM_READ_ONLY,
+                imageBufferSize * sizeof(uint8_t),
+                NULL,              // buffer preallocated by the host
+                &ret);
+        this->checkOclError(ret, "clCreateBuffer");
+
+        bufferSet.rightImageData = clCreateBuffer(
+                device.context,
+                CL_MEM_READ_ONLY,
+                imageBufferSize * sizeof(uint8_t),
+                NULL, 
+                &ret);
+        this->checkOclError(ret, "clCreateBuffer");
+
+        bufferSet.disparityData = clCreateBuffer(
+                device.context,
+                CL_MEM_WRITE_ONLY,
+                numPixels * sizeof(float),
+                NULL,
+                &ret);
+        this->checkOclError(ret, "clCreateBuffer");
+
+        // Pinned staging memory lets the runtime DMA directly to and from the host.
+        bufferSet.leftImagePinned = clCreateBuffer(
+                device.context,
+                CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                numPixels * sizeof(uint8_t),
+                NULL,
+                &ret);
+        this->checkOclError(ret, "clCreateBuffer");
+
+        bufferSet.rightImagePinned = clCreateBuffer(
+                device.context,
+                CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                numPixels * sizeof(uint8_t),
+                NULL,
+                &ret);
+        this->checkOclError(ret, "clCreateBuffer");
+
+        bufferSet.disparityPinned = clCreateBuffer(
+                device.context,
+                CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                numPixels * sizeof(float),
+                NULL,
+                &ret);
+        this->checkOclError(ret, "clCreateBuffer");
+
+        bufferSet.leftImageHost = static_cast<uint8_t*>(clEnqueueMapBuffer(
+                device.uploadQueue,
+                bufferSet.leftImagePinned,
+                CL_TRUE,                      // blocking map
+                CL_MAP_WRITE,
+                0,                            // offset
+                numPixels * sizeof(uint8_t),  // size
+                0,                            // num_events_in_wait_list
+                NULL,                         // event_wait_list
+                NULL,                         // event
+                &ret));
+        this->checkOclError(ret, "clEnqueueMapBuffer");
+
+        bufferSet.rightImageHost = static_cast<uint8_t*>(clEnqueueMapBuffer(
+                device.uploadQueue,
+                bufferSet.rightImagePinned,
+                CL_TRUE,
+                CL_MAP_WRITE,
+                0,
+                numPixels * sizeof(uint8_t),
+                0,
+                NULL,
+                NULL,
+                &ret));
+        this->checkOclError(ret, "clEnqueueMapBuffer");
+
+        bufferSet.disparityHost = static_cast<float*>(clEnqueueMapBuffer(
+                device.downloadQueue,
+                bufferSet.disparityPinned,
+                CL_TRUE,
+                CL_MAP_READ,
+                0,
+                numPixels * sizeof(float),
+                0,
+                NULL,
+                NULL,
+                &ret));
+        this->checkOclError(ret, "clEnqueueMapBuffer");
+
+        bufferSet.bandMinY = 0;
+        bufferSet.bandNumRows = 0;
+        bufferSet.kernelEvent = NULL;
+        bufferSet.readEvent = NULL;
+    }
+}
+
+void OpenClDisparityMapGenerator::releaseBufferSets(OclDevice_t& device) {
+    if (device.bufferSets.empty()) {
+        return;
+    }
+
+    cl_int ret = clFinish(device.uploadQueue);
+    ret = clFinish(device.computeQueue);
+    ret = clFinish(device.downloadQueue);
+
+    for (OclBufferSet_t& bufferSet : device.bufferSets) {
+        if (bufferSet.kernelEvent != NULL) {
+            ret = clReleaseEvent(bufferSet.kernelEvent);
+        }
+
+        if (bufferSet.readEvent != NULL) {
+            ret = clReleaseEvent(bufferSet.readEvent);
+        }
+
+        ret = clEnqueueUnmapMemObject(device.uploadQueue, bufferSet.leftImagePinned, bufferSet.leftImageHost, 0, NULL, NULL);
+        ret = clEnqueueUnmapMemObject(device.uploadQueue, bufferSet.rightImagePinned, bufferSet.rightImageHost, 0, NULL, NULL);
+        ret = clEnqueueUnmapMemObject(device.downloadQueue, bufferSet.disparityPinned, bufferSet.disparityHost, 0, NULL, NULL);
+    }
+
+    ret = clFinish(device.uploadQueue);
+    ret = clFinish(device.downloadQueue);
+
+    for (OclBufferSet_t& bufferSet : device.bufferSets) {
+        ret = clReleaseMemObject(bufferSet.leftImageData);
+        ret = clReleaseMemObject(bufferSet.rightImageData);
+        ret = clReleaseMemObject(bufferSet.disparityData);
+        ret = clReleaseMemObject(bufferSet.leftImagePinned);
+        ret = clReleaseMemObject(bufferSet.rightImagePinned);
+        ret = clReleaseMemObject(bufferSet.disparityPinned);
+    }
+
+    device.bufferSets.clear();
+}
+
+void OpenClDisparityMapGenerator::cleanOcl() {
+    cl_int ret;
+    for (OclDevice_t& device : this->oclDevices_) {
+        this->releaseBufferSets(device);
+
+        for (std::pair<const std::string, OclSpecializedKernel_t>& entry : device.specializedKernels) {
+            ret = clReleaseKernel(entry.second.kernel);
+            ret = clReleaseProgram(entry.second.program);
+        }
+        device.specializedKernels.clear();
+
+        ret = clReleaseCommandQueue(device.uploadQueue);
+        ret = clReleaseCommandQueue(device.computeQueue);
+        ret = clReleaseCommandQueue(device.downloadQueue);
+        ret = clReleaseContext(device.context);
+
+        if (device.isSubDevice) {
+            ret = clReleaseDevice(device.deviceId);
+        }
+    }
+
+    this->oclDevices_.clear();
+    this->numBufferSets_ = 0;
+    this->numFramesInFlight_ = 0;
+}
+
+void OpenClDisparityMapGenerator::releaseBandEvents(OclBufferSet_t& bufferSet) {
+    // Waits for the band first, so that its host buffers can be reused.
+    if (bufferSet.readEvent != NULL) {
+        clWaitForEvents(1, &bufferSet.readEvent);
+        clReleaseEvent(bufferSet.readEvent);
+        bufferSet.readEvent = NULL;
+    }
+
+    if (bufferSet.kernelEvent != NULL) {
+        clReleaseEvent(bufferSet.kernelEvent);
+        bufferSet.kernelEvent = NULL;
+    }
+
+    bufferSet.bandNumRows = 0;
+}
+
+void OpenClDisparityMapGenerator::checkOclError(cl_int ret, const std::string& operation) {
+    if (ret != CL_SUCCESS) {
+        throw std::runtime_error("Error: " + operation + " failed with OpenCL error " + std::to_string(ret) + ".");
+    }
 }
 
-void OpenClDisparityMapGenerator::cleanOclKernel() {
-    cl_int ret = clFlush(this->oclCommandQueue_);
-    ret = clFinish(this->oclCommandQueue_);
-    ret = clReleaseKernel(this->oclKernel_);
-    ret = clReleaseProgram(this->oclProgram_);
-    ret = clReleaseMemObject(this->oclLeftImageData_);
-    ret = clReleaseMemObject(this->oclRightImageData_);
-    ret = clReleaseMemObject(this->oclDisparityData_);
-    ret = clReleaseCommandQueue(this->oclCommandQueue_);
-    ret = clReleaseContext(this->oclContext_);
+std::string OpenClDisparityMapGenerator::getOclInfoString(
+        cl_platform_id platformId,
+        cl_device_id deviceId,
+        cl_uint paramName) {
+    size_t length = 0;
+    cl_int ret = (deviceId != NULL)
+        ? clGetDeviceInfo(deviceId, paramName, 0, NULL, &length)
+        : clGetPlatformInfo(platformId, paramName, 0, NULL, &length);
+
+    if ((ret != CL_SUCCESS) || (length == 0)) {
+        return std::string();
+    }
+
+    std::vector<char> value(length);
+    ret = (deviceId != NULL)
+        ? clGetDeviceInfo(deviceId, paramName, length, value.data(), NULL)
+        : clGetPlatformInfo(platformId, paramName, length, value.data(), NULL);
+
+    if (ret != CL_SUCCESS) {
+        return std::string();
+    }
+
+    return std::string(value.data());
+}
+
+static DisparityMapBackendInfo_t createOpenClBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "OpenCL";
+    info.description = "OpenCL kernel, banded across one or more devices.";
+    info.requiredDevices = { "opencl" };
+    info.isDeviceAvailable = []() { return !OpenClDisparityMapGenerator::listAvailableDevices().empty(); };
+    // Kernels that are not specialized for the scan steps keep the costs of a pixel in a fixed array.
+    info.maxDisparityRange = OpenClDisparityMapGenerator::MAX_DISPARITY_RANGE;
+    info.fixedCostMs = 1.0;
+    info.nanosecondsPerComparison = 0.01;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<OpenClDisparityMapGenerator>(parameters);
+    };
+    return info;
 }
+
+static DisparityMapBackendInfo_t createOpenClVectorizedBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "OpenCLVectorized";
+    info.description = "OpenCL kernel comparing 16 pixels per vector.";
+    info.requiredDevices = { "opencl" };
+    info.isDeviceAvailable = []() { return !OpenClDisparityMapGenerator::listAvailableDevices().empty(); };
+    // Kernels that are not specialized for the scan steps keep the costs of a pixel in a fixed array.
+    info.maxDisparityRange = OpenClDisparityMapGenerator::MAX_DISPARITY_RANGE;
+    // Keeps the 16-bit per-lane sums from overflowing, see ensureParametersValid().
+    info.maxBlockSize = 63;
+    info.fixedCostMs = 1.0;
+    info.nanosecondsPerComparison = 0.005;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<OpenClDisparityMapGenerator>(parameters, OpenClKernelVariant::Vectorized);
+    };
+    return info;
+}
+
+static DisparityMapBackendRegistration openClRegistration(createOpenClBackendInfo());
+static DisparityMapBackendRegistration openClVectorizedRegistration(createOpenClVectorizedBackendInfo());
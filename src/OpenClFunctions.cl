@@ -1,3 +1,29 @@
+// When the host builds with -DSPECIALIZED_BLOCK_SIZE (and the other SPECIALIZED_* values),
+//   the kernel arguments are replaced with compile-time constants.
+// This lets the compiler unroll the block loops, fold the index math,
+//   and size the private cost buffer exactly.
+#ifdef SPECIALIZED_BLOCK_SIZE
+#define SPECIALIZE_ARGUMENTS() \
+    height = SPECIALIZED_IMAGE_HEIGHT; \
+    width = SPECIALIZED_IMAGE_WIDTH; \
+    blockSize = SPECIALIZED_BLOCK_SIZE; \
+    leftScanSteps = SPECIALIZED_LEFT_SCAN_STEPS; \
+    rightScanSteps = SPECIALIZED_RIGHT_SCAN_STEPS
+#define DISPARITY_BUF_SIZE (SPECIALIZED_LEFT_SCAN_STEPS + SPECIALIZED_RIGHT_SCAN_STEPS + 1)
+#else
+#define SPECIALIZE_ARGUMENTS()
+#define DISPARITY_BUF_SIZE 512
+#endif
+
+// Each kernel launch computes a band of numRows output rows starting at rowOffset.
+// The image buffers only hold the band's input rows, which start at
+//   inputRowOffset = max(0, rowOffset - maxBlockStep) and run until maxBlockStep rows past the band.
+// height is always the height of the full image, so the blocks are clamped as for a single launch.
+// The output buffer holds the band's rows only.
+int computeInputRowOffset(int rowOffset, int blockSize) {
+    return max(0, rowOffset - ((blockSize - 1) / 2));
+}
+
 void computeSadOverBlockOpenCl(
         int minYL,
         int minXL,
@@ -28,11 +54,12 @@ void computeDisparityForPixelOpenCl(
         int blockSize,
         int leftScanSteps,
         int rightScanSteps,
+        int inputRowOffset,
         global const unsigned char* leftImageData,
         global const unsigned char* rightImageData,
         global float* output) {
 
-    float disparityBuf[512];
+    float disparityBuf[DISPARITY_BUF_SIZE];
     int maxBlockStep = (blockSize - 1) / 2;
 
     int templateLeftHalfWidth = min(x, maxBlockStep);
@@ -58,9 +85,9 @@ void computeDisparityForPixelOpenCl(
     for (int xx = rightMinStartX; xx <= rightMaxStartX; xx++) {
         int sad = 0;
         computeSadOverBlockOpenCl(
-            leftMinY,
+            leftMinY - inputRowOffset,
             leftMinX,
-            leftMinY, // Ys are aligned for the two images
+            leftMinY - inputRowOffset, // Ys are aligned for the two images
             xx,
             templateWidth,
             templateHeight,
@@ -102,10 +129,15 @@ void computeDisparityOpenClKernel(
         int rightScanSteps,
         __global const unsigned char* leftImageData,
         __global const unsigned char* rightImageData,
-        __global float* disparityData) {
+        __global float* disparityData,
+        int rowOffset,
+        int numRows) {
 
+    SPECIALIZE_ARGUMENTS();
+
+    // The global size is exactly numRows * width.
     int index = get_global_id(0);
-    int y = index / width;
+    int y = (index / width) + rowOffset;
     int x = index % width;
 
     computeDisparityForPixelOpenCl(
@@ -116,8 +148,306 @@ void computeDisparityOpenClKernel(
         blockSize,
         leftScanSteps,
         rightScanSteps,
+        computeInputRowOffset(rowOffset, blockSize),
         leftImageData,
         rightImageData,
         disparityData + index);
 }
 
+
+// The tiled variant below works on a 2D NDRange.
+// Each work-group cooperatively copies the left block neighbourhood of its pixels
+//   and the right search band into local memory once, and matches out of local memory.
+// Tile coordinates are relative to the (unclamped) top-left corner of each tile.
+// Entries that fall outside of the image are never written nor read.
+void computeSadOverBlockLocalOpenCl(
+        int minYL,
+        int minXL,
+        int minYR,
+        int minXR,
+        int width,
+        int height,
+        int leftTileWidth,
+        int rightTileWidth,
+        local const unsigned char* leftTile,
+        local const unsigned char* rightTile,
+        private int* sum) {
+
+    *sum = 0;
+    for (int y = 0; y < height; y++) {
+        local const unsigned char* leftRow = leftTile + ((y + minYL) * leftTileWidth) + minXL;
+        local const unsigned char* rightRow = rightTile + ((y + minYR) * rightTileWidth) + minXR;
+        for (int x = 0; x < width; x++) {
+            *sum += abs(leftRow[x] - rightRow[x]);
+        }
+    }
+}
+
+void loadTileOpenCl(
+        int tileMinY,
+        int tileMinX,
+        int tileHeight,
+        int tileWidth,
+        int inputRowOffset,
+        int inputRowEnd,
+        int imageWidth,
+        global const unsigned char* imageData,
+        local unsigned char* tile) {
+    int localId = (get_local_id(1) * get_local_size(0)) + get_local_id(0);
+    int groupSize = get_local_size(0) * get_local_size(1);
+
+    for (int i = localId; i < tileHeight * tileWidth; i += groupSize) {
+        int y = tileMinY + (i / tileWidth);
+        int x = tileMinX + (i % tileWidth);
+        if ((y >= inputRowOffset) && (y < inputRowEnd) && (x >= 0) && (x < imageWidth)) {
+            tile[i] = imageData[((y - inputRowOffset) * imageWidth) + x];
+        }
+    }
+}
+
+__kernel 
+void computeDisparityOpenClKernelTiled(
+        int height,
+        int width,
+        int blockSize,
+        int leftScanSteps,
+        int rightScanSteps,
+        __global const unsigned char* leftImageData,
+        __global const unsigned char* rightImageData,
+        __global float* disparityData,
+        int rowOffset,
+        int numRows,
+        __local unsigned char* leftTile,
+        __local unsigned char* rightTile) {
+
+    SPECIALIZE_ARGUMENTS();
+
+    int maxBlockStep = (blockSize - 1) / 2;
+    int inputRowOffset = computeInputRowOffset(rowOffset, blockSize);
+    int inputRowEnd = min(height, rowOffset + numRows + maxBlockStep);
+
+    int tileMinY = rowOffset + (get_group_id(1) * get_local_size(1)) - maxBlockStep;
+    int tileHeight = get_local_size(1) + (2 * maxBlockStep);
+    int leftTileMinX = (get_group_id(0) * get_local_size(0)) - maxBlockStep;
+    int leftTileWidth = get_local_size(0) + (2 * maxBlockStep);
+    int rightTileMinX = leftTileMinX - leftScanSteps;
+    int rightTileWidth = leftTileWidth + leftScanSteps + rightScanSteps;
+
+    loadTileOpenCl(tileMinY, leftTileMinX, tileHeight, leftTileWidth, inputRowOffset, inputRowEnd, width, leftImageData, leftTile);
+    loadTileOpenCl(tileMinY, rightTileMinX, tileHeight, rightTileWidth, inputRowOffset, inputRowEnd, width, rightImageData, rightTile);
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // The global size is rounded up to a multiple of the work-group size.
+    int x = get_global_id(0);
+    int y = get_global_id(1) + rowOffset;
+    if ((x >= width) || (y >= rowOffset + numRows)) {
+        return;
+    }
+
+    float disparityBuf[DISPARITY_BUF_SIZE];
+
+    int templateLeftHalfWidth = min(x, maxBlockStep);
+    int templateRightHalfWidth = min(width - x - 1, maxBlockStep);
+    int templateTopHalfHeight = min(y, maxBlockStep);
+    int templateBottomHalfHeight = min(height - y - 1, maxBlockStep);
+
+    int templateWidth = templateLeftHalfWidth + templateRightHalfWidth + 1;
+    int templateHeight = templateTopHalfHeight + templateBottomHalfHeight + 1;
+
+    int leftMinY = y - templateTopHalfHeight;
+    int leftMinX = x - templateLeftHalfWidth;
+
+    int rightMinStartX = max(0, x - leftScanSteps - templateLeftHalfWidth);
+    int rightMaxStartX = min(width - templateWidth, x + rightScanSteps - templateLeftHalfWidth);
+
+    int numSteps = rightMaxStartX - rightMinStartX;
+
+    int bestIndex = 0;
+    int bestSadValue = 2147483646; // value of std::numeric_limits<int>::max() - 1
+    int zeroDisparityIndex = x - rightMinStartX - templateLeftHalfWidth;
+
+    for (int xx = rightMinStartX; xx <= rightMaxStartX; xx++) {
+        int sad = 0;
+        computeSadOverBlockLocalOpenCl(
+            leftMinY - tileMinY,
+            leftMinX - leftTileMinX,
+            leftMinY - tileMinY, // Ys are aligned for the two images
+            xx - rightTileMinX,
+            templateWidth,
+            templateHeight,
+            leftTileWidth,
+            rightTileWidth,
+            leftTile,
+            rightTile,
+            &sad);
+
+        disparityBuf[xx - rightMinStartX] = sad;
+
+        if (sad < bestSadValue) {
+            bestSadValue = sad;
+            bestIndex = xx - rightMinStartX;
+        }
+    }
+
+    float disparity = (float)(abs(bestIndex - zeroDisparityIndex));
+    if ((bestIndex == 0)
+        ||
+        (bestIndex == numSteps)
+        ||
+        (bestSadValue == 0)) {
+        disparityData[((y - rowOffset) * width) + x] = disparity;
+    } else { 
+        float c3 = disparityBuf[bestIndex+1];
+        float c2 = disparityBuf[bestIndex];
+        float c1 = disparityBuf[bestIndex-1];
+
+        disparityData[((y - rowOffset) * width) + x] = disparity - (0.5 * ((c3 - c1) / (c1 - (2*c2) + c3)));
+    }
+}
+
+// The vectorized variant below processes 16 pixels of a block row per load,
+//   and evaluates CANDIDATES_PER_ITERATION candidate disparities at once.
+// Loads may run up to VECTOR_LOAD_PADDING bytes past the last pixel,
+//   so the host pads the image buffers accordingly. Those lanes are masked out.
+// Per-lane sums are kept in 16 bits, which the host guarantees cannot overflow
+//   by limiting blockSize * ceil(blockSize / 16) to 257.
+#define CANDIDATES_PER_ITERATION 4
+
+uint sumUshort16Lanes(ushort16 v) {
+    uint8 s8 = convert_uint8(v.lo) + convert_uint8(v.hi);
+    uint4 s4 = s8.lo + s8.hi;
+    uint2 s2 = s4.lo + s4.hi;
+    return s2.x + s2.y;
+}
+
+void computeSadOverBlockVectorizedOpenCl(
+        int minYL,
+        int minXL,
+        int minYR,
+        int minXR,
+        int width,
+        int height,
+        int imageWidth,
+        global const unsigned char* leftImageData,
+        global const unsigned char* rightImageData,
+        private int4* sums) {
+
+    const uchar16 lanes = (uchar16)(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    ushort16 acc0 = (ushort16)(0);
+    ushort16 acc1 = (ushort16)(0);
+    ushort16 acc2 = (ushort16)(0);
+    ushort16 acc3 = (ushort16)(0);
+
+    for (int y = 0; y < height; y++) {
+        global const unsigned char* leftRow = leftImageData + ((y + minYL) * imageWidth) + minXL;
+        global const unsigned char* rightRow = rightImageData + ((y + minYR) * imageWidth) + minXR;
+
+        for (int cx = 0; cx < width; cx += 16) {
+            uchar16 mask = as_uchar16(lanes < (uchar16)((uchar)min(width - cx, 16)));
+            uchar16 l = vload16(0, leftRow + cx) & mask;
+
+            acc0 += convert_ushort16(abs_diff(l, vload16(0, rightRow + cx) & mask));
+            acc1 += convert_ushort16(abs_diff(l, vload16(0, rightRow + cx + 1) & mask));
+            acc2 += convert_ushort16(abs_diff(l, vload16(0, rightRow + cx + 2) & mask));
+            acc3 += convert_ushort16(abs_diff(l, vload16(0, rightRow + cx + 3) & mask));
+        }
+    }
+
+    *sums = (int4)(
+        (int)sumUshort16Lanes(acc0),
+        (int)sumUshort16Lanes(acc1),
+        (int)sumUshort16Lanes(acc2),
+        (int)sumUshort16Lanes(acc3));
+}
+
+__kernel 
+void computeDisparityOpenClKernelVectorized(
+        int height,
+        int width,
+        int blockSize,
+        int leftScanSteps,
+        int rightScanSteps,
+        __global const unsigned char* leftImageData,
+        __global const unsigned char* rightImageData,
+        __global float* disparityData,
+        int rowOffset,
+        int numRows) {
+
+    SPECIALIZE_ARGUMENTS();
+
+    // The global size is rounded up to a multiple of the work-group size.
+    int x = get_global_id(0);
+    int y = get_global_id(1) + rowOffset;
+    if ((x >= width) || (y >= rowOffset + numRows)) {
+        return;
+    }
+
+    int inputRowOffset = computeInputRowOffset(rowOffset, blockSize);
+
+    float disparityBuf[DISPARITY_BUF_SIZE + CANDIDATES_PER_ITERATION];
+    int maxBlockStep = (blockSize - 1) / 2;
+
+    int templateLeftHalfWidth = min(x, maxBlockStep);
+    int templateRightHalfWidth = min(width - x - 1, maxBlockStep);
+    int templateTopHalfHeight = min(y, maxBlockStep);
+    int templateBottomHalfHeight = min(height - y - 1, maxBlockStep);
+
+    int templateWidth = templateLeftHalfWidth + templateRightHalfWidth + 1;
+    int templateHeight = templateTopHalfHeight + templateBottomHalfHeight + 1;
+
+    int leftMinY = y - templateTopHalfHeight;
+    int leftMinX = x - templateLeftHalfWidth;
+
+    int rightMinStartX = max(0, x - leftScanSteps - templateLeftHalfWidth);
+    int rightMaxStartX = min(width - templateWidth, x + rightScanSteps - templateLeftHalfWidth);
+
+    int numSteps = rightMaxStartX - rightMinStartX;
+
+    int bestIndex = 0;
+    int bestSadValue = 2147483646; // value of std::numeric_limits<int>::max() - 1
+    int zeroDisparityIndex = x - rightMinStartX - templateLeftHalfWidth;
+
+    for (int xx = rightMinStartX; xx <= rightMaxStartX; xx += CANDIDATES_PER_ITERATION) {
+        int4 sads;
+        computeSadOverBlockVectorizedOpenCl(
+            leftMinY - inputRowOffset,
+            leftMinX,
+            leftMinY - inputRowOffset, // Ys are aligned for the two images
+            xx,
+            templateWidth,
+            templateHeight,
+            width,
+            leftImageData, 
+            rightImageData,
+            &sads);
+
+        // Candidates past rightMaxStartX are computed on padding and ignored.
+        // Visiting them in order keeps tie-breaking identical to the scalar kernel.
+        int sadValues[CANDIDATES_PER_ITERATION] = { sads.s0, sads.s1, sads.s2, sads.s3 };
+        int numCandidates = min(CANDIDATES_PER_ITERATION, rightMaxStartX - xx + 1);
+        for (int k = 0; k < numCandidates; k++) {
+            disparityBuf[xx + k - rightMinStartX] = sadValues[k];
+
+            if (sadValues[k] < bestSadValue) {
+                bestSadValue = sadValues[k];
+                bestIndex = xx + k - rightMinStartX;
+            }
+        }
+    }
+
+    float disparity = (float)(abs(bestIndex - zeroDisparityIndex));
+    if ((bestIndex == 0)
+        ||
+        (bestIndex == numSteps)
+        ||
+        (bestSadValue == 0)) {
+        disparityData[((y - rowOffset) * width) + x] = disparity;
+    } else { 
+        float c3 = disparityBuf[bestIndex+1];
+        float c2 = disparityBuf[bestIndex];
+        float c1 = disparityBuf[bestIndex-1];
+
+        disparityData[((y - rowOffset) * width) + x] = disparity - (0.5 * ((c3 - c1) / (c1 - (2*c2) + c3)));
+    }
+}
@@ -0,0 +1,232 @@
+#include "../include/OpenClProgramCache.hpp"
+#include "../include/CacheDirectory.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+OpenClProgramCache::OpenClProgramCache(const std::string& cacheDirectory)
+        : cacheDirectory_(cacheDirectory) {}
+
+cl_program OpenClProgramCache::buildProgram(
+        cl_context context,
+        cl_device_id device,
+        const std::string& source,
+        const std::string& buildOptions) {
+    if (this->cacheDirectory_.empty()) {
+        return this->buildFromSource(context, device, source, buildOptions);
+    }
+
+    std::string cacheFilePath = this->computeCacheFilePath(device, source, buildOptions);
+
+    cl_program program = this->loadBinary(context, device, cacheFilePath, buildOptions);
+    if (program != NULL) {
+        return program;
+    }
+
+    program = this->buildFromSource(context, device, source, buildOptions);
+    this->storeBinary(program, cacheFilePath);
+    return program;
+}
+
+std::string OpenClProgramCache::getDefaultCacheDirectory() {
+    return CacheDirectory::getDefault();
+}
+
+std::string OpenClProgramCache::computeCacheFilePath(
+        cl_device_id device,
+        const std::string& source,
+        const std::string& buildOptions) {
+    std::string key = this->getDeviceInfoString(device, CL_DEVICE_NAME);
+    key.push_back('\0');
+    key += this->getDeviceInfoString(device, CL_DRIVER_VERSION);
+    key.push_back('\0');
+    key += buildOptions;
+    key.push_back('\0');
+    key += source;
+
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < key.size(); i++) {
+        hash ^= static_cast<uint8_t>(key[i]);
+        hash *= 1099511628211ULL;
+    }
+
+    char hashStr[17];
+    snprintf(hashStr, sizeof(hashStr), "%016llx", static_cast<unsigned long long>(hash));
+
+    return this->cacheDirectory_ + "/" + std::string(hashStr) + ".clbin";
+}
+
+cl_program OpenClProgramCache::loadBinary(
+        cl_context context,
+        cl_device_id device,
+        const std::string& cacheFilePath,
+        const std::string& buildOptions) {
+    std::ifstream inputStream(cacheFilePath, std::ios::in | std::ios::binary);
+    if (!inputStream.good()) {
+        return NULL;
+    }
+
+    std::vector<unsigned char> binary(
+        (std::istreambuf_iterator<char>(inputStream)),
+        std::istreambuf_iterator<char>());
+
+    if (binary.empty()) {
+        return NULL;
+    }
+
+    const unsigned char* binaryData = binary.data();
+    size_t binarySize = binary.size();
+    cl_int binaryStatus;
+    cl_int ret;
+
+    cl_program program = clCreateProgramWithBinary(
+        context,
+        1,             // num devices
+        &device,
+        &binarySize,
+        &binaryData,
+        &binaryStatus,
+        &ret);
+
+    if ((ret != CL_SUCCESS) || (binaryStatus != CL_SUCCESS)) {
+        if (program != NULL) {
+            clReleaseProgram(program);
+        }
+        return NULL;
+    }
+
+    // Even binaries need to be "built", which is cheap compared to compiling from source.
+    ret = clBuildProgram(program, 1, &device, buildOptions.c_str(), NULL, NULL);
+    if (ret != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return NULL;
+    }
+
+    return program;
+}
+
+void OpenClProgramCache::storeBinary(
+        cl_program program,
+        const std::string& cacheFilePath) {
+    size_t binarySize = 0;
+    cl_int ret = clGetProgramInfo(
+        program,
+        CL_PROGRAM_BINARY_SIZES,
+        sizeof(binarySize),
+        &binarySize,
+        NULL);
+
+    if ((ret != CL_SUCCESS) || (binarySize == 0)) {
+        return;
+    }
+
+    std::vector<unsigned char> binary(binarySize);
+    unsigned char* binaryData = binary.data();
+    ret = clGetProgramInfo(
+        program,
+        CL_PROGRAM_BINARIES,
+        sizeof(binaryData),
+        &binaryData,
+        NULL);
+
+    if (ret != CL_SUCCESS) {
+        return;
+    }
+
+    // A failure to write the cache is not fatal, the program is already built.
+    this->createDirectories(this->cacheDirectory_);
+
+    // Write to a temporary file and rename it into place,
+    //   so that concurrent processes never see a partial binary.
+    std::string temporaryPath = cacheFilePath + "." + std::to_string(getpid()) + ".tmp";
+    std::ofstream outputStream(temporaryPath, std::ios::out | std::ios::binary);
+    if (!outputStream.good()) {
+        return;
+    }
+
+    outputStream.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+    outputStream.close();
+
+    if (outputStream.fail() || (rename(temporaryPath.c_str(), cacheFilePath.c_str()) != 0)) {
+        remove(temporaryPath.c_str());
+    }
+}
+
+cl_program OpenClProgramCache::buildFromSource(
+        cl_context context,
+        cl_device_id device,
+        const std::string& source,
+        const std::string& buildOptions) {
+    cl_int ret;
+    const char* programTxt = source.c_str();
+    size_t sz = source.size();
+    cl_program program = clCreateProgramWithSource(
+            context,
+            1, // count (e.g. number of programs)
+            static_cast<const char**>(&programTxt),
+            static_cast<const size_t*>(&sz),
+            &ret);
+
+    if (ret != CL_SUCCESS) {
+        throw std::runtime_error("Error: clCreateProgramWithSource failed with OpenCL error " + std::to_string(ret) + ".");
+    }
+
+    ret = clBuildProgram(
+            program, 
+            1, 
+            &device, 
+            buildOptions.c_str(), // program build options
+            NULL,                 // error callback
+            NULL);                // user data for error callback
+
+    if (ret != CL_SUCCESS) {
+        size_t length;
+        char buffer[8192];
+        clGetProgramBuildInfo(
+            program,
+            device,
+            CL_PROGRAM_BUILD_LOG,
+            sizeof(buffer),
+            buffer,
+            &length);
+
+        clReleaseProgram(program);
+
+        std::string error(buffer);
+        throw std::runtime_error(error);
+    }
+
+    return program;
+}
+
+std::string OpenClProgramCache::getDeviceInfoString(
+        cl_device_id device,
+        cl_device_info paramName) {
+    size_t length = 0;
+    cl_int ret = clGetDeviceInfo(device, paramName, 0, NULL, &length);
+    if ((ret != CL_SUCCESS) || (length == 0)) {
+        return std::string();
+    }
+
+    std::vector<char> value(length);
+    ret = clGetDeviceInfo(device, paramName, length, value.data(), NULL);
+    if (ret != CL_SUCCESS) {
+        return std::string();
+    }
+
+    return std::string(value.data());
+}
+
+void OpenClProgramCache::createDirectories(const std::string& path) {
+    for (size_t i = 1; i <= path.size(); i++) {
+        if ((i == path.size()) || (path[i] == '/')) {
+            mkdir(path.substr(0, i).c_str(), 0755);
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "../include/OpenMpThreadedDisparityMapGenerator.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
 
 #include <iostream>
 
@@ -22,14 +23,44 @@ void OpenMpThreadedDisparityMapGenerator::computeDisparity(
         const cv::Mat& leftImage,
         const cv::Mat& rightImage,
         cv::Mat& disparity) {
-    #pragma omp parallel for collapse(2) default(none) shared(leftImage, rightImage, disparity)
+    const cv::Mat& leftGray = GrayscaleConverter::ensureGray(leftImage, this->leftGrayImage_);
+    const cv::Mat& rightGray = GrayscaleConverter::ensureGray(rightImage, this->rightGrayImage_);
+
+    #pragma omp parallel for collapse(2) default(none) shared(leftGray, rightGray, disparity)
     for (int y = 0; y < disparity.rows; y++) {
         for (int x = 0; x < disparity.cols; x++) {
             disparity.at<float>(y, x) = computeDisparityForPixel(
                 y,
                 x,
-                leftImage,
-                rightImage);
+                leftGray,
+                rightGray);
+        }
+    }
+}
+
+bool OpenMpThreadedDisparityMapGenerator::beginSparseQuery() {
+    return true;
+}
+
+void OpenMpThreadedDisparityMapGenerator::computeDisparitySpan(
+        const cv::Mat& leftGray,
+        const cv::Mat& rightGray,
+        int y,
+        int minX,
+        int maxX,
+        float* disparities,
+        int* costs) {
+    for (int x = minX; x < maxX; x++) {
+        int cost;
+        disparities[x - minX] = computeDisparityForPixel(
+            y,
+            x,
+            leftGray,
+            rightGray,
+            &cost);
+
+        if (costs != nullptr) {
+            costs[x - minX] = cost;
         }
     }
 }
@@ -50,13 +81,19 @@ void OpenMpThreadedDisparityMapGenerator::ensureParametersValid() {
     if (this->parameters_.rightScanSteps < 0) {
         throw std::runtime_error("Error: right scan steps is negative.");
     }
+
+    int disparityRange = this->parameters_.leftScanSteps + this->parameters_.rightScanSteps + 1;
+    if (disparityRange > MAX_DISPARITY_RANGE) {
+        throw std::runtime_error("Error: a disparity range of " + std::to_string(disparityRange) + " is larger than the supported " + std::to_string(MAX_DISPARITY_RANGE) + ".");
+    }
 }
 
 float OpenMpThreadedDisparityMapGenerator::computeDisparityForPixel(
         int y, 
         int x,
         const cv::Mat& leftImage,
-        const cv::Mat& rightImage) {
+        const cv::Mat& rightImage,
+        int* bestCost) {
 
     float localDisparityBuf[512];
     int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
@@ -104,6 +141,10 @@ float OpenMpThreadedDisparityMapGenerator::computeDisparityForPixel(
         }
     }
 
+    if (bestCost != nullptr) {
+        *bestCost = bestSadValue;
+    }
+
     float disparity = static_cast<float>(std::abs(bestIndex - zeroDisparityIndex));
     if ((bestIndex == 0)
         ||
@@ -148,3 +189,22 @@ int OpenMpThreadedDisparityMapGenerator::computeSadOverBlock(
 
     return sum;
 }
+
+static DisparityMapBackendInfo_t createBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "OpenMP";
+    info.description = "Scalar matcher, parallel over rows with OpenMP.";
+    // computeDisparityForPixel() keeps the costs of a pixel on the stack.
+    info.maxDisparityRange = OpenMpThreadedDisparityMapGenerator::MAX_DISPARITY_RANGE;
+    info.supportsSparseQueries = true;
+    info.nanosecondsPerComparison = 1.0;
+    info.scalesWithOpenMpThreads = true;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<OpenMpThreadedDisparityMapGenerator>(parameters);
+    };
+    return info;
+}
+
+static DisparityMapBackendRegistration registration(createBackendInfo());
@@ -1,17 +1,34 @@
 #include "../include/OpenMpThreadedSimdDisparityMapGenerator.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
 
+#include <cstring>
 #include <iostream>
 
 OpenMpThreadedSimdDisparityMapGenerator::OpenMpThreadedSimdDisparityMapGenerator(
         const DisparityMapAlgorithmParameters_t& parameters)
         : parameters_(parameters) {
     this->ensureParametersValid();
+    this->resetIncrementalState();
+    this->resetBlockRowCounters();
+    this->loadRectifier();
 }
 
 void OpenMpThreadedSimdDisparityMapGenerator::setParameters(
         const DisparityMapAlgorithmParameters_t& parameters) {
+    // The ring buffers of a stream are sized by the block size.
+    if (this->streaming_) {
+        throw std::runtime_error("Error: the parameters cannot change during a stream.");
+    }
+
+    bool rectificationMapsChanged = (parameters.rectificationMapsPath != this->parameters_.rectificationMapsPath);
+
     this->parameters_ = parameters;
     this->ensureParametersValid();
+    this->resetIncrementalState();
+
+    if (rectificationMapsChanged) {
+        this->loadRectifier();
+    }
 }
 
 const DisparityMapAlgorithmParameters_t& OpenMpThreadedSimdDisparityMapGenerator::getParameters() const {
@@ -22,18 +39,226 @@ void OpenMpThreadedSimdDisparityMapGenerator::computeDisparity(
         const cv::Mat& leftImage,
         const cv::Mat& rightImage,
         cv::Mat& disparity) {
-    #pragma omp parallel for collapse(2) default(none) shared(leftImage, rightImage, disparity)
+    this->resetBlockRowCounters();
+
+    if (this->rectifier_ != nullptr) {
+        this->computeDisparityInStrips(leftImage, rightImage, disparity);
+        return;
+    }
+
+    // The change detectors keep whole reference frames, so color input is converted up front.
+    if (this->parameters_.incrementalTileSize > 0) {
+        this->computeDisparityIncremental(
+            GrayscaleConverter::ensureGray(leftImage, this->leftGrayImage_),
+            GrayscaleConverter::ensureGray(rightImage, this->rightGrayImage_),
+            disparity);
+        return;
+    }
+
+    // A cost volume window is filled in batches of strips.
+    if ((leftImage.type() != CV_8UC1)
+        ||
+        (rightImage.type() != CV_8UC1)
+        ||
+        (this->postProcessor_->isEnabled())
+        ||
+        (this->pointCloudWriter_ != nullptr)
+        ||
+        (this->depthOutputEnabled_)
+        ||
+        (this->parameters_.costVolumeEnabled && (this->parameters_.costVolumeWindowRows > 0))) {
+        this->computeDisparityInStrips(leftImage, rightImage, disparity);
+        return;
+    }
+
+    this->beginCostVolumeFrame(disparity.rows, disparity.cols);
+    this->beginConfidenceFrame(disparity.rows, disparity.cols);
+
+    #pragma omp parallel for default(none) shared(leftImage, rightImage, disparity)
     for (int y = 0; y < disparity.rows; y++) {
-        for (int x = 0; x < disparity.cols; x++) {
-            disparity.at<float>(y, x) = computeDisparityForPixel(
-                y,
-                x,
-                leftImage,
-                rightImage);
+        computeDisparityForRow(
+            y,
+            0,
+            disparity.cols,
+            leftImage.rows,
+            0,
+            leftImage,
+            rightImage,
+            disparity.ptr<float>(y),
+            nullptr,
+            this->getCostVolumeRow(y),
+            this->getConfidenceRow(y));
+    }
+
+    this->completeCostVolumeRows(0, disparity.rows);
+}
+
+float OpenMpThreadedSimdDisparityMapGenerator::getRecomputedTileFraction() const {
+    return this->recomputedTileFraction_;
+}
+
+float OpenMpThreadedSimdDisparityMapGenerator::getSkippedBlockRowFraction() const {
+    int64_t numBlockRows = this->numBlockRows_.load();
+    if (numBlockRows == 0) {
+        return 0.0f;
+    }
+
+    return 1.0f - (static_cast<float>(this->numBlockRowsSummed_.load()) / static_cast<float>(numBlockRows));
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::setRectifier(
+        std::shared_ptr<const StereoRectifier> rectifier) {
+    if ((rectifier != nullptr) && (this->parameters_.incrementalTileSize > 0)) {
+        throw std::runtime_error("Error: rectification cannot be combined with incremental recomputation.");
+    }
+
+    this->rectifier_ = rectifier;
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::setPointCloudWriter(
+        std::shared_ptr<PointCloudWriter> writer) {
+    if ((writer != nullptr) && ((this->parameters_.focalLength <= 0) || (this->parameters_.baseline <= 0))) {
+        throw std::runtime_error("Error: point cloud output needs a positive focal length and baseline.");
+    }
+
+    this->pointCloudWriter_ = writer;
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::setDepthOutputEnabled(bool enabled) {
+    if (enabled && ((this->parameters_.focalLength <= 0) || (this->parameters_.baseline <= 0))) {
+        throw std::runtime_error("Error: depth output needs a positive focal length and baseline.");
+    }
+
+    this->depthOutputEnabled_ = enabled;
+    if (!enabled) {
+        this->depth_ = cv::Mat();
+    }
+}
+
+const cv::Mat& OpenMpThreadedSimdDisparityMapGenerator::getDepth() const {
+    return this->depth_;
+}
+
+const CostVolume& OpenMpThreadedSimdDisparityMapGenerator::getCostVolume() const {
+    return this->costVolume_;
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::setCostVolumeCallback(CostVolumeCallback callback) {
+    this->costVolumeCallback_ = callback;
+}
+
+const cv::Mat& OpenMpThreadedSimdDisparityMapGenerator::getConfidence() const {
+    return this->confidence_;
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::beginStream(
+        int cols,
+        DisparityRowCallback callback) {
+    if (cols <= 0) {
+        throw std::runtime_error("Error: a stream needs a positive number of columns.");
+    }
+
+    if (!callback) {
+        throw std::runtime_error("Error: a stream needs a row callback.");
+    }
+
+    if ((this->rectifier_ != nullptr)
+        ||
+        (this->postProcessor_->isEnabled())
+        ||
+        (this->parameters_.costVolumeEnabled)
+        ||
+        (this->pointCloudWriter_ != nullptr)
+        ||
+        (this->depthOutputEnabled_)) {
+        throw std::runtime_error("Error: streams do not support rectification, post-processing, cost volumes, depth or point clouds.");
+    }
+
+    this->leftStreamRows_.configure(this->parameters_.blockSize, cols, 0);
+    this->rightStreamRows_.configure(this->parameters_.blockSize, cols, 0);
+    this->streamDisparityRow_.resize(cols);
+    this->streamCallback_ = callback;
+    this->streamNextRow_ = 0;
+    this->streaming_ = true;
+    this->resetBlockRowCounters();
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::pushRows(
+        const cv::Mat& leftRows,
+        const cv::Mat& rightRows) {
+    if (!this->streaming_) {
+        throw std::runtime_error("Error: rows were pushed outside of a stream.");
+    }
+
+    if (leftRows.rows != rightRows.rows) {
+        throw std::runtime_error("Error: different numbers of left and right rows were pushed.");
+    }
+
+    GrayscaleConverter::ensureSupportedType(leftRows);
+    GrayscaleConverter::ensureSupportedType(rightRows);
+
+    int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
+    for (int y = 0; y < leftRows.rows; y++) {
+        this->leftStreamRows_.pushRow(leftRows, y);
+        this->rightStreamRows_.pushRow(rightRows, y);
+
+        // The height is not known yet, but every row the block of the next row reads is.
+        int numRowsPushed = this->leftStreamRows_.getNumRowsPushed();
+        if (numRowsPushed - this->streamNextRow_ > maxBlockStep) {
+            this->emitStreamRow(this->streamNextRow_, std::numeric_limits<int>::max());
+            this->streamNextRow_++;
         }
     }
 }
 
+void OpenMpThreadedSimdDisparityMapGenerator::endStream() {
+    if (!this->streaming_) {
+        throw std::runtime_error("Error: there is no stream to end.");
+    }
+
+    int imageRows = this->leftStreamRows_.getNumRowsPushed();
+    for (; this->streamNextRow_ < imageRows; this->streamNextRow_++) {
+        this->emitStreamRow(this->streamNextRow_, imageRows);
+    }
+
+    this->streaming_ = false;
+    this->streamCallback_ = nullptr;
+}
+
+bool OpenMpThreadedSimdDisparityMapGenerator::beginSparseQuery() {
+    if (this->rectifier_ != nullptr) {
+        throw std::runtime_error("Error: sparse disparity queries do not support fused rectification.");
+    }
+
+    // The filters need the neighbourhood of every pixel, which the dense map has and a query does not.
+    if (this->postProcessor_->isEnabled()) {
+        throw std::runtime_error("Error: sparse disparity queries do not support post-processing.");
+    }
+
+    this->resetBlockRowCounters();
+    return true;
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::computeDisparitySpan(
+        const cv::Mat& leftGray,
+        const cv::Mat& rightGray,
+        int y,
+        int minX,
+        int maxX,
+        float* disparities,
+        int* costs) {
+    computeDisparityForRow(
+        y,
+        minX,
+        maxX,
+        leftGray.rows,
+        0,
+        leftGray,
+        rightGray,
+        disparities,
+        costs);
+}
+
 void OpenMpThreadedSimdDisparityMapGenerator::ensureParametersValid() {
     if (this->parameters_.blockSize < 0) {
         throw std::runtime_error("Error: block size is less than zero.");
@@ -50,21 +275,641 @@ void OpenMpThreadedSimdDisparityMapGenerator::ensureParametersValid() {
     if (this->parameters_.rightScanSteps < 0) {
         throw std::runtime_error("Error: right scan steps is negative.");
     }
+
+    int disparityRange = this->parameters_.leftScanSteps + this->parameters_.rightScanSteps + 1;
+    if (disparityRange > MAX_DISPARITY_RANGE) {
+        throw std::runtime_error("Error: a disparity range of " + std::to_string(disparityRange) + " is larger than the supported " + std::to_string(MAX_DISPARITY_RANGE) + ".");
+    }
+
+    if (this->parameters_.blockSize > MAX_BLOCK_SIZE) {
+        throw std::runtime_error("Error: a block size of " + std::to_string(this->parameters_.blockSize) + " is larger than the supported " + std::to_string(MAX_BLOCK_SIZE) + ".");
+    }
+
+    if (this->parameters_.incrementalTileSize < 0) {
+        throw std::runtime_error("Error: incremental tile size is negative.");
+    }
+
+    if (this->parameters_.incrementalChangeThreshold < 0) {
+        throw std::runtime_error("Error: incremental change threshold is negative.");
+    }
+
+    if (this->parameters_.openMpStripHeight < MIN_STRIP_HEIGHT) {
+        throw std::runtime_error("Error: the strip height must be at least " + std::to_string(MIN_STRIP_HEIGHT) + ".");
+    }
+
+    if (this->parameters_.costVolumeWindowRows < 0) {
+        throw std::runtime_error("Error: the cost volume window is negative.");
+    }
+
+    // A batch is at least one strip, which must fit in the window.
+    if ((this->parameters_.costVolumeWindowRows > 0)
+        &&
+        (this->parameters_.costVolumeWindowRows < this->parameters_.openMpStripHeight)) {
+        throw std::runtime_error("Error: the cost volume window must hold at least one strip of openMpStripHeight rows.");
+    }
+
+    // Incremental recomputation revisits tiles anywhere in the frame.
+    if ((this->parameters_.costVolumeEnabled)
+        &&
+        (this->parameters_.costVolumeWindowRows > 0)
+        &&
+        (this->parameters_.incrementalTileSize > 0)) {
+        throw std::runtime_error("Error: a cost volume window cannot be combined with incremental recomputation.");
+    }
+
+    this->subpixelInterpolation_ = SubpixelRefiner::parse(this->parameters_.subpixelInterpolation);
+    this->confidenceMeasure_ = MatchConfidence::parse(this->parameters_.confidenceMeasure);
+    this->postProcessor_ = std::make_unique<DisparityPostProcessor>(this->parameters_);
+
+    if ((!this->parameters_.rectificationMapsPath.empty())
+        &&
+        (this->parameters_.incrementalTileSize > 0)) {
+        throw std::runtime_error("Error: rectification cannot be combined with incremental recomputation.");
+    }
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::loadRectifier() {
+    if (this->parameters_.rectificationMapsPath.empty()) {
+        this->rectifier_.reset();
+        return;
+    }
+
+    this->rectifier_ = std::make_shared<const StereoRectifier>(
+        StereoRectifier::load(this->parameters_.rectificationMapsPath));
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::computeDisparityInStrips(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        cv::Mat& disparity) {
+    const StereoRectifier* rectifier = this->rectifier_.get();
+    int imageRows = (rectifier != nullptr) ? rectifier->getHeight() : leftImage.rows;
+    int imageCols = (rectifier != nullptr) ? rectifier->getWidth() : leftImage.cols;
+
+    if ((disparity.rows != imageRows)
+        ||
+        (disparity.cols != imageCols)) {
+        throw std::runtime_error((rectifier != nullptr)
+            ? "Error: the disparity must be the size of the rectification maps."
+            : "Error: the disparity must be the size of the input images.");
+    }
+
+    GrayscaleConverter::ensureSupportedType(leftImage);
+    GrayscaleConverter::ensureSupportedType(rightImage);
+
+    // Each thread rectifies and / or converts to gray the strip it is about to match,
+    //   plus maxBlockStep halo rows, into its own buffers.
+    //   The grayscale or rectified frames are never written out in full.
+    //   Gray input that needs neither is matched in place.
+    bool matchInPlace = (rectifier == nullptr) && (leftImage.type() == CV_8UC1) && (rightImage.type() == CV_8UC1);
+    int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
+    int stripHeight = this->parameters_.openMpStripHeight;
+    int numStrips = (imageRows + stripHeight - 1) / stripHeight;
+    size_t bandBufferSize = matchInPlace
+        ? 0
+        : (stripHeight + (2 * maxBlockStep)) * imageCols;
+
+    // With a median filter, the matcher writes to a separate buffer the filter reads from.
+    DisparityPostProcessor& postProcessor = *this->postProcessor_;
+    bool emitPoints = (this->pointCloudWriter_ != nullptr);
+    bool project = emitPoints || this->depthOutputEnabled_;
+    bool finishStrips = postProcessor.isEnabled() || project;
+    if (postProcessor.isMedianFilterEnabled()) {
+        this->rawDisparity_.create(imageRows, imageCols, CV_32FC1);
+    }
+    cv::Mat& matchedDisparity = postProcessor.isMedianFilterEnabled() ? this->rawDisparity_ : disparity;
+
+    std::vector<std::atomic<int>> stripStates(numStrips);
+    for (int strip = 0; strip < numStrips; strip++) {
+        stripStates[strip].store(STRIP_UNMATCHED);
+    }
+    postProcessor.beginFrame(imageRows, imageCols);
+    this->beginCostVolumeFrame(imageRows, imageCols);
+    this->beginConfidenceFrame(imageRows, imageCols);
+
+    // With a cost volume window, strips are matched in batches that fit in it,
+    //   and each batch is completed before the next one overwrites older rows.
+    int stripsPerBatch = numStrips;
+    if (this->parameters_.costVolumeEnabled && (this->parameters_.costVolumeWindowRows > 0)) {
+        stripsPerBatch = this->parameters_.costVolumeWindowRows / stripHeight;
+    }
+
+    // Points take their intensity from the matched (rectified, gray) left image.
+    //   Unless it is the input, the matched rows of each strip are kept for this.
+    if (project) {
+        this->beginProjectionFrame(imageRows, imageCols);
+    }
+    if (emitPoints) {
+        if (matchInPlace) {
+            this->pointIntensity_ = leftImage;
+        } else {
+            this->pointIntensity_.create(imageRows, imageCols, CV_8UC1);
+        }
+    }
+
+    #pragma omp parallel default(none) shared(leftImage, rightImage, disparity, matchedDisparity, rectifier, matchInPlace, emitPoints, finishStrips, stripStates, imageRows, imageCols, maxBlockStep, stripHeight, numStrips, stripsPerBatch, bandBufferSize)
+    {
+        std::vector<uint8_t> leftBandBuffer(bandBufferSize, 0);
+        std::vector<uint8_t> rightBandBuffer(bandBufferSize, 0);
+
+        for (int batchMinStrip = 0; batchMinStrip < numStrips; batchMinStrip += stripsPerBatch) {
+            int batchMaxStrip = std::min(numStrips, batchMinStrip + stripsPerBatch);
+
+            #pragma omp for schedule(dynamic)
+            for (int strip = batchMinStrip; strip < batchMaxStrip; strip++) {
+                int stripMinY = strip * stripHeight;
+                int stripMaxY = std::min(imageRows, stripMinY + stripHeight);
+                int bandMinY = std::max(0, stripMinY - maxBlockStep);
+                int bandMaxY = std::min(imageRows, stripMaxY + maxBlockStep);
+
+                cv::Mat leftBand;
+                cv::Mat rightBand;
+                if (matchInPlace) {
+                    leftBand = leftImage.rowRange(bandMinY, bandMaxY);
+                    rightBand = rightImage.rowRange(bandMinY, bandMaxY);
+                } else {
+                    if (rectifier != nullptr) {
+                        rectifier->rectifyLeftRows(leftImage, bandMinY, bandMaxY, leftBandBuffer.data());
+                        rectifier->rectifyRightRows(rightImage, bandMinY, bandMaxY, rightBandBuffer.data());
+                    } else {
+                        GrayscaleConverter::convertRows(leftImage, bandMinY, bandMaxY, leftBandBuffer.data());
+                        GrayscaleConverter::convertRows(rightImage, bandMinY, bandMaxY, rightBandBuffer.data());
+                    }
+
+                    leftBand = cv::Mat(bandMaxY - bandMinY, imageCols, CV_8UC1, leftBandBuffer.data());
+                    rightBand = cv::Mat(bandMaxY - bandMinY, imageCols, CV_8UC1, rightBandBuffer.data());
+
+                    if (emitPoints) {
+                        cv::Mat intensityRows = this->pointIntensity_.rowRange(stripMinY, stripMaxY);
+                        leftBand.rowRange(stripMinY - bandMinY, stripMaxY - bandMinY).copyTo(intensityRows);
+                    }
+                }
+
+                for (int y = stripMinY; y < stripMaxY; y++) {
+                    computeDisparityForRow(
+                        y,
+                        0,
+                        imageCols,
+                        imageRows,
+                        bandMinY,
+                        leftBand,
+                        rightBand,
+                        matchedDisparity.ptr<float>(y),
+                        nullptr,
+                        this->getCostVolumeRow(y),
+                        this->getConfidenceRow(y));
+                }
+
+                if (finishStrips) {
+                    stripStates[strip].store(STRIP_MATCHED);
+                    for (int neighbour = strip - 1; neighbour <= strip + 1; neighbour++) {
+                        this->tryFinishStrip(neighbour, numStrips, imageRows, stripStates, matchedDisparity, disparity);
+                    }
+                }
+            }
+
+            // The implicit barrier of the loop above guarantees the whole batch is matched.
+            #pragma omp single
+            this->completeCostVolumeRows(batchMinStrip * stripHeight, std::min(imageRows, batchMaxStrip * stripHeight));
+        }
+    }
+
+    // Speckles are only known once the whole frame is labelled, so their depth and points are projected last.
+    if (postProcessor.isSpeckleFilterEnabled()) {
+        postProcessor.removeSpeckles(disparity, stripHeight);
+
+        if (project) {
+            #pragma omp parallel for schedule(dynamic) default(none) shared(disparity, imageRows, stripHeight, numStrips)
+            for (int strip = 0; strip < numStrips; strip++) {
+                int minY = strip * stripHeight;
+                this->projectRows(disparity, minY, std::min(imageRows, minY + stripHeight));
+            }
+        }
+    }
 }
 
-float OpenMpThreadedSimdDisparityMapGenerator::computeDisparityForPixel(
+void OpenMpThreadedSimdDisparityMapGenerator::tryFinishStrip(
+        int strip,
+        int numStrips,
+        int imageRows,
+        std::vector<std::atomic<int>>& stripStates,
+        const cv::Mat& rawDisparity,
+        cv::Mat& disparity) {
+    if ((strip < 0) || (strip >= numStrips)) {
+        return;
+    }
+
+    // The median reads at most 2 rows beyond the strip, so only the adjacent strips matter.
+    if (this->postProcessor_->isMedianFilterEnabled()) {
+        if (((strip > 0) && (stripStates[strip - 1].load() == STRIP_UNMATCHED))
+            ||
+            ((strip + 1 < numStrips) && (stripStates[strip + 1].load() == STRIP_UNMATCHED))) {
+            return;
+        }
+    }
+
+    int expected = STRIP_MATCHED;
+    if (!stripStates[strip].compare_exchange_strong(expected, STRIP_POST_PROCESSED)) {
+        return;
+    }
+
+    int minY = strip * this->parameters_.openMpStripHeight;
+    int maxY = std::min(imageRows, minY + this->parameters_.openMpStripHeight);
+
+    if (this->postProcessor_->isMedianFilterEnabled()) {
+        this->postProcessor_->medianFilterRows(rawDisparity, minY, maxY, disparity);
+    }
+
+    this->postProcessor_->labelSpeckleRows(disparity, minY, maxY);
+
+    if (((this->pointCloudWriter_ != nullptr) || this->depthOutputEnabled_)
+        &&
+        (!this->postProcessor_->isSpeckleFilterEnabled())) {
+        this->projectRows(disparity, minY, maxY);
+    }
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::emitStreamRow(int y, int imageRows) {
+    int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
+    int bandMinY = std::max(0, y - maxBlockStep);
+    int bandMaxY = std::min(this->leftStreamRows_.getNumRowsPushed(), y + maxBlockStep + 1);
+    cv::Mat leftBand = this->leftStreamRows_.getRows(bandMinY, bandMaxY);
+    cv::Mat rightBand = this->rightStreamRows_.getRows(bandMinY, bandMaxY);
+
+    // A single row is split across the threads, so that it is emitted as soon as possible.
+    int cols = static_cast<int>(this->streamDisparityRow_.size());
+    int numChunks = (cols + SUBPIXEL_CHUNK_SIZE - 1) / SUBPIXEL_CHUNK_SIZE;
+    float* disparityRow = this->streamDisparityRow_.data();
+
+    #pragma omp parallel for default(none) shared(y, imageRows, bandMinY, leftBand, rightBand, cols, numChunks, disparityRow)
+    for (int chunk = 0; chunk < numChunks; chunk++) {
+        int minX = chunk * SUBPIXEL_CHUNK_SIZE;
+        computeDisparityForRow(
+            y,
+            minX,
+            std::min(cols, minX + SUBPIXEL_CHUNK_SIZE),
+            imageRows,
+            bandMinY,
+            leftBand,
+            rightBand,
+            disparityRow + minX);
+    }
+
+    this->streamCallback_(y, disparityRow);
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::beginProjectionFrame(int imageRows, int imageCols) {
+    this->pointProjector_ = std::make_unique<DisparityProjector>(
+        DisparityProjector::fromParameters(this->parameters_, imageRows, imageCols));
+
+    if (this->depthOutputEnabled_) {
+        this->depth_.create(imageRows, imageCols, CV_32FC1);
+    }
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::projectRows(
+        const cv::Mat& disparity,
+        int minY,
+        int maxY) {
+    if (this->depthOutputEnabled_) {
+        this->pointProjector_->computeDepthRows(disparity, minY, maxY, this->depth_);
+    }
+
+    if (this->pointCloudWriter_ == nullptr) {
+        return;
+    }
+
+    std::vector<PointXYZI_t> points;
+    points.reserve((maxY - minY) * disparity.cols);
+
+    this->pointProjector_->projectRows(
+        disparity,
+        this->pointIntensity_,
+        (this->confidenceMeasure_ != ConfidenceMeasure::None) ? this->confidence_ : cv::Mat(),
+        this->parameters_.minConfidence,
+        minY,
+        maxY,
+        points);
+
+    this->pointCloudWriter_->writePoints(points.data(), points.size());
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::beginCostVolumeFrame(int imageRows, int imageCols) {
+    if (!this->parameters_.costVolumeEnabled) {
+        return;
+    }
+
+    this->costVolume_.configure(
+        imageRows,
+        imageCols,
+        this->parameters_.leftScanSteps,
+        this->parameters_.rightScanSteps,
+        this->parameters_.costVolumeWindowRows);
+    this->costVolume_.beginFrame();
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::completeCostVolumeRows(int minY, int maxY) {
+    if (!this->parameters_.costVolumeEnabled) {
+        return;
+    }
+
+    this->costVolume_.setRowsComplete(maxY);
+    if (this->costVolumeCallback_) {
+        this->costVolumeCallback_(this->costVolume_, minY, maxY);
+    }
+}
+
+uint16_t* OpenMpThreadedSimdDisparityMapGenerator::getCostVolumeRow(int y) {
+    return this->parameters_.costVolumeEnabled ? this->costVolume_.getMutableRow(y) : nullptr;
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::beginConfidenceFrame(int imageRows, int imageCols) {
+    if (this->confidenceMeasure_ == ConfidenceMeasure::None) {
+        return;
+    }
+
+    this->confidence_.create(imageRows, imageCols, CV_32FC1);
+}
+
+float* OpenMpThreadedSimdDisparityMapGenerator::getConfidenceRow(int y) {
+    return (this->confidenceMeasure_ != ConfidenceMeasure::None) ? this->confidence_.ptr<float>(y) : nullptr;
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::resetIncrementalState() {
+    this->recomputedTileFraction_ = 1.0f;
+    this->cachedDisparity_ = cv::Mat();
+
+    if (this->parameters_.incrementalTileSize > 0) {
+        this->leftChangeDetector_ = std::make_unique<TileChangeDetector>(
+            this->parameters_.incrementalTileSize,
+            this->parameters_.incrementalChangeThreshold);
+        this->rightChangeDetector_ = std::make_unique<TileChangeDetector>(
+            this->parameters_.incrementalTileSize,
+            this->parameters_.incrementalChangeThreshold);
+    } else {
+        this->leftChangeDetector_.reset();
+        this->rightChangeDetector_.reset();
+    }
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::resetBlockRowCounters() {
+    this->numBlockRows_.store(0);
+    this->numBlockRowsSummed_.store(0);
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::computeDisparityIncremental(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        cv::Mat& disparity) {
+    int tileSize = this->parameters_.incrementalTileSize;
+    int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
+
+    if ((this->cachedDisparity_.rows != disparity.rows)
+        ||
+        (this->cachedDisparity_.cols != disparity.cols)) {
+        this->leftChangeDetector_->reset();
+        this->rightChangeDetector_->reset();
+        this->cachedDisparity_.create(disparity.rows, disparity.cols, CV_32FC1);
+    }
+
+    this->leftChangeDetector_->update(leftImage, this->leftChangedTiles_);
+    this->rightChangeDetector_->update(rightImage, this->rightChangedTiles_);
+
+    int numTileRows = this->leftChangeDetector_->getNumTileRows();
+    int numTileCols = this->leftChangeDetector_->getNumTileCols();
+
+    this->computeChangedTilesIntegral(
+        this->leftChangedTiles_, numTileRows, numTileCols, this->leftChangedTilesIntegral_);
+    this->computeChangedTilesIntegral(
+        this->rightChangedTiles_, numTileRows, numTileCols, this->rightChangedTilesIntegral_);
+
+    // An output pixel depends on the left image within the block around it,
+    //   and on the right image within the block swept across the scan range.
+    this->dirtyTiles_.clear();
+    for (int ty = 0; ty < numTileRows; ty++) {
+        for (int tx = 0; tx < numTileCols; tx++) {
+            int minY = (ty * tileSize) - maxBlockStep;
+            int maxY = ((ty + 1) * tileSize) - 1 + maxBlockStep;
+            int minX = (tx * tileSize) - maxBlockStep;
+            int maxX = ((tx + 1) * tileSize) - 1 + maxBlockStep;
+
+            bool dirty = this->anyTileChanged(
+                    this->leftChangedTilesIntegral_,
+                    numTileRows,
+                    numTileCols,
+                    minY,
+                    minX,
+                    maxY,
+                    maxX)
+                ||
+                this->anyTileChanged(
+                    this->rightChangedTilesIntegral_,
+                    numTileRows,
+                    numTileCols,
+                    minY,
+                    minX - this->parameters_.leftScanSteps,
+                    maxY,
+                    maxX + this->parameters_.rightScanSteps);
+
+            if (dirty) {
+                this->dirtyTiles_.emplace_back((ty * numTileCols) + tx);
+            }
+        }
+    }
+
+    int numDirtyTiles = static_cast<int>(this->dirtyTiles_.size());
+    cv::Mat& cachedDisparity = this->cachedDisparity_;
+    this->beginCostVolumeFrame(disparity.rows, disparity.cols);
+    this->beginConfidenceFrame(disparity.rows, disparity.cols);
+
+    #pragma omp parallel for schedule(dynamic) default(none) shared(leftImage, rightImage, cachedDisparity, numDirtyTiles, numTileCols, tileSize)
+    for (int i = 0; i < numDirtyTiles; i++) {
+        int ty = this->dirtyTiles_[i] / numTileCols;
+        int tx = this->dirtyTiles_[i] % numTileCols;
+        int maxY = std::min(cachedDisparity.rows, (ty + 1) * tileSize);
+        int maxX = std::min(cachedDisparity.cols, (tx + 1) * tileSize);
+
+        for (int y = ty * tileSize; y < maxY; y++) {
+            computeDisparityForRow(
+                y,
+                tx * tileSize,
+                maxX,
+                leftImage.rows,
+                0,
+                leftImage,
+                rightImage,
+                cachedDisparity.ptr<float>(y) + (tx * tileSize),
+                nullptr,
+                this->getCostVolumeRow(y),
+                this->getConfidenceRow(y));
+        }
+    }
+
+    this->completeCostVolumeRows(0, disparity.rows);
+
+    this->recomputedTileFraction_ =
+        static_cast<float>(numDirtyTiles) / static_cast<float>(numTileRows * numTileCols);
+
+    if (this->postProcessor_->isEnabled()) {
+        this->postProcessor_->apply(this->cachedDisparity_, disparity);
+    } else if (disparity.data != this->cachedDisparity_.data) {
+        this->cachedDisparity_.copyTo(disparity);
+    }
+
+    if ((this->pointCloudWriter_ != nullptr) || this->depthOutputEnabled_) {
+        this->beginProjectionFrame(disparity.rows, disparity.cols);
+        this->pointIntensity_ = leftImage;
+        this->projectRows(disparity, 0, disparity.rows);
+    }
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::computeChangedTilesIntegral(
+        const std::vector<uint8_t>& changedTiles,
+        int numTileRows,
+        int numTileCols,
+        std::vector<int>& integral) {
+    int stride = numTileCols + 1;
+    integral.assign((numTileRows + 1) * stride, 0);
+
+    for (int ty = 0; ty < numTileRows; ty++) {
+        for (int tx = 0; tx < numTileCols; tx++) {
+            integral[((ty + 1) * stride) + tx + 1] =
+                changedTiles[(ty * numTileCols) + tx]
+                + integral[(ty * stride) + tx + 1]
+                + integral[((ty + 1) * stride) + tx]
+                - integral[(ty * stride) + tx];
+        }
+    }
+}
+
+bool OpenMpThreadedSimdDisparityMapGenerator::anyTileChanged(
+        const std::vector<int>& integral,
+        int numTileRows,
+        int numTileCols,
+        int minY,
+        int minX,
+        int maxY,
+        int maxX) {
+    int tileSize = this->parameters_.incrementalTileSize;
+    int stride = numTileCols + 1;
+
+    int minTy = std::max(0, minY) / tileSize;
+    int minTx = std::max(0, minX) / tileSize;
+    int maxTy = std::min(numTileRows - 1, maxY / tileSize);
+    int maxTx = std::min(numTileCols - 1, maxX / tileSize);
+
+    int count = integral[((maxTy + 1) * stride) + maxTx + 1]
+        - integral[(minTy * stride) + maxTx + 1]
+        - integral[((maxTy + 1) * stride) + minTx]
+        + integral[(minTy * stride) + minTx];
+
+    return (count > 0);
+}
+
+void OpenMpThreadedSimdDisparityMapGenerator::computeDisparityForRow(
+        int y,
+        int minX,
+        int maxX,
+        int imageRows,
+        int bandMinY,
+        const cv::Mat& leftBand,
+        const cv::Mat& rightBand,
+        float* disparities,
+        int* bestCosts,
+        uint16_t* costVolumeRow,
+        float* confidenceRow) {
+    int numDisparities = this->parameters_.leftScanSteps + this->parameters_.rightScanSteps + 1;
+    bool rateMatches = (this->confidenceMeasure_ != ConfidenceMeasure::None);
+    float minConfidence = this->parameters_.minConfidence;
+    int previousCosts[SUBPIXEL_CHUNK_SIZE];
+    int chunkBestCosts[SUBPIXEL_CHUNK_SIZE];
+    int nextCosts[SUBPIXEL_CHUNK_SIZE];
+    float confidences[SUBPIXEL_CHUNK_SIZE];
+
+    // Each pixel is searched from the disparity of its left neighbour.
+    int predictedSlot = -1;
+    int64_t numBlockRows = 0;
+    int64_t numBlockRowsSummed = 0;
+
+    // The search only finds the integer minimum. Subpixel refinement then runs over a chunk at a time.
+    for (int chunkMinX = minX; chunkMinX < maxX; chunkMinX += SUBPIXEL_CHUNK_SIZE) {
+        int chunkSize = std::min(SUBPIXEL_CHUNK_SIZE, maxX - chunkMinX);
+        float* chunkDisparities = disparities + (chunkMinX - minX);
+
+        for (int i = 0; i < chunkSize; i++) {
+            chunkDisparities[i] = computeIntegerDisparityForPixelInBand(
+                y,
+                chunkMinX + i,
+                imageRows,
+                bandMinY,
+                leftBand,
+                rightBand,
+                previousCosts[i],
+                chunkBestCosts[i],
+                nextCosts[i],
+                (costVolumeRow != nullptr)
+                    ? costVolumeRow + (static_cast<size_t>(chunkMinX + i) * numDisparities)
+                    : nullptr,
+                rateMatches ? &confidences[i] : nullptr,
+                predictedSlot,
+                numBlockRows,
+                numBlockRowsSummed);
+        }
+
+        if (rateMatches) {
+            // Unconfident matches are not worth refining.
+            for (int i = 0; i < chunkSize; i++) {
+                if (confidences[i] < minConfidence) {
+                    previousCosts[i] = 0;
+                    nextCosts[i] = 0;
+                }
+            }
+
+            if (confidenceRow != nullptr) {
+                std::copy(confidences, confidences + chunkSize, confidenceRow + chunkMinX);
+            }
+        }
+
+        SubpixelRefiner::refine(
+            this->subpixelInterpolation_,
+            chunkSize,
+            chunkDisparities,
+            previousCosts,
+            chunkBestCosts,
+            nextCosts);
+
+        if (bestCosts != nullptr) {
+            std::copy(chunkBestCosts, chunkBestCosts + chunkSize, bestCosts + (chunkMinX - minX));
+        }
+    }
+
+    this->numBlockRows_.fetch_add(numBlockRows, std::memory_order_relaxed);
+    this->numBlockRowsSummed_.fetch_add(numBlockRowsSummed, std::memory_order_relaxed);
+}
+
+float OpenMpThreadedSimdDisparityMapGenerator::computeIntegerDisparityForPixelInBand(
         int y, 
         int x,
-        const cv::Mat& leftImage,
-        const cv::Mat& rightImage) {
+        int imageRows,
+        int bandMinY,
+        const cv::Mat& leftBand,
+        const cv::Mat& rightBand,
+        int& previousCost,
+        int& bestCost,
+        int& nextCost,
+        uint16_t* costs,
+        float* confidence,
+        int& predictedSlot,
+        int64_t& numBlockRows,
+        int64_t& numBlockRowsSummed) {
 
-    float localDisparityBuf[512];
+    int localCostBuf[512];
     int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
 
     int templateLeftHalfWidth = std::min(x, maxBlockStep);
-    int templateRightHalfWidth = std::min(leftImage.cols - x - 1, maxBlockStep);
+    int templateRightHalfWidth = std::min(leftBand.cols - x - 1, maxBlockStep);
     int templateTopHalfHeight = std::min(y, maxBlockStep);
-    int templateBottomHalfHeight = std::min(leftImage.rows - y - 1, maxBlockStep);
+    int templateBottomHalfHeight = std::min(imageRows - y - 1, maxBlockStep);
 
     int templateWidth = templateLeftHalfWidth + templateRightHalfWidth + 1;
     int templateHeight = templateTopHalfHeight + templateBottomHalfHeight + 1;
@@ -73,7 +918,7 @@ float OpenMpThreadedSimdDisparityMapGenerator::computeDisparityForPixel(
     int leftMinX = x - templateLeftHalfWidth;
 
     int rightMinStartX = std::max(0, x - this->parameters_.leftScanSteps - templateLeftHalfWidth);
-    int rightMaxStartX = std::min(leftImage.cols - templateWidth /*- 1*/, x + this->parameters_.rightScanSteps - templateLeftHalfWidth);
+    int rightMaxStartX = std::min(leftBand.cols - templateWidth /*- 1*/, x + this->parameters_.rightScanSteps - templateLeftHalfWidth);
 
     int numSteps = rightMaxStartX - rightMinStartX;
 
@@ -81,43 +926,161 @@ float OpenMpThreadedSimdDisparityMapGenerator::computeDisparityForPixel(
     int bestSadValue = std::numeric_limits<int>::max();
     int zeroDisparityIndex = x - rightMinStartX - templateLeftHalfWidth;
 
-    // Enabling parallelization here is faster than no parallelization at all,
-    // but is slower than parallelizing on the center pixel level
-    // #pragma omp parallel for
-    // #pragma omp simd
-    for (int xx = rightMinStartX; xx <= rightMaxStartX; xx++) {
-        int sad = computeSadOverBlockSimd(
-            leftMinY,
-            leftMinX,
-            leftMinY, // Ys are aligned for the two images
-            xx,
-            templateWidth,
-            templateHeight,
-            leftImage, 
-            rightImage);
+    // Slot k is the right block at x - leftScanSteps + k.
+    int numDisparities = this->parameters_.leftScanSteps + this->parameters_.rightScanSteps + 1;
+    int minSlot = rightMinStartX + templateLeftHalfWidth - x + this->parameters_.leftScanSteps;
+
+    bool trackPeakRatio = (confidence != nullptr) && (this->confidenceMeasure_ == ConfidenceMeasure::PeakRatio);
+    PeakRatioTracker peakRatioTracker;
+
+    // Early termination only keeps the costs that can still win, or still change the peak ratio,
+    //   so it needs the cost volume off. The costs around the minimum are completed afterwards.
+    bool terminateEarly = this->parameters_.earlyTerminationEnabled && (costs == nullptr);
+    numBlockRows += static_cast<int64_t>(numSteps + 1) * templateHeight;
+
+    if (terminateEarly) {
+        int predictedIndex = predictedSlot - minSlot;
+        if ((predictedSlot < 0) || (predictedIndex < 0) || (predictedIndex > numSteps)) {
+            predictedIndex = 0;
+        }
+
+        // The predicted candidate first, then the others in order.
+        for (int n = 0; n <= numSteps; n++) {
+            int i = (n == 0) ? predictedIndex : ((n <= predictedIndex) ? n - 1 : n);
+
+            // Ties go to the lowest index, as in the exhaustive search.
+            int bound = (i < bestIndex) ? bestSadValue : bestSadValue - 1;
+            if (trackPeakRatio) {
+                bound = std::max(bound, peakRatioTracker.getBound());
+            }
+
+            int sad = computeBoundedSadOverBlockSimd(
+                leftMinY - bandMinY,
+                leftMinX,
+                leftMinY - bandMinY,
+                rightMinStartX + i,
+                templateWidth,
+                templateHeight,
+                leftBand,
+                rightBand,
+                bound,
+                numBlockRowsSummed);
+
+            localCostBuf[i] = sad;
+
+            if (sad < 0) {
+                continue;
+            }
+
+            if (trackPeakRatio) {
+                peakRatioTracker.add(i, sad);
+            }
+
+            if ((sad < bestSadValue) || ((sad == bestSadValue) && (i < bestIndex))) {
+                bestSadValue = sad;
+                bestIndex = i;
+            }
+        }
+
+        // Cut-short neighbours are summed again, and counted again.
+        for (int i = bestIndex - 1; i <= bestIndex + 1; i += 2) {
+            if ((i >= 0) && (i <= numSteps) && (localCostBuf[i] < 0)) {
+                localCostBuf[i] = computeSadOverBlockSimd(
+                    leftMinY - bandMinY,
+                    leftMinX,
+                    leftMinY - bandMinY,
+                    rightMinStartX + i,
+                    templateWidth,
+                    templateHeight,
+                    leftBand,
+                    rightBand);
+                numBlockRows += templateHeight;
+                numBlockRowsSummed += templateHeight;
+            }
+        }
+    } else {
+        // Enabling parallelization here is faster than no parallelization at all,
+        // but is slower than parallelizing on the center pixel level
+        // #pragma omp parallel for
+        // #pragma omp simd
+        for (int xx = rightMinStartX; xx <= rightMaxStartX; xx++) {
+            int sad = computeSadOverBlockSimd(
+                leftMinY - bandMinY,
+                leftMinX,
+                leftMinY - bandMinY, // Ys are aligned for the two images
+                xx,
+                templateWidth,
+                templateHeight,
+                leftBand, 
+                rightBand);
+
+            localCostBuf[xx - rightMinStartX] = sad;
+
+            if (trackPeakRatio) {
+                peakRatioTracker.add(xx - rightMinStartX, sad);
+            }
+
+            if (sad < bestSadValue) {
+                bestSadValue = sad;
+                bestIndex = xx - rightMinStartX;
+            }
+        }
+
+        numBlockRowsSummed += static_cast<int64_t>(numSteps + 1) * templateHeight;
+    }
+
+    predictedSlot = bestIndex + minSlot;
+
+    bestCost = bestSadValue;
 
-        localDisparityBuf[xx - rightMinStartX] = sad;
+    if (trackPeakRatio) {
+        *confidence = peakRatioTracker.getPeakRatio(bestIndex, bestSadValue);
+    } else if (confidence != nullptr) {
+        if (numSteps == 0) {
+            *confidence = 0.0f;
+        } else {
+            int previous = localCostBuf[(bestIndex > 0) ? bestIndex - 1 : bestIndex + 1];
+            int next = localCostBuf[(bestIndex < numSteps) ? bestIndex + 1 : bestIndex - 1];
+            *confidence = MatchConfidence::computeCurvature(previous, bestSadValue, next, templateWidth * templateHeight);
+        }
+    }
 
-        if (sad < bestSadValue) {
-            bestSadValue = sad;
-            bestIndex = xx - rightMinStartX;
+    if (costs != nullptr) {
+        // Slots beyond the image stay invalid.
+        for (int k = 0; k < numDisparities; k++) {
+            int i = k - minSlot;
+            costs[k] = ((i < 0) || (i > numSteps))
+                ? CostVolume::INVALID_COST
+                : static_cast<uint16_t>(std::min(localCostBuf[i], static_cast<int>(CostVolume::MAX_COST)));
         }
     }
 
-    float disparity = static_cast<float>(std::abs(bestIndex - zeroDisparityIndex));
+    // Zeroed neighbours leave the pixel unrefined.
     if ((bestIndex == 0)
         ||
         (bestIndex == numSteps)
         ||
         (bestSadValue == 0)) {
-        return disparity;
+        previousCost = 0;
+        nextCost = 0;
+    } else {
+        previousCost = localCostBuf[bestIndex-1];
+        nextCost = localCostBuf[bestIndex+1];
     }
 
-    float c3 = localDisparityBuf[bestIndex+1];
-    float c2 = localDisparityBuf[bestIndex];
-    float c1 = localDisparityBuf[bestIndex-1];
+    return static_cast<float>(std::abs(bestIndex - zeroDisparityIndex));
+}
+
+// Loads the 32 bytes of a block row starting at data. Near the end of an image, where they would run
+//   past end, only the bytes before it are read, and the rest are zero, which the block mask drops anyway.
+static inline __m256i loadBlockRow(const uint8_t* data, const uint8_t* end) {
+    if (end - data >= 32) {
+        return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data));
+    }
 
-    return disparity - (0.5 * ((c3 - c1) / (c1 - (2*c2) + c3)));
+    alignas(32) uint8_t tail[32] = { 0 };
+    memcpy(tail, data, end - data);
+    return _mm256_load_si256(reinterpret_cast<__m256i const*>(tail));
 }
 
 int OpenMpThreadedSimdDisparityMapGenerator::computeSadOverBlockSimd(
@@ -142,20 +1105,16 @@ int OpenMpThreadedSimdDisparityMapGenerator::computeSadOverBlockSimd(
     maskReg = _mm256_setzero_si256();
     zeros = _mm256_setzero_si256();
 
-    uint8_t* leftImageData = leftImage.data;
-    uint8_t* rightImageData = rightImage.data;
+    const uint8_t* leftImageEnd = leftImage.ptr<uint8_t>(leftImage.rows - 1) + leftImage.cols;
+    const uint8_t* rightImageEnd = rightImage.ptr<uint8_t>(rightImage.rows - 1) + rightImage.cols;
 
     for (int i = 0; i < width; i++) {
         maskRegBytes[i] = 0xFF;
     }
 
     for (int y = 0; y < height; y++) {
-        int leftLoadIdx = (leftImage.cols * (y+minYL)) + minXL;
-        int rightLoadIdx = (rightImage.cols * (y+minYR)) + minXR;
-        workRegA = _mm256_loadu_si256(
-            reinterpret_cast<__m256i const*>(leftImageData + leftLoadIdx));
-        workRegB = _mm256_loadu_si256(
-            reinterpret_cast<__m256i const*>(rightImageData + rightLoadIdx));
+        workRegA = loadBlockRow(leftImage.ptr<uint8_t>(y + minYL) + minXL, leftImageEnd);
+        workRegB = loadBlockRow(rightImage.ptr<uint8_t>(y + minYR) + minXR, rightImageEnd);
         sadReg = _mm256_sad_epu8(
                 _mm256_blendv_epi8(zeros, workRegA, maskReg),
                 _mm256_blendv_epi8(zeros, workRegB, maskReg)
@@ -173,3 +1132,79 @@ int OpenMpThreadedSimdDisparityMapGenerator::computeSadOverBlockSimd(
 
     return result;
 }
+
+int OpenMpThreadedSimdDisparityMapGenerator::computeBoundedSadOverBlockSimd(
+        int minYL,
+        int minXL,
+        int minYR,
+        int minXR,
+        int width,
+        int height,
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        int bound,
+        int64_t& numRowsSummed) {
+    union { __m256i maskReg; uint8_t maskRegBytes[32]; };
+
+    __m256i zeros = _mm256_setzero_si256();
+    __m256i accumulator = _mm256_setzero_si256();
+    maskReg = _mm256_setzero_si256();
+
+    const uint8_t* leftImageEnd = leftImage.ptr<uint8_t>(leftImage.rows - 1) + leftImage.cols;
+    const uint8_t* rightImageEnd = rightImage.ptr<uint8_t>(rightImage.rows - 1) + rightImage.cols;
+
+    for (int i = 0; i < width; i++) {
+        maskRegBytes[i] = 0xFF;
+    }
+
+    int sum = 0;
+    for (int y = 0; y < height; y++) {
+        __m256i workRegA = loadBlockRow(leftImage.ptr<uint8_t>(y + minYL) + minXL, leftImageEnd);
+        __m256i workRegB = loadBlockRow(rightImage.ptr<uint8_t>(y + minYR) + minXR, rightImageEnd);
+        accumulator = _mm256_add_epi64(
+            accumulator,
+            _mm256_sad_epu8(
+                _mm256_blendv_epi8(zeros, workRegA, maskReg),
+                _mm256_blendv_epi8(zeros, workRegB, maskReg)));
+
+        // The sums of the four lanes fit in their low 32 bits.
+        __m128i lanes = _mm_add_epi64(
+            _mm256_castsi256_si128(accumulator),
+            _mm256_extracti128_si256(accumulator, 1));
+        sum = _mm_cvtsi128_si32(lanes) + _mm_extract_epi32(lanes, 2);
+
+        if (sum > bound) {
+            numRowsSummed += y + 1;
+            return -1;
+        }
+    }
+
+    numRowsSummed += height;
+    return sum;
+}
+
+static DisparityMapBackendInfo_t createBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "OpenMPSimd";
+    info.description = "AVX2 matcher with OpenMP, with rectification, post-processing, incremental recomputation, cost volumes and confidence maps.";
+    info.requiredInstructionSets = { "avx2" };
+    info.maxDisparityRange = OpenMpThreadedSimdDisparityMapGenerator::MAX_DISPARITY_RANGE;
+    info.maxBlockSize = OpenMpThreadedSimdDisparityMapGenerator::MAX_BLOCK_SIZE;
+    info.supportsRectification = true;
+    info.supportsPostProcessing = true;
+    info.supportsSubpixelInterpolation = true;
+    info.supportsIncremental = true;
+    info.supportsSparseQueries = true;
+    info.supportsCostVolume = true;
+    info.supportsConfidence = true;
+    info.nanosecondsPerComparison = 0.1;
+    info.scalesWithOpenMpThreads = true;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<OpenMpThreadedSimdDisparityMapGenerator>(parameters);
+    };
+    return info;
+}
+
+static DisparityMapBackendRegistration registration(createBackendInfo());
@@ -0,0 +1,5 @@
+#include "../include/PipelinedDisparityMapGenerator.hpp"
+
+// Defined here, so that the type information lives in the core library
+//   and dynamic_cast works on generators created by plugins.
+PipelinedDisparityMapGenerator::~PipelinedDisparityMapGenerator() {}
@@ -0,0 +1,94 @@
+#include "../include/PointCloudWriter.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+PointCloudWriter::PointCloudWriter(const std::string& path, PointCloudFormat format)
+        : path_(path), format_(format) {
+    this->stream_.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!this->stream_.is_open()) {
+        throw std::runtime_error("Error: could not open point cloud output '" + path + "'.");
+    }
+
+    if (this->format_ == PointCloudFormat::Ply) {
+        this->stream_
+            << "ply\n"
+            << "format binary_little_endian 1.0\n"
+            << "element vertex ";
+        this->vertexCountPosition_ = this->stream_.tellp();
+        this->stream_
+            << this->formatVertexCount(0) << "\n"
+            << "property float x\n"
+            << "property float y\n"
+            << "property float z\n"
+            << "property float intensity\n"
+            << "end_header\n";
+    }
+}
+
+PointCloudWriter::~PointCloudWriter() {
+    try {
+        this->close();
+    } catch (const std::exception&) {
+        // Destructors must not throw. Call close() to see write errors.
+    }
+}
+
+PointCloudFormat PointCloudWriter::parseFormat(const std::string& name) {
+    std::string lowerName(name);
+    std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+
+    if (lowerName == "ply") {
+        return PointCloudFormat::Ply;
+    } else if (lowerName == "raw") {
+        return PointCloudFormat::Raw;
+    }
+
+    throw std::runtime_error("Error: unrecognized point cloud format '" + name + "'. Valid options are 'ply' and 'raw'.");
+}
+
+void PointCloudWriter::writePoints(const PointXYZI_t* points, size_t numPoints) {
+    if (numPoints == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->stream_.is_open()) {
+        throw std::runtime_error("Error: the point cloud writer is closed.");
+    }
+
+    // PointXYZI_t is four packed floats, which is already the little-endian record layout on x86.
+    this->stream_.write(reinterpret_cast<const char*>(points), numPoints * sizeof(PointXYZI_t));
+    this->numPoints_ += numPoints;
+}
+
+void PointCloudWriter::close() {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (!this->stream_.is_open()) {
+        return;
+    }
+
+    if (this->format_ == PointCloudFormat::Ply) {
+        this->stream_.seekp(this->vertexCountPosition_);
+        this->stream_ << this->formatVertexCount(this->numPoints_);
+    }
+
+    this->stream_.close();
+    if (this->stream_.fail()) {
+        throw std::runtime_error("Error: failed to write point cloud output '" + this->path_ + "'.");
+    }
+}
+
+size_t PointCloudWriter::getNumPoints() const {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->numPoints_;
+}
+
+std::string PointCloudWriter::formatVertexCount(size_t numPoints) const {
+    std::string count = std::to_string(numPoints);
+    if (count.size() > VERTEX_COUNT_DIGITS) {
+        throw std::runtime_error("Error: too many points for the PLY header.");
+    }
+
+    return std::string(VERTEX_COUNT_DIGITS - count.size(), '0') + count;
+}
@@ -0,0 +1,56 @@
+#include "../include/ScanlineRingBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "../include/GrayscaleConverter.hpp"
+
+void ScanlineRingBuffer::configure(int numRows, int cols, int paddingBytes) {
+    if ((numRows <= 0) || (cols <= 0)) {
+        throw std::runtime_error("Error: the scanline ring buffer dimensions must be positive.");
+    }
+
+    this->numRows_ = numRows;
+    this->cols_ = cols;
+    this->numRowsPushed_ = 0;
+    this->data_.assign((2 * static_cast<size_t>(numRows) * cols) + paddingBytes, 0);
+}
+
+void ScanlineRingBuffer::pushRow(const cv::Mat& image, int y) {
+    if (image.cols != this->cols_) {
+        throw std::runtime_error("Error: rows of "
+            + std::to_string(image.cols)
+            + " pixels were pushed to a stream of "
+            + std::to_string(this->cols_)
+            + " columns.");
+    }
+
+    size_t slot = static_cast<size_t>(this->numRowsPushed_ % this->numRows_);
+    uint8_t* row = this->data_.data() + (slot * this->cols_);
+    GrayscaleConverter::convertRows(image, y, y + 1, row);
+    memcpy(row + (static_cast<size_t>(this->numRows_) * this->cols_), row, this->cols_);
+
+    this->numRowsPushed_++;
+}
+
+int ScanlineRingBuffer::getNumRowsPushed() const {
+    return this->numRowsPushed_;
+}
+
+cv::Mat ScanlineRingBuffer::getRows(int minY, int maxY) {
+    if ((minY < std::max(0, this->numRowsPushed_ - this->numRows_))
+        ||
+        (maxY > this->numRowsPushed_)
+        ||
+        (minY > maxY)) {
+        throw std::runtime_error("Error: rows ["
+            + std::to_string(minY)
+            + ", "
+            + std::to_string(maxY)
+            + ") are not in the scanline ring buffer.");
+    }
+
+    size_t slot = static_cast<size_t>(minY % this->numRows_);
+    return cv::Mat(maxY - minY, this->cols_, CV_8UC1, this->data_.data() + (slot * this->cols_));
+}
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "../include/DisparityMapAlgorithmParameters.hpp"
+#include "../include/DisparityMapGenerator.hpp"
+#include "../include/DisparityMapGeneratorFactory.hpp"
+
+// Mean wall-clock time of one frame, in milliseconds.
+double measureFrameTimeMs(
+        DisparityMapGenerator& generator,
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        cv::Mat& disparityImage,
+        int numWarmUpIterations,
+        int numIterations) {
+    for (int i = 0; i < numWarmUpIterations; i++) {
+        generator.computeDisparity(leftImage, rightImage, disparityImage);
+    }
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numIterations; i++) {
+        generator.computeDisparity(leftImage, rightImage, disparityImage);
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() / (1000.0 * numIterations);
+}
+
+int countMismatches(const cv::Mat& expected, const cv::Mat& actual) {
+    int numMismatches = 0;
+    for (int y = 0; y < expected.rows; y++) {
+        for (int x = 0; x < expected.cols; x++) {
+            if (expected.at<float>(y, x) != actual.at<float>(y, x)) {
+                numMismatches++;
+            }
+        }
+    }
+
+    return numMismatches;
+}
+
+int main(int argc, char** argv) {
+
+    const cv::String commandLineKeys = 
+        "{help h usage ?       |                 | This program measures how the Sharded algorithm scales with the number of worker processes.}"
+        "{leftImage            |          <none> | The left image to process.}"
+        "{rightImage           |          <none> | The right image to proces.}"
+        "{workerAlgorithm      |      OpenMPSimd | The algorithm each worker runs.}"
+        "{transports           | sharedMemory,socket | The transports to measure, comma-separated.}"
+        "{maxWorkers           |               4 | The largest number of workers to measure.}"
+        "{workerNumThreads     |               1 | The number of OpenMP threads per worker. 0 keeps the runtime default.}"
+        "{outputPath           | shardScaling.csv | The file to which to write the results.}"
+        "{blockSize            |               7 | The maximum block size to use for matching.}"
+        "{leftScanSteps        |              50 | The number of blocks to scan to the left.}"
+        "{rightScanSteps       |              50 | The number of blocks to scan to the right.}"
+        "{numIterations        |              20 | The number of timed frames per configuration.}"
+        "{warmUpIterations     |               3 | The number of frames to run before timing.}";
+
+    cv::CommandLineParser parser(argc, argv, commandLineKeys);
+
+    if (!parser.check()) {
+        parser.printMessage();
+        parser.printErrors();
+        return 1;
+    }
+
+    if (parser.has("help")
+        || (!parser.has("leftImage"))
+        || (!parser.has("rightImage"))) {
+        parser.printMessage();
+        return 1;
+    }
+
+    DisparityMapAlgorithmParameters_t templateParameters;
+    templateParameters.blockSize = parser.get<int>("blockSize");
+    templateParameters.leftScanSteps = parser.get<int>("leftScanSteps");
+    templateParameters.rightScanSteps = parser.get<int>("rightScanSteps");
+    templateParameters.leftImageFilePath = std::string(parser.get<cv::String>("leftImage"));
+    templateParameters.rightImageFilePath = std::string(parser.get<cv::String>("rightImage"));
+    templateParameters.outputPath = std::string(parser.get<cv::String>("outputPath"));
+    templateParameters.shardWorkerAlgorithm = std::string(parser.get<cv::String>("workerAlgorithm"));
+    templateParameters.shardWorkerNumThreads = parser.get<int>("workerNumThreads");
+    std::string transportsStr = std::string(parser.get<cv::String>("transports"));
+    int maxWorkers = parser.get<int>("maxWorkers");
+    int numIterations = parser.get<int>("numIterations");
+    int numWarmUpIterations = parser.get<int>("warmUpIterations");
+
+    cv::Mat leftImage = cv::imread(templateParameters.leftImageFilePath, cv::IMREAD_GRAYSCALE);
+    cv::Mat rightImage = cv::imread(templateParameters.rightImageFilePath, cv::IMREAD_GRAYSCALE);
+
+    if ((leftImage.rows == 0)
+            ||
+        (leftImage.cols == 0)
+            ||
+        (leftImage.rows != rightImage.rows)
+            ||
+        (leftImage.cols != rightImage.cols)) {
+        throw std::runtime_error("Error. The input images are empty or differ in size.");
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    // The unsharded worker algorithm provides the reference output.
+    DisparityMapGeneratorFactory factory;
+    DisparityMapAlgorithmParameters_t referenceParameters(templateParameters);
+    referenceParameters.algorithmName = templateParameters.shardWorkerAlgorithm;
+    std::unique_ptr<DisparityMapGenerator> referenceGenerator = factory.create(referenceParameters);
+    cv::Mat referenceDisparity(leftImage.rows, leftImage.cols, CV_32FC1);
+    referenceGenerator->computeDisparity(leftImage, rightImage, referenceDisparity);
+
+    std::stringstream stream(transportsStr);
+    std::vector<std::string> transports;
+    while (stream.good()) {
+        std::string transport;
+        std::getline(stream, transport, ',');
+        transports.emplace_back(transport);
+    }
+
+    std::ofstream outputFile(templateParameters.outputPath);
+    outputFile << "transport,numWorkers,frameTimeMs,speedup,efficiency,marginalSpeedup,mismatches" << std::endl;
+
+    cv::Mat disparityImage(leftImage.rows, leftImage.cols, CV_32FC1);
+
+    for (const std::string& transport : transports) {
+        std::cout << "Transport: " << transport << std::endl;
+
+        double singleWorkerTimeMs = 0;
+        double previousTimeMs = 0;
+        for (int numWorkers = 1; numWorkers <= maxWorkers; numWorkers++) {
+            DisparityMapAlgorithmParameters_t parameters(templateParameters);
+            parameters.algorithmName = "Sharded";
+            parameters.shardTransport = transport;
+            parameters.shardNumWorkers = numWorkers;
+
+            std::unique_ptr<DisparityMapGenerator> generator = factory.create(parameters);
+            double frameTimeMs = measureFrameTimeMs(
+                *generator, leftImage, rightImage, disparityImage, numWarmUpIterations, numIterations);
+            int numMismatches = countMismatches(referenceDisparity, disparityImage);
+
+            if (numWorkers == 1) {
+                singleWorkerTimeMs = frameTimeMs;
+                previousTimeMs = frameTimeMs;
+            }
+
+            // Efficiency is the speedup per worker. The marginal speedup is what the last worker added.
+            double speedup = singleWorkerTimeMs / frameTimeMs;
+            double efficiency = speedup / numWorkers;
+            double marginalSpeedup = previousTimeMs / frameTimeMs;
+            previousTimeMs = frameTimeMs;
+
+            std::cout << "\t" << numWorkers << " worker(s): " << frameTimeMs << " ms/frame"
+                << ", speedup " << speedup
+                << ", efficiency " << efficiency * 100.0 << "%"
+                << ", marginal speedup " << marginalSpeedup
+                << ", mismatches " << numMismatches << std::endl;
+
+            outputFile << transport << "," << numWorkers << "," << frameTimeMs << ","
+                << speedup << "," << efficiency << "," << marginalSpeedup << "," << numMismatches << std::endl;
+        }
+    }
+
+    std::cout << "Graceful termination" << std::endl;
+
+    return 0;
+}
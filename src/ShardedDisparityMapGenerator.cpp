@@ -0,0 +1,313 @@
+#include "../include/ShardedDisparityMapGenerator.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
+#include "../include/DisparityServiceProtocol.hpp"
+#include "../include/SharedMemoryShardTransport.hpp"
+#include "../include/SocketShardTransport.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+ShardedDisparityMapGenerator::ShardedDisparityMapGenerator(
+        const DisparityMapAlgorithmParameters_t& parameters)
+        : parameters_(parameters) {
+    this->ensureParametersValid();
+}
+
+ShardedDisparityMapGenerator::~ShardedDisparityMapGenerator() {
+    this->stopWorkers();
+}
+
+void ShardedDisparityMapGenerator::setParameters(
+        const DisparityMapAlgorithmParameters_t& parameters) {
+    bool workersChanged = (parameters.shardNumWorkers != this->parameters_.shardNumWorkers)
+        || (parameters.shardTransport != this->parameters_.shardTransport)
+        || (parameters.shardWorkerNumThreads != this->parameters_.shardWorkerNumThreads)
+        || (parameters.shardWorkerExecutable != this->parameters_.shardWorkerExecutable);
+
+    this->parameters_ = parameters;
+    this->ensureParametersValid();
+
+    // The algorithm parameters travel with every request, only the worker pool needs restarting.
+    if (workersChanged) {
+        this->stopWorkers();
+    }
+}
+
+const DisparityMapAlgorithmParameters_t& ShardedDisparityMapGenerator::getParameters() const {
+    return this->parameters_;
+}
+
+void ShardedDisparityMapGenerator::computeDisparity(
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        cv::Mat& disparity) {
+    if (this->workers_.empty()) {
+        this->startWorkers();
+    }
+
+    int numWorkers = static_cast<int>(this->workers_.size());
+    int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
+    std::vector<int> bandMinY(numWorkers + 1);
+    for (int i = 0; i <= numWorkers; i++) {
+        bandMinY[i] = (leftImage.rows * i) / numWorkers;
+    }
+
+    // All bands are sent before any result is read, so that the workers run concurrently.
+    for (int i = 0; i < numWorkers; i++) {
+        int inputMinY = std::max(0, bandMinY[i] - maxBlockStep);
+        int inputMaxY = std::min(leftImage.rows, bandMinY[i+1] + maxBlockStep);
+
+        ShardRequest_t request;
+        memset(&request, 0, sizeof(request));
+        request.type = static_cast<uint32_t>(ShardRequestType::Compute);
+        request.width = leftImage.cols;
+        request.inputRows = inputMaxY - inputMinY;
+        request.outputRowOffset = bandMinY[i] - inputMinY;
+        request.outputRows = bandMinY[i+1] - bandMinY[i];
+        request.blockSize = this->parameters_.blockSize;
+        request.leftScanSteps = this->parameters_.leftScanSteps;
+        request.rightScanSteps = this->parameters_.rightScanSteps;
+        DisparityServiceProtocol::copyString(
+            this->parameters_.shardWorkerAlgorithm,
+            request.algorithmName,
+            sizeof(request.algorithmName));
+
+        this->workers_[i].transport->sendRequest(
+            request,
+            leftImage.rowRange(inputMinY, inputMaxY),
+            rightImage.rowRange(inputMinY, inputMaxY));
+    }
+
+    // Every result is drained before reporting a failure, so that the transports stay in step.
+    std::string errorMessage;
+    for (int i = 0; i < numWorkers; i++) {
+        ShardResult_t result;
+        cv::Mat disparityRows = disparity.rowRange(bandMinY[i], bandMinY[i+1]);
+        this->workers_[i].transport->receiveResult(result, disparityRows);
+
+        this->workerComputeTimesMs_[i] = result.computeTimeMs;
+        if ((result.status != 0) && (errorMessage.empty())) {
+            result.errorMessage[sizeof(result.errorMessage) - 1] = '\0';
+            errorMessage = "Shard worker " + std::to_string(i) + ": " + std::string(result.errorMessage);
+        }
+    }
+
+    if (!errorMessage.empty()) {
+        throw std::runtime_error(errorMessage);
+    }
+}
+
+const std::vector<double>& ShardedDisparityMapGenerator::getWorkerComputeTimesMs() const {
+    return this->workerComputeTimesMs_;
+}
+
+void ShardedDisparityMapGenerator::ensureParametersValid() {
+    if (this->parameters_.blockSize < 0) {
+        throw std::runtime_error("Error: block size is less than zero.");
+    }
+
+    if (this->parameters_.blockSize % 2 == 0) {
+        throw std::runtime_error("Error: block size is not odd.");
+    }
+
+    if (this->parameters_.shardNumWorkers < 1) {
+        throw std::runtime_error("Error: at least one shard worker is required.");
+    }
+
+    if ((this->parameters_.shardTransport != "sharedMemory")
+        &&
+        (this->parameters_.shardTransport != "socket")) {
+        throw std::runtime_error("Error: unrecognized shard transport '" + this->parameters_.shardTransport + "'. Valid options are 'sharedMemory' and 'socket'.");
+    }
+
+    std::string workerAlgorithm(this->parameters_.shardWorkerAlgorithm);
+    for (char& c : workerAlgorithm) {
+        c = static_cast<char>(toupper(c));
+    }
+
+    if (workerAlgorithm == "SHARDED") {
+        throw std::runtime_error("Error: shard workers cannot themselves be sharded.");
+    }
+
+    if (this->parameters_.shardWorkerAlgorithm.size() >= sizeof(ShardRequest_t::algorithmName)) {
+        throw std::runtime_error("Error: the shard worker algorithm name is too long.");
+    }
+}
+
+void ShardedDisparityMapGenerator::startWorkers() {
+    std::string numThreads = std::to_string(this->parameters_.shardWorkerNumThreads);
+
+    if (this->parameters_.shardTransport == "sharedMemory") {
+        for (int i = 0; i < this->parameters_.shardNumWorkers; i++) {
+            int sockets[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+                throw std::runtime_error("Error: could not create a socket pair: " + std::string(strerror(errno)) + ".");
+            }
+
+            // Only the worker's end is inherited. It is closed here right after spawning,
+            //   so that later workers do not hold it open.
+            fcntl(sockets[1], F_SETFD, 0);
+
+            ShardWorker_t worker;
+            try {
+                worker.pid = this->spawnWorker({
+                    "--transport=sharedMemory",
+                    "--fd=" + std::to_string(sockets[1]),
+                    "--numThreads=" + numThreads});
+            } catch (const std::exception&) {
+                close(sockets[0]);
+                close(sockets[1]);
+                throw;
+            }
+
+            close(sockets[1]);
+            worker.transport = std::make_unique<SharedMemoryShardTransport>(sockets[0]);
+            this->workers_.emplace_back(std::move(worker));
+        }
+    } else {
+        // Workers connect back to an ephemeral loopback port.
+        int listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        socklen_t addressLength = sizeof(address);
+
+        if ((listenFd < 0)
+            || (bind(listenFd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+            || (listen(listenFd, this->parameters_.shardNumWorkers) != 0)
+            || (getsockname(listenFd, reinterpret_cast<struct sockaddr*>(&address), &addressLength) != 0)) {
+            int error = errno;
+            if (listenFd >= 0) {
+                close(listenFd);
+            }
+            throw std::runtime_error("Error: could not listen for shard workers: " + std::string(strerror(error)) + ".");
+        }
+
+        std::string connectAddress = "127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+        try {
+            for (int i = 0; i < this->parameters_.shardNumWorkers; i++) {
+                ShardWorker_t worker;
+                worker.pid = this->spawnWorker({
+                    "--transport=socket",
+                    "--connect=" + connectAddress,
+                    "--numThreads=" + numThreads});
+
+                struct pollfd listenPoll;
+                listenPoll.fd = listenFd;
+                listenPoll.events = POLLIN;
+                if (poll(&listenPoll, 1, 10000) <= 0) {
+                    kill(worker.pid, SIGKILL);
+                    waitpid(worker.pid, nullptr, 0);
+                    throw std::runtime_error("Error: shard worker " + std::to_string(i) + " did not connect.");
+                }
+
+                // Workers connect in order, as each one is waited for before spawning the next.
+                int workerFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+                if (workerFd < 0) {
+                    kill(worker.pid, SIGKILL);
+                    waitpid(worker.pid, nullptr, 0);
+                    throw std::runtime_error("Error: could not accept shard worker " + std::to_string(i) + ".");
+                }
+
+                worker.transport = std::make_unique<SocketShardTransport>(workerFd);
+                this->workers_.emplace_back(std::move(worker));
+            }
+        } catch (const std::exception&) {
+            close(listenFd);
+            this->stopWorkers();
+            throw;
+        }
+
+        close(listenFd);
+    }
+
+    this->workerComputeTimesMs_.assign(this->workers_.size(), 0);
+}
+
+void ShardedDisparityMapGenerator::stopWorkers() {
+    for (ShardWorker_t& worker : this->workers_) {
+        ShardRequest_t request;
+        memset(&request, 0, sizeof(request));
+        request.type = static_cast<uint32_t>(ShardRequestType::Shutdown);
+
+        // A worker that already died has nothing left to shut down.
+        try {
+            worker.transport->sendRequest(request, cv::Mat(), cv::Mat());
+        } catch (const std::exception&) {
+        }
+
+        worker.transport.reset();
+        waitpid(worker.pid, nullptr, 0);
+    }
+
+    this->workers_.clear();
+}
+
+pid_t ShardedDisparityMapGenerator::spawnWorker(const std::vector<std::string>& arguments) {
+    std::string executablePath = this->getWorkerExecutablePath();
+
+    std::vector<char*> argv;
+    argv.emplace_back(const_cast<char*>(executablePath.c_str()));
+    for (const std::string& argument : arguments) {
+        argv.emplace_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.emplace_back(nullptr);
+
+    pid_t pid;
+    int ret = posix_spawn(&pid, executablePath.c_str(), nullptr, nullptr, argv.data(), environ);
+    if (ret != 0) {
+        throw std::runtime_error("Error: could not start shard worker '" + executablePath + "': " + std::string(strerror(ret)) + ".");
+    }
+
+    return pid;
+}
+
+std::string ShardedDisparityMapGenerator::getWorkerExecutablePath() const {
+    if (!this->parameters_.shardWorkerExecutable.empty()) {
+        return this->parameters_.shardWorkerExecutable;
+    }
+
+    // By default, the worker is installed next to the running executable.
+    char selfPath[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", selfPath, sizeof(selfPath) - 1);
+    if (length <= 0) {
+        return "DisparityShardWorker";
+    }
+    selfPath[length] = '\0';
+
+    std::string directory(selfPath);
+    return directory.substr(0, directory.rfind('/') + 1) + "DisparityShardWorker";
+}
+
+static DisparityMapBackendInfo_t createBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "Sharded";
+    info.description = "Splits rows across DisparityShardWorker processes.";
+    // Limited by the default worker algorithm, OpenMPSimd.
+    info.maxDisparityRange = 512;
+    info.maxBlockSize = 31;
+    info.fixedCostMs = 3.0;
+    info.nanosecondsPerComparison = 0.1;
+    info.scalesWithOpenMpThreads = true;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<ShardedDisparityMapGenerator>(parameters);
+    };
+    return info;
+}
+
+static DisparityMapBackendRegistration registration(createBackendInfo());
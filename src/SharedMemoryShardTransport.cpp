@@ -0,0 +1,152 @@
+#include "../include/SharedMemoryShardTransport.hpp"
+#include "../include/DisparityServiceProtocol.hpp"
+#include "../include/GrayscaleConverter.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SharedMemoryShardTransport::SharedMemoryShardTransport(int socketFd)
+        : socketFd_(socketFd) {}
+
+SharedMemoryShardTransport::~SharedMemoryShardTransport() {
+    this->unmapRegion();
+    close(this->socketFd_);
+}
+
+void SharedMemoryShardTransport::sendRequest(
+        const ShardRequest_t& request,
+        const cv::Mat& leftRows,
+        const cv::Mat& rightRows) {
+    int regionFd = -1;
+    ShardRequest_t header(request);
+
+    if (request.type == static_cast<uint32_t>(ShardRequestType::Compute)) {
+        RegionLayout_t layout = computeLayout(request.width, request.inputRows);
+        regionFd = this->ensureRegionSize(layout.size);
+        this->layout_ = layout;
+        header.sharedMemorySize = this->regionSize_;
+
+        // Color rows are converted straight into the shared region.
+        GrayscaleConverter::convertRows(leftRows, 0, request.inputRows, this->region_ + layout.leftOffset);
+        GrayscaleConverter::convertRows(rightRows, 0, request.inputRows, this->region_ + layout.rightOffset);
+    }
+
+    DisparityServiceProtocol::sendBytes(this->socketFd_, &header, sizeof(header), regionFd);
+
+    if (regionFd >= 0) {
+        close(regionFd);
+    }
+}
+
+void SharedMemoryShardTransport::receiveResult(
+        ShardResult_t& result,
+        cv::Mat& disparityRows) {
+    if (!DisparityServiceProtocol::receiveBytes(this->socketFd_, &result, sizeof(result))) {
+        throw std::runtime_error("Error: the shard worker closed the connection.");
+    }
+
+    if (result.status == 0) {
+        cv::Mat disparityView(result.outputRows, result.width, CV_32FC1, this->region_ + this->layout_.disparityOffset);
+        disparityView.copyTo(disparityRows);
+    }
+}
+
+bool SharedMemoryShardTransport::receiveRequest(
+        ShardRequest_t& request,
+        cv::Mat& leftRows,
+        cv::Mat& rightRows) {
+    int regionFd = -1;
+    if (!DisparityServiceProtocol::receiveBytes(this->socketFd_, &request, sizeof(request), &regionFd)) {
+        return false;
+    }
+
+    if (regionFd >= 0) {
+        this->unmapRegion();
+        this->mapRegion(regionFd, request.sharedMemorySize);
+        close(regionFd);
+    }
+
+    if (request.type == static_cast<uint32_t>(ShardRequestType::Compute)) {
+        this->layout_ = computeLayout(request.width, request.inputRows);
+        if ((this->region_ == nullptr) || (this->layout_.size > this->regionSize_)) {
+            throw std::runtime_error("Error: the shard request does not fit the shared memory region.");
+        }
+
+        leftRows = cv::Mat(request.inputRows, request.width, CV_8UC1, this->region_ + this->layout_.leftOffset);
+        rightRows = cv::Mat(request.inputRows, request.width, CV_8UC1, this->region_ + this->layout_.rightOffset);
+    }
+
+    return true;
+}
+
+void SharedMemoryShardTransport::sendResult(
+        const ShardResult_t& result,
+        const cv::Mat& disparityRows) {
+    if (result.status == 0) {
+        cv::Mat disparityView(result.outputRows, result.width, CV_32FC1, this->region_ + this->layout_.disparityOffset);
+        disparityRows.copyTo(disparityView);
+    }
+
+    DisparityServiceProtocol::sendBytes(this->socketFd_, &result, sizeof(result));
+}
+
+SharedMemoryShardTransport::RegionLayout_t SharedMemoryShardTransport::computeLayout(int width, int inputRows) {
+    // The disparity is never larger than the input band, so it can share the same row count.
+    DisparityServiceSlotLayout_t slotLayout = DisparityServiceProtocol::computeSlotLayout(width, inputRows);
+
+    RegionLayout_t layout;
+    layout.leftOffset = slotLayout.leftImageOffset;
+    layout.rightOffset = slotLayout.rightImageOffset;
+    layout.disparityOffset = slotLayout.disparityOffset;
+    layout.size = slotLayout.slotSize;
+    return layout;
+}
+
+int SharedMemoryShardTransport::ensureRegionSize(size_t size) {
+    if ((this->region_ != nullptr) && (size <= this->regionSize_)) {
+        return -1;
+    }
+
+    // The name is unlinked right away, the worker attaches through the passed descriptor.
+    static std::atomic<int> nextRegionId(0);
+    std::string name = "/StereoVisionMultiWay-shard-" + std::to_string(getpid()) + "-" + std::to_string(nextRegionId++);
+
+    int regionFd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (regionFd < 0) {
+        throw std::runtime_error("Error: could not create shared memory: " + std::string(strerror(errno)) + ".");
+    }
+    shm_unlink(name.c_str());
+
+    if (ftruncate(regionFd, size) != 0) {
+        int error = errno;
+        close(regionFd);
+        throw std::runtime_error("Error: could not size shared memory: " + std::string(strerror(error)) + ".");
+    }
+
+    this->unmapRegion();
+    this->mapRegion(regionFd, size);
+    return regionFd;
+}
+
+void SharedMemoryShardTransport::mapRegion(int regionFd, size_t size) {
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, regionFd, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Error: could not map shared memory: " + std::string(strerror(errno)) + ".");
+    }
+
+    this->region_ = static_cast<uint8_t*>(mapping);
+    this->regionSize_ = size;
+}
+
+void SharedMemoryShardTransport::unmapRegion() {
+    if (this->region_ != nullptr) {
+        munmap(this->region_, this->regionSize_);
+        this->region_ = nullptr;
+        this->regionSize_ = 0;
+    }
+}
@@ -1,4 +1,5 @@
 #include "../include/SingleThreadedDisparityMapGenerator.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
 
 SingleThreadedDisparityMapGenerator::SingleThreadedDisparityMapGenerator(
         const DisparityMapAlgorithmParameters_t& parameters)
@@ -22,13 +23,43 @@ void SingleThreadedDisparityMapGenerator::computeDisparity(
         const cv::Mat& leftImage,
         const cv::Mat& rightImage,
         cv::Mat& disparity) {
+    const cv::Mat& leftGray = GrayscaleConverter::ensureGray(leftImage, this->leftGrayImage_);
+    const cv::Mat& rightGray = GrayscaleConverter::ensureGray(rightImage, this->rightGrayImage_);
+
     for (int y = 0; y < disparity.rows; y++) {
         for (int x = 0; x < disparity.cols; x++) {
             disparity.at<float>(y, x) = computeDisparityForPixel(
                 y,
                 x,
-                leftImage,
-                rightImage);
+                leftGray,
+                rightGray);
+        }
+    }
+}
+
+bool SingleThreadedDisparityMapGenerator::beginSparseQuery() {
+    return false;
+}
+
+void SingleThreadedDisparityMapGenerator::computeDisparitySpan(
+        const cv::Mat& leftGray,
+        const cv::Mat& rightGray,
+        int y,
+        int minX,
+        int maxX,
+        float* disparities,
+        int* costs) {
+    for (int x = minX; x < maxX; x++) {
+        int cost;
+        disparities[x - minX] = computeDisparityForPixel(
+            y,
+            x,
+            leftGray,
+            rightGray,
+            &cost);
+
+        if (costs != nullptr) {
+            costs[x - minX] = cost;
         }
     }
 }
@@ -55,7 +86,8 @@ float SingleThreadedDisparityMapGenerator::computeDisparityForPixel(
         int y, 
         int x,
         const cv::Mat& leftImage,
-        const cv::Mat& rightImage) {
+        const cv::Mat& rightImage,
+        int* bestCost) {
 
     int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
 
@@ -98,6 +130,10 @@ float SingleThreadedDisparityMapGenerator::computeDisparityForPixel(
         }
     }
 
+    if (bestCost != nullptr) {
+        *bestCost = bestSadValue;
+    }
+
     float disparity = static_cast<float>(std::abs(bestIndex - zeroDisparityIndex));
     if ((bestIndex == 0)
         ||
@@ -135,3 +171,19 @@ int SingleThreadedDisparityMapGenerator::computeSadOverBlock(
 
     return sum;
 }
+
+static DisparityMapBackendInfo_t createBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "SingleThreaded";
+    info.description = "Scalar reference matcher on one thread.";
+    info.supportsSparseQueries = true;
+    info.nanosecondsPerComparison = 1.0;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<SingleThreadedDisparityMapGenerator>(parameters);
+    };
+    return info;
+}
+
+static DisparityMapBackendRegistration registration(createBackendInfo());
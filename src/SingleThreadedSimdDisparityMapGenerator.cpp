@@ -1,5 +1,7 @@
 #include "../include/SingleThreadedSimdDisparityMapGenerator.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
 
+#include <cstring>
 #include <iostream>
 
 SingleThreadedSimdDisparityMapGenerator::SingleThreadedSimdDisparityMapGenerator(
@@ -24,13 +26,43 @@ void SingleThreadedSimdDisparityMapGenerator::computeDisparity(
         const cv::Mat& leftImage,
         const cv::Mat& rightImage,
         cv::Mat& disparity) {
+    const cv::Mat& leftGray = GrayscaleConverter::ensureGray(leftImage, this->leftGrayImage_);
+    const cv::Mat& rightGray = GrayscaleConverter::ensureGray(rightImage, this->rightGrayImage_);
+
     for (int y = 0; y < disparity.rows; y++) {
         for (int x = 0; x < disparity.cols; x++) {
             disparity.at<float>(y, x) = computeDisparityForPixel(
                 y,
                 x,
-                leftImage,
-                rightImage);
+                leftGray,
+                rightGray);
+        }
+    }
+}
+
+bool SingleThreadedSimdDisparityMapGenerator::beginSparseQuery() {
+    return false;
+}
+
+void SingleThreadedSimdDisparityMapGenerator::computeDisparitySpan(
+        const cv::Mat& leftGray,
+        const cv::Mat& rightGray,
+        int y,
+        int minX,
+        int maxX,
+        float* disparities,
+        int* costs) {
+    for (int x = minX; x < maxX; x++) {
+        int cost;
+        disparities[x - minX] = computeDisparityForPixel(
+            y,
+            x,
+            leftGray,
+            rightGray,
+            &cost);
+
+        if (costs != nullptr) {
+            costs[x - minX] = cost;
         }
     }
 }
@@ -51,13 +83,18 @@ void SingleThreadedSimdDisparityMapGenerator::ensureParametersValid() {
     if (this->parameters_.rightScanSteps < 0) {
         throw std::runtime_error("Error: right scan steps is negative.");
     }
+
+    if (this->parameters_.blockSize > MAX_BLOCK_SIZE) {
+        throw std::runtime_error("Error: a block size of " + std::to_string(this->parameters_.blockSize) + " is larger than the supported " + std::to_string(MAX_BLOCK_SIZE) + ".");
+    }
 }
 
 float SingleThreadedSimdDisparityMapGenerator::computeDisparityForPixel(
         int y, 
         int x,
         const cv::Mat& leftImage,
-        const cv::Mat& rightImage) {
+        const cv::Mat& rightImage,
+        int* bestCost) {
 
     int maxBlockStep = (this->parameters_.blockSize - 1) / 2;
 
@@ -100,6 +137,10 @@ float SingleThreadedSimdDisparityMapGenerator::computeDisparityForPixel(
         }
     }
 
+    if (bestCost != nullptr) {
+        *bestCost = bestSadValue;
+    }
+
     float disparity = static_cast<float>(std::abs(bestIndex - zeroDisparityIndex));
     if ((bestIndex == 0)
         ||
@@ -116,6 +157,18 @@ float SingleThreadedSimdDisparityMapGenerator::computeDisparityForPixel(
     return disparity - (0.5 * ((c3 - c1) / (c1 - (2*c2) + c3)));
 }
 
+// Loads the 32 bytes of a block row starting at data. Near the end of an image, where they would run
+//   past end, only the bytes before it are read, and the rest are zero, which the block mask drops anyway.
+static inline __m256i loadBlockRow(const uint8_t* data, const uint8_t* end) {
+    if (end - data >= 32) {
+        return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data));
+    }
+
+    alignas(32) uint8_t tail[32] = { 0 };
+    memcpy(tail, data, end - data);
+    return _mm256_load_si256(reinterpret_cast<__m256i const*>(tail));
+}
+
 int SingleThreadedSimdDisparityMapGenerator::computeSadOverBlockSimd(
         int minYL,
         int minXL,
@@ -138,20 +191,16 @@ int SingleThreadedSimdDisparityMapGenerator::computeSadOverBlockSimd(
     maskReg = _mm256_setzero_si256();
     zeros = _mm256_setzero_si256();
 
-    uint8_t* leftImageData = leftImage.data;
-    uint8_t* rightImageData = rightImage.data;
+    const uint8_t* leftImageEnd = leftImage.ptr<uint8_t>(leftImage.rows - 1) + leftImage.cols;
+    const uint8_t* rightImageEnd = rightImage.ptr<uint8_t>(rightImage.rows - 1) + rightImage.cols;
 
     for (int i = 0; i < width; i++) {
         maskRegBytes[i] = 0xFF;
     }
 
     for (int y = 0; y < height; y++) {
-        int leftLoadIdx = (leftImage.cols * (y+minYL)) + minXL;
-        int rightLoadIdx = (rightImage.cols * (y+minYR)) + minXR;
-        workRegA = _mm256_loadu_si256(
-            reinterpret_cast<__m256i const*>(leftImageData + leftLoadIdx));
-        workRegB = _mm256_loadu_si256(
-            reinterpret_cast<__m256i const*>(rightImageData + rightLoadIdx));
+        workRegA = loadBlockRow(leftImage.ptr<uint8_t>(y + minYL) + minXL, leftImageEnd);
+        workRegB = loadBlockRow(rightImage.ptr<uint8_t>(y + minYR) + minXR, rightImageEnd);
         sadReg = _mm256_sad_epu8(
                 _mm256_blendv_epi8(zeros, workRegA, maskReg),
                 _mm256_blendv_epi8(zeros, workRegB, maskReg)
@@ -169,3 +218,21 @@ int SingleThreadedSimdDisparityMapGenerator::computeSadOverBlockSimd(
 
     return result;
 }
+
+static DisparityMapBackendInfo_t createBackendInfo() {
+    DisparityMapBackendInfo_t info;
+    info.name = "SingleThreadedSimd";
+    info.description = "AVX2 matcher on one thread.";
+    info.requiredInstructionSets = { "avx2" };
+    info.maxBlockSize = SingleThreadedSimdDisparityMapGenerator::MAX_BLOCK_SIZE;
+    info.supportsSparseQueries = true;
+    info.nanosecondsPerComparison = 0.1;
+    info.inputTypes = { CV_8UC1, CV_8UC3 };
+    info.outputTypes = { CV_32FC1 };
+    info.create = [](const DisparityMapAlgorithmParameters_t& parameters) {
+        return std::make_unique<SingleThreadedSimdDisparityMapGenerator>(parameters);
+    };
+    return info;
+}
+
+static DisparityMapBackendRegistration registration(createBackendInfo());
@@ -0,0 +1,141 @@
+#include "../include/SocketShardTransport.hpp"
+#include "../include/DisparityServiceProtocol.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+SocketShardTransport::SocketShardTransport(int socketFd)
+        : socketFd_(socketFd) {
+    // Headers are tiny and always followed by a reply, so Nagle would only add latency.
+    int enable = 1;
+    setsockopt(this->socketFd_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+}
+
+SocketShardTransport::~SocketShardTransport() {
+    close(this->socketFd_);
+}
+
+void SocketShardTransport::sendRequest(
+        const ShardRequest_t& request,
+        const cv::Mat& leftRows,
+        const cv::Mat& rightRows) {
+    DisparityServiceProtocol::sendBytes(this->socketFd_, &request, sizeof(request));
+
+    if (request.type == static_cast<uint32_t>(ShardRequestType::Compute)) {
+        this->sendRows(leftRows);
+        this->sendRows(rightRows);
+    }
+}
+
+void SocketShardTransport::receiveResult(
+        ShardResult_t& result,
+        cv::Mat& disparityRows) {
+    if (!DisparityServiceProtocol::receiveBytes(this->socketFd_, &result, sizeof(result))) {
+        throw std::runtime_error("Error: the shard worker closed the connection.");
+    }
+
+    if (result.status == 0) {
+        this->receiveRows(disparityRows);
+    }
+}
+
+bool SocketShardTransport::receiveRequest(
+        ShardRequest_t& request,
+        cv::Mat& leftRows,
+        cv::Mat& rightRows) {
+    if (!DisparityServiceProtocol::receiveBytes(this->socketFd_, &request, sizeof(request))) {
+        return false;
+    }
+
+    if (request.type == static_cast<uint32_t>(ShardRequestType::Compute)) {
+        leftRows.create(request.inputRows, request.width, CV_8UC1);
+        rightRows.create(request.inputRows, request.width, CV_8UC1);
+        this->receiveRows(leftRows);
+        this->receiveRows(rightRows);
+    }
+
+    return true;
+}
+
+void SocketShardTransport::sendResult(
+        const ShardResult_t& result,
+        const cv::Mat& disparityRows) {
+    DisparityServiceProtocol::sendBytes(this->socketFd_, &result, sizeof(result));
+
+    if (result.status == 0) {
+        this->sendRows(disparityRows);
+    }
+}
+
+int SocketShardTransport::connectTo(const std::string& address) {
+    size_t separator = address.rfind(':');
+    if (separator == std::string::npos) {
+        throw std::runtime_error("Error: expected host:port, got '" + address + "'.");
+    }
+
+    std::string host = address.substr(0, separator);
+    std::string port = address.substr(separator + 1);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* addresses = nullptr;
+    int ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+    if (ret != 0) {
+        throw std::runtime_error("Error: could not resolve '" + address + "': " + std::string(gai_strerror(ret)) + ".");
+    }
+
+    int socketFd = -1;
+    for (struct addrinfo* it = addresses; it != nullptr; it = it->ai_next) {
+        socketFd = socket(it->ai_family, it->ai_socktype | SOCK_CLOEXEC, it->ai_protocol);
+        if (socketFd < 0) {
+            continue;
+        }
+
+        if (connect(socketFd, it->ai_addr, it->ai_addrlen) == 0) {
+            break;
+        }
+
+        close(socketFd);
+        socketFd = -1;
+    }
+
+    freeaddrinfo(addresses);
+
+    if (socketFd < 0) {
+        throw std::runtime_error("Error: could not connect to '" + address + "'.");
+    }
+
+    return socketFd;
+}
+
+void SocketShardTransport::sendRows(const cv::Mat& rows) {
+    if (rows.type() != CV_8UC1) {
+        this->sendRows(GrayscaleConverter::ensureGray(rows, this->grayRows_));
+        return;
+    }
+
+    if (rows.isContinuous()) {
+        DisparityServiceProtocol::sendBytes(this->socketFd_, rows.data, rows.total() * rows.elemSize());
+        return;
+    }
+
+    for (int y = 0; y < rows.rows; y++) {
+        DisparityServiceProtocol::sendBytes(this->socketFd_, rows.ptr(y), rows.cols * rows.elemSize());
+    }
+}
+
+void SocketShardTransport::receiveRows(cv::Mat& rows) {
+    for (int y = 0; y < rows.rows; y++) {
+        if (!DisparityServiceProtocol::receiveBytes(this->socketFd_, rows.ptr(y), rows.cols * rows.elemSize())) {
+            throw std::runtime_error("Error: the shard connection closed mid-band.");
+        }
+    }
+}
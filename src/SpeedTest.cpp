@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <chrono>
+#include <dirent.h>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -16,24 +17,99 @@
 #include <opencv2/core/utility.hpp>
 #include <opencv2/imgcodecs.hpp>
 
+#include "../include/DisparityAccuracyEvaluator.hpp"
 #include "../include/DisparityMapAlgorithmParameters.hpp"
 #include "../include/DisparityMapGenerator.hpp"
 #include "../include/DisparityMapGeneratorFactory.hpp"
+#include "../include/OpenMpThreadedSimdDisparityMapGenerator.hpp"
+#include "../include/PipelinedDisparityMapGenerator.hpp"
+
+// Times the creation of a generator along with its first frame,
+//   which is when the lazily-initialized backends set themselves up.
+double measureInitializationTimeMs(
+        const DisparityMapAlgorithmParameters_t& parameters,
+        const cv::Mat& leftImage,
+        const cv::Mat& rightImage,
+        cv::Mat& disparityImage) {
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    DisparityMapGeneratorFactory factory;
+    std::unique_ptr<DisparityMapGenerator> generator = factory.create(parameters);
+    generator->computeDisparity(leftImage, rightImage, disparityImage);
+
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end-start).count() / 1000.0;
+}
+
+double computeFramesPerSecond(const std::vector<double>& wallClockTimesUs) {
+    double totalUs = 0;
+    for (double timeUs : wallClockTimesUs) {
+        totalUs += timeUs;
+    }
+
+    return (totalUs > 0) ? (1000000.0 * wallClockTimesUs.size() / totalUs) : 0;
+}
+
+void printRegionAccuracy(
+        const std::string& regionName,
+        const std::vector<float>& thresholds,
+        const DisparityRegionAccuracy_t& accuracy) {
+    std::cout << "\t\t" << regionName << " (" << accuracy.numPixels << " pixels):";
+    for (size_t i = 0; i < thresholds.size(); i++) {
+        std::cout << " bad" << thresholds[i] << " " << accuracy.badPixelPercentages[i] << "%";
+    }
+    std::cout << ", MAE " << accuracy.meanAbsoluteError << ", RMSE " << accuracy.rootMeanSquaredError << std::endl;
+}
+
+void removeDirectory(const std::string& path) {
+    DIR* dir = opendir(path.c_str());
+    if (dir != nullptr) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string name(entry->d_name);
+            if ((name != ".") && (name != "..")) {
+                remove((path + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+
+    rmdir(path.c_str());
+}
 
 int main(int argc, char** argv) {
 
     const cv::String commandLineKeys = 
-        "{help h usage ?         |          | This program runs a speed test on selected algorithms.}"
-        "{leftImage              |   <none> | The left image to process.}"
-        "{rightImage             |   <none> | The right image to proces.}"
-        "{algorithmNames         |   <none> | The algorithms to benchmark, comma-separated.}"
-        "{outputPath             | data.csv | The output directory to which to write the results.}"
-        "{blockSize              |        7 | The maximum block size to use for matching.}"
-        "{leftScanSteps          |       50 | The number of blocks to scan to the left.}"
-        "{rightScanSteps         |       50 | The number of blocks to scan to the right.}"
-        "{numIterations          |     1000 | The number of production iterations to run.}"
-        "{warmUpIterations       |       50 | The number of iterations to perform before saving data. Used to warm up caches}"
-        "{progressReportInterval |       20 | The number of iterations to perform before saving data. Used to warm up caches}";
+        "{help h usage ?         |              | This program runs a speed test on selected algorithms.}"
+        "{leftImage              |       <none> | The left image to process.}"
+        "{rightImage             |       <none> | The right image to proces.}"
+        "{algorithmNames         |       <none> | The algorithms to benchmark, comma-separated.}"
+        "{outputPath             |     data.csv | The output directory to which to write the results.}"
+        "{blockSize              |            7 | The maximum block size to use for matching.}"
+        "{leftScanSteps          |           50 | The number of blocks to scan to the left.}"
+        "{rightScanSteps         |           50 | The number of blocks to scan to the right.}"
+        "{numIterations          |         1000 | The number of production iterations to run.}"
+        "{warmUpIterations       |           50 | The number of iterations to perform before saving data. Used to warm up caches}"
+        "{progressReportInterval |           20 | The number of iterations to perform before saving data. Used to warm up caches}"
+        "{pipelineDepth          |            1 | For OpenCL, the number of frames kept in flight. Above 1, measures pipelined throughput.}"
+        "{measureInitialization  |        false | Report cold-start (empty kernel cache) and warm-start initialization times.}"
+        "{openClPlatform         |              | For OpenCL, only use platforms whose name contains this string.}"
+        "{openClDevice           |              | For OpenCL, only use devices whose name contains this string.}"
+        "{openClDeviceType       |      default | For OpenCL, the device type to use: default, cpu, gpu, accelerator or all.}"
+        "{openClMaxDevices       |            1 | For OpenCL, the maximum number of devices to split each frame across. 0 uses all matching devices.}"
+        "{openClDeviceFission    |              | For OpenCL, partition each device into sub-devices: numa or equally:<computeUnits>.}"
+        "{rectificationMaps      |              | Fixed-point remap tables (leftMap1, leftMap2, rightMap1, rightMap2) to rectify the raw input with. OpenMPSimd only.}"
+        "{colorInput             |        false | Feed the generators 3-channel BGR images, which they convert to gray themselves.}"
+        "{subpixelInterpolation  |    parabolic | Subpixel fit: parabolic, equiangular or none. Only OpenMPSimd supports other than parabolic.}"
+        "{medianFilterSize       |            0 | Median filter the disparity: 0 (off), 3 or 5. OpenMPSimd only.}"
+        "{speckleMaxSize         |            0 | Remove similar regions of at most this many pixels. 0 disables it. OpenMPSimd only.}"
+        "{speckleMaxDifference   |            1 | The largest disparity step within a speckle region.}"
+        "{earlyTermination       |        false | Stop summing a candidate's block once it cannot win. OpenMPSimd only.}"
+        "{groundTruth            |              | Ground truth disparity of the left image, such as data/conesH/disp2.pgm. Enables accuracy reporting.}"
+        "{groundTruthRight       |              | Ground truth disparity of the right image, such as data/conesH/disp6.pgm. Used to find the non-occluded pixels.}"
+        "{groundTruthScale       |            1 | The ground truth holds the disparity multiplied by this. Use 2 for data/conesH.}"
+        "{accuracyThresholds     |    0.5,1,2,4 | The bad pixel thresholds in pixels, comma-separated.}"
+        "{accuracyOutputPath     | accuracy.csv | The file to which to write the accuracy and throughput of each algorithm.}";
 
     cv::CommandLineParser parser(argc, argv, commandLineKeys);
 
@@ -58,6 +134,11 @@ int main(int argc, char** argv) {
     templateParameters.blockSize = parser.get<int>("blockSize");
     templateParameters.leftScanSteps = parser.get<int>("leftScanSteps");
     templateParameters.rightScanSteps = parser.get<int>("rightScanSteps");
+    templateParameters.subpixelInterpolation = std::string(parser.get<cv::String>("subpixelInterpolation"));
+    templateParameters.medianFilterSize = parser.get<int>("medianFilterSize");
+    templateParameters.speckleMaxSize = parser.get<int>("speckleMaxSize");
+    templateParameters.speckleMaxDifference = parser.get<float>("speckleMaxDifference");
+    templateParameters.earlyTerminationEnabled = parser.get<bool>("earlyTermination");
     templateParameters.leftImageFilePath = std::string(parser.get<cv::String>("leftImage"));
     templateParameters.rightImageFilePath = std::string(parser.get<cv::String>("rightImage"));
     templateParameters.outputPath = std::string(parser.get<cv::String>("outputPath"));
@@ -65,6 +146,21 @@ int main(int argc, char** argv) {
     int numIterations = parser.get<int>("numIterations");
     int numWarmUpIterations = parser.get<int>("warmUpIterations");
     int progressReportInterval = parser.get<int>("progressReportInterval");
+    int pipelineDepth = parser.get<int>("pipelineDepth");
+    bool measureInitialization = parser.get<bool>("measureInitialization");
+    int imreadFlags = parser.get<bool>("colorInput") ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
+    templateParameters.openClNumBufferSets = std::max(pipelineDepth, 1);
+    templateParameters.openClPlatformName = std::string(parser.get<cv::String>("openClPlatform"));
+    templateParameters.openClDeviceName = std::string(parser.get<cv::String>("openClDevice"));
+    templateParameters.openClDeviceType = std::string(parser.get<cv::String>("openClDeviceType"));
+    templateParameters.openClMaxDevices = parser.get<int>("openClMaxDevices");
+    templateParameters.openClDeviceFission = std::string(parser.get<cv::String>("openClDeviceFission"));
+    templateParameters.rectificationMapsPath = std::string(parser.get<cv::String>("rectificationMaps"));
+    std::string groundTruthPath = std::string(parser.get<cv::String>("groundTruth"));
+    std::string groundTruthRightPath = std::string(parser.get<cv::String>("groundTruthRight"));
+    float groundTruthScale = parser.get<float>("groundTruthScale");
+    std::string accuracyThresholds = std::string(parser.get<cv::String>("accuracyThresholds"));
+    std::string accuracyOutputPath = std::string(parser.get<cv::String>("accuracyOutputPath"));
 
     std::cout 
         << "Reading in left image from '" 
@@ -72,7 +168,7 @@ int main(int argc, char** argv) {
         << "'..." 
         << std::endl;
 
-    cv::Mat leftImage = cv::imread(templateParameters.leftImageFilePath, cv::IMREAD_GRAYSCALE);
+    cv::Mat leftImage = cv::imread(templateParameters.leftImageFilePath, imreadFlags);
     
     std::cout 
         << "Reading in right image from '" 
@@ -80,7 +176,7 @@ int main(int argc, char** argv) {
         << "'..." 
         << std::endl;
 
-    cv::Mat rightImage = cv::imread(templateParameters.rightImageFilePath, cv::IMREAD_GRAYSCALE);
+    cv::Mat rightImage = cv::imread(templateParameters.rightImageFilePath, imreadFlags);
 
     if ((leftImage.rows == 0)
             ||
@@ -102,6 +198,31 @@ int main(int argc, char** argv) {
             + std::string("Right iamge: (") + std::to_string(rightImage.rows) + std::string("x") + std::to_string(rightImage.cols) + std::string(")"));
     }
 
+    std::unique_ptr<DisparityAccuracyEvaluator> accuracyEvaluator;
+    if (!groundTruthPath.empty()) {
+        std::cout << "Reading in ground truth from '" << groundTruthPath << "'..." << std::endl;
+        cv::Mat leftGroundTruth = cv::imread(groundTruthPath, cv::IMREAD_UNCHANGED);
+        cv::Mat rightGroundTruth;
+        if (!groundTruthRightPath.empty()) {
+            rightGroundTruth = cv::imread(groundTruthRightPath, cv::IMREAD_UNCHANGED);
+            if (rightGroundTruth.empty()) {
+                throw std::runtime_error("Error. Right ground truth is empty.");
+            }
+        }
+
+        if ((leftGroundTruth.rows != leftImage.rows)
+                ||
+            (leftGroundTruth.cols != leftImage.cols)) {
+            throw std::runtime_error("Error. Ground truth is not the same size as the input images.");
+        }
+
+        accuracyEvaluator.reset(new DisparityAccuracyEvaluator(
+            leftGroundTruth,
+            rightGroundTruth,
+            groundTruthScale,
+            DisparityAccuracyEvaluator::parseThresholds(accuracyThresholds)));
+    }
+
     std::cout << "Running benchmark with the following parameters:" << std::endl;
     std::cout << "\tAlgorithm Names: " << algorithmNamesStr << "." << std::endl;
     std::cout << "\tBlock Size: " << templateParameters.blockSize << "." << std::endl;
@@ -115,6 +236,11 @@ int main(int argc, char** argv) {
     std::cout << "\tNumber of iterations: " << numIterations << std::endl;
     std::cout << "\tNumber of warm-up iterations: " << numWarmUpIterations << std::endl;
     std::cout << "\tProgress Report Interval: " << progressReportInterval << std::endl;
+    std::cout << "\tPipeline Depth: " << pipelineDepth << std::endl;
+    if (accuracyEvaluator != nullptr) {
+        std::cout << "\tGround Truth: " << groundTruthPath << std::endl;
+        std::cout << "\tAccuracy Output Path: " << accuracyOutputPath << std::endl;
+    }
 
     std::stringstream stream(algorithmNamesStr);
     std::vector<std::string> algorithmNames;
@@ -126,6 +252,8 @@ int main(int argc, char** argv) {
 
     std::unordered_map<std::string, std::vector<double>> wallClockProcessingTimes;
     std::unordered_map<std::string, std::vector<double>> cpuProcessingTimes;
+    std::unordered_map<std::string, std::pair<double, double>> initializationTimes;
+    std::unordered_map<std::string, DisparityAccuracy_t> accuracies;
     cv::Mat disparityImage(leftImage.rows, leftImage.cols, CV_32FC1);
     std::chrono::high_resolution_clock clk;
     clock_t t;
@@ -139,15 +267,65 @@ int main(int argc, char** argv) {
         localParameters.algorithmName = algorithmName;
         std::cout << "Creating disparity generator for " << algorithmName << "..." << std::endl;
 
+        if (measureInitialization) {
+            std::cout << "Measuring initialization times..." << std::endl;
+
+            // A fresh cache directory guarantees that the first run is cold.
+            char cacheDirectoryTemplate[] = "/tmp/StereoVisionMultiWayCacheXXXXXX";
+            if (mkdtemp(cacheDirectoryTemplate) == nullptr) {
+                throw std::runtime_error("Error. Could not create a temporary kernel cache directory.");
+            }
+
+            DisparityMapAlgorithmParameters_t initializationParameters(localParameters);
+            initializationParameters.openClBinaryCacheDirectory = std::string(cacheDirectoryTemplate);
+
+            double coldStartMs = measureInitializationTimeMs(
+                initializationParameters, leftImage, rightImage, disparityImage);
+            double warmStartMs = measureInitializationTimeMs(
+                initializationParameters, leftImage, rightImage, disparityImage);
+
+            removeDirectory(initializationParameters.openClBinaryCacheDirectory);
+
+            initializationTimes[algorithmName] = std::make_pair(coldStartMs, warmStartMs);
+            std::cout << "\tCold start: " << coldStartMs << " ms, warm start: " << warmStartMs << " ms." << std::endl;
+        }
+
         DisparityMapGeneratorFactory factory;
         std::unique_ptr<DisparityMapGenerator> generator = factory.create(localParameters);
 
         std::cout << "Initializing disparity generator..." << std::endl;
         generator->setParameters(localParameters);
 
+        PipelinedDisparityMapGenerator* deviceGenerator = dynamic_cast<PipelinedDisparityMapGenerator*>(generator.get());
+        if (deviceGenerator != nullptr) {
+            generator->computeDisparity(leftImage, rightImage, disparityImage);
+            for (const std::string& deviceName : deviceGenerator->getDeviceNames()) {
+                std::cout << "\tUsing device: " << deviceName << std::endl;
+            }
+        }
+
+        // In pipelined mode, each iteration submits one frame and retrieves the oldest one,
+        //   so the recorded times measure throughput rather than latency.
+        PipelinedDisparityMapGenerator* pipelinedGenerator = nullptr;
+        if (pipelineDepth > 1) {
+            pipelinedGenerator = dynamic_cast<PipelinedDisparityMapGenerator*>(generator.get());
+            if (pipelinedGenerator == nullptr) {
+                std::cout << "\t" << algorithmName << " does not support pipelining. Running synchronously." << std::endl;
+            } else {
+                for (int i = 0; i < pipelineDepth - 1; i++) {
+                    pipelinedGenerator->enqueueDisparity(leftImage, rightImage);
+                }
+            }
+        }
+
         std::cout << "Running warm-up iterations..." << std::endl;
         for (int i = 0; i < numWarmUpIterations; i++) {
-            generator->computeDisparity(leftImage, rightImage, disparityImage);
+            if (pipelinedGenerator != nullptr) {
+                pipelinedGenerator->enqueueDisparity(leftImage, rightImage);
+                pipelinedGenerator->dequeueDisparity(disparityImage);
+            } else {
+                generator->computeDisparity(leftImage, rightImage, disparityImage);
+            }
 
             if (((i+1) % progressReportInterval == 0)) {
                 std::cout << "\tProcessed " << (i+1) << " / " << numWarmUpIterations << " warm up iterations (" 
@@ -159,7 +337,12 @@ int main(int argc, char** argv) {
         for (int i = 0; i < numIterations; i++) {
             std::chrono::high_resolution_clock::time_point start = clk.now();
             t = clock();
-            generator->computeDisparity(leftImage, rightImage, disparityImage);
+            if (pipelinedGenerator != nullptr) {
+                pipelinedGenerator->enqueueDisparity(leftImage, rightImage);
+                pipelinedGenerator->dequeueDisparity(disparityImage);
+            } else {
+                generator->computeDisparity(leftImage, rightImage, disparityImage);
+            }
             t = clock() - t;
             std::chrono::high_resolution_clock::time_point end = clk.now();
 
@@ -174,6 +357,23 @@ int main(int argc, char** argv) {
             }
         }
 
+        if (pipelinedGenerator != nullptr) {
+            while (pipelinedGenerator->getNumFramesInFlight() > 0) {
+                pipelinedGenerator->dequeueDisparity(disparityImage);
+            }
+        }
+
+        // Every iteration computes the same frame, so the last one stands for all of them.
+        if (accuracyEvaluator != nullptr) {
+            accuracies[algorithmName] = accuracyEvaluator->evaluate(disparityImage);
+        }
+
+        OpenMpThreadedSimdDisparityMapGenerator* simdGenerator =
+            dynamic_cast<OpenMpThreadedSimdDisparityMapGenerator*>(generator.get());
+        if ((simdGenerator != nullptr) && localParameters.earlyTerminationEnabled) {
+            std::cout << "\tSkipped block rows: " << (simdGenerator->getSkippedBlockRowFraction() * 100.0f) << "%" << std::endl;
+        }
+
         std::cout << "Data for " << algorithmName << " generated." << std::endl;
 
         if (algorithmIdx < algorithmNames.size() - 1) {
@@ -212,6 +412,56 @@ int main(int argc, char** argv) {
     outputStream.flush();
     outputStream.close();
 
+    if (measureInitialization) {
+        std::cout << "Initialization times (construction + first frame):" << std::endl;
+        for (size_t i = 0; i < algorithmNames.size(); i++) {
+            const std::pair<double, double>& times = initializationTimes[algorithmNames[i]];
+            std::cout << "\t" << algorithmNames[i] 
+                << ": cold " << times.first << " ms"
+                << ", warm " << times.second << " ms" << std::endl;
+        }
+    }
+
+    if (accuracyEvaluator != nullptr) {
+        const std::vector<float>& thresholds = accuracyEvaluator->getThresholds();
+
+        std::cout << "Accuracy (bad pixel %, MAE and RMSE in pixels) and throughput:" << std::endl;
+        for (size_t i = 0; i < algorithmNames.size(); i++) {
+            const DisparityAccuracy_t& accuracy = accuracies[algorithmNames[i]];
+            std::cout << "\t" << algorithmNames[i] << ": " << computeFramesPerSecond(wallClockProcessingTimes[algorithmNames[i]]) << " fps" << std::endl;
+            printRegionAccuracy("non-occluded", thresholds, accuracy.nonOccluded);
+            printRegionAccuracy("all", thresholds, accuracy.all);
+        }
+
+        std::cout << "Writing accuracy csv to " << accuracyOutputPath << " ..." << std::endl;
+        std::ofstream accuracyStream(accuracyOutputPath, std::ios::out);
+        accuracyStream << "algorithm,mean_wall_us,fps";
+        for (const char* region : {"nonocc", "all"}) {
+            for (float threshold : thresholds) {
+                accuracyStream << "," << region << "_bad_" << threshold;
+            }
+            accuracyStream << "," << region << "_mae," << region << "_rmse";
+        }
+        accuracyStream << "\n";
+
+        for (size_t i = 0; i < algorithmNames.size(); i++) {
+            const std::vector<double>& wallClockTimes = wallClockProcessingTimes[algorithmNames[i]];
+            const DisparityAccuracy_t& accuracy = accuracies[algorithmNames[i]];
+            accuracyStream << algorithmNames[i]
+                << "," << (1000000.0 / computeFramesPerSecond(wallClockTimes))
+                << "," << computeFramesPerSecond(wallClockTimes);
+            for (const DisparityRegionAccuracy_t* region : {&accuracy.nonOccluded, &accuracy.all}) {
+                for (double percentage : region->badPixelPercentages) {
+                    accuracyStream << "," << percentage;
+                }
+                accuracyStream << "," << region->meanAbsoluteError << "," << region->rootMeanSquaredError;
+            }
+            accuracyStream << "\n";
+        }
+
+        accuracyStream.close();
+    }
+
     std::cout << "Graceful termination" << std::endl;
 
     return 0;
@@ -0,0 +1,131 @@
+#include "../include/StereoRectifier.hpp"
+
+StereoRectifier::StereoRectifier(
+        const cv::Mat& leftMap1,
+        const cv::Mat& leftMap2,
+        const cv::Mat& rightMap1,
+        const cv::Mat& rightMap2)
+        : leftMap1_(leftMap1), leftMap2_(leftMap2), rightMap1_(rightMap1), rightMap2_(rightMap2) {
+    ensureMapsValid(leftMap1, leftMap2);
+    ensureMapsValid(rightMap1, rightMap2);
+
+    if ((leftMap1.rows != rightMap1.rows)
+        ||
+        (leftMap1.cols != rightMap1.cols)) {
+        throw std::runtime_error("Error: the left and right remap tables differ in size.");
+    }
+}
+
+StereoRectifier StereoRectifier::load(const std::string& path) {
+    cv::FileStorage storage(path, cv::FileStorage::READ);
+    if (!storage.isOpened()) {
+        throw std::runtime_error("Error: could not open rectification maps '" + path + "'.");
+    }
+
+    cv::Mat leftMap1;
+    cv::Mat leftMap2;
+    cv::Mat rightMap1;
+    cv::Mat rightMap2;
+    storage["leftMap1"] >> leftMap1;
+    storage["leftMap2"] >> leftMap2;
+    storage["rightMap1"] >> rightMap1;
+    storage["rightMap2"] >> rightMap2;
+
+    return StereoRectifier(leftMap1, leftMap2, rightMap1, rightMap2);
+}
+
+void StereoRectifier::rectifyLeftRows(const cv::Mat& image, int minY, int maxY, uint8_t* destination) const {
+    remapRows(image, this->leftMap1_, this->leftMap2_, minY, maxY, destination);
+}
+
+void StereoRectifier::rectifyRightRows(const cv::Mat& image, int minY, int maxY, uint8_t* destination) const {
+    remapRows(image, this->rightMap1_, this->rightMap2_, minY, maxY, destination);
+}
+
+int StereoRectifier::getWidth() const {
+    return this->leftMap1_.cols;
+}
+
+int StereoRectifier::getHeight() const {
+    return this->leftMap1_.rows;
+}
+
+void StereoRectifier::ensureMapsValid(const cv::Mat& map1, const cv::Mat& map2) {
+    if ((map1.empty())
+        ||
+        (map1.type() != CV_16SC2)
+        ||
+        (map2.type() != CV_16UC1)
+        ||
+        (map1.rows != map2.rows)
+        ||
+        (map1.cols != map2.cols)) {
+        throw std::runtime_error("Error: rectification maps must be a CV_16SC2 map1 and a CV_16UC1 map2 of the same size.");
+    }
+}
+
+int StereoRectifier::samplePixel(const cv::Mat& image, int y, int x) {
+    if ((x < 0) || (y < 0) || (x >= image.cols) || (y >= image.rows)) {
+        return 0;
+    }
+
+    if (image.type() == CV_8UC1) {
+        return image.at<uint8_t>(y, x);
+    }
+
+    const uint8_t* pixel = image.ptr<uint8_t>(y) + (3 * x);
+    return GrayscaleConverter::toGray(pixel[0], pixel[1], pixel[2]);
+}
+
+void StereoRectifier::remapRows(
+        const cv::Mat& image,
+        const cv::Mat& map1,
+        const cv::Mat& map2,
+        int minY,
+        int maxY,
+        uint8_t* destination) {
+    GrayscaleConverter::ensureSupportedType(image);
+
+    int width = map1.cols;
+    int lastX = image.cols - 1;
+    int lastY = image.rows - 1;
+
+    for (int y = minY; y < maxY; y++) {
+        const int16_t* coordinates = map1.ptr<int16_t>(y);
+        const uint16_t* fractions = map2.ptr<uint16_t>(y);
+        uint8_t* output = destination + ((y - minY) * width);
+
+        for (int x = 0; x < width; x++) {
+            int sx = coordinates[2*x];
+            int sy = coordinates[(2*x) + 1];
+            int fx = fractions[x] & INTER_MASK;
+            int fy = (fractions[x] >> INTER_BITS) & INTER_MASK;
+
+            // Weights sum to INTER_TAB_SIZE^2, so the result is rounded back by 2 * INTER_BITS.
+            int w00 = (INTER_TAB_SIZE - fx) * (INTER_TAB_SIZE - fy);
+            int w01 = fx * (INTER_TAB_SIZE - fy);
+            int w10 = (INTER_TAB_SIZE - fx) * fy;
+            int w11 = fx * fy;
+
+            int p00;
+            int p01;
+            int p10;
+            int p11;
+            if ((image.type() == CV_8UC1) && (sx >= 0) && (sy >= 0) && (sx < lastX) && (sy < lastY)) {
+                const uint8_t* source = image.ptr<uint8_t>(sy) + sx;
+                p00 = source[0];
+                p01 = source[1];
+                p10 = source[image.step];
+                p11 = source[image.step + 1];
+            } else {
+                p00 = samplePixel(image, sy, sx);
+                p01 = samplePixel(image, sy, sx + 1);
+                p10 = samplePixel(image, sy + 1, sx);
+                p11 = samplePixel(image, sy + 1, sx + 1);
+            }
+
+            int value = (p00 * w00) + (p01 * w01) + (p10 * w10) + (p11 * w11);
+            output[x] = static_cast<uint8_t>((value + (1 << (2*INTER_BITS - 1))) >> (2*INTER_BITS));
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#include "../include/SubpixelRefiner.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+SubpixelInterpolation SubpixelRefiner::parse(const std::string& name) {
+    std::string lowerName(name);
+    std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+
+    if (lowerName == "none") {
+        return SubpixelInterpolation::None;
+    } else if (lowerName == "parabolic") {
+        return SubpixelInterpolation::Parabolic;
+    } else if (lowerName == "equiangular") {
+        return SubpixelInterpolation::Equiangular;
+    }
+
+    throw std::runtime_error("Error: unrecognized subpixel interpolation '" + name + "'. Valid options are 'none', 'parabolic' and 'equiangular'.");
+}
+
+void SubpixelRefiner::refine(
+        SubpixelInterpolation interpolation,
+        int count,
+        float* disparities,
+        const int* previousCosts,
+        const int* bestCosts,
+        const int* nextCosts) {
+    if (interpolation == SubpixelInterpolation::None) {
+        return;
+    }
+
+    int i = 0;
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        refineSimd(interpolation, disparities + i, previousCosts + i, bestCosts + i, nextCosts + i);
+    }
+
+    // The tail is padded out to a full vector, so that every pixel sees the same approximations.
+    if (i < count) {
+        float tailDisparities[SIMD_WIDTH] = {0};
+        int tailPreviousCosts[SIMD_WIDTH] = {0};
+        int tailBestCosts[SIMD_WIDTH] = {0};
+        int tailNextCosts[SIMD_WIDTH] = {0};
+
+        int tailCount = count - i;
+        std::copy(disparities + i, disparities + count, tailDisparities);
+        std::copy(previousCosts + i, previousCosts + count, tailPreviousCosts);
+        std::copy(bestCosts + i, bestCosts + count, tailBestCosts);
+        std::copy(nextCosts + i, nextCosts + count, tailNextCosts);
+
+        refineSimd(interpolation, tailDisparities, tailPreviousCosts, tailBestCosts, tailNextCosts);
+        std::copy(tailDisparities, tailDisparities + tailCount, disparities + i);
+    }
+}
+
+void SubpixelRefiner::refineSimd(
+        SubpixelInterpolation interpolation,
+        float* disparities,
+        const int* previousCosts,
+        const int* bestCosts,
+        const int* nextCosts) {
+    __m256i c1 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(previousCosts));
+    __m256i c2 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(bestCosts));
+    __m256i c3 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(nextCosts));
+
+    // Parabola: 0.5 * (c3 - c1) / (c1 - 2*c2 + c3).
+    // Equiangular lines: 0.5 * (c3 - c1) / (max(c1, c3) - c2).
+    // c2 is the first strict minimum, so a refinable pixel always has a positive denominator.
+    __m256i numerator = _mm256_sub_epi32(c3, c1);
+    __m256i denominator = (interpolation == SubpixelInterpolation::Parabolic)
+        ? _mm256_sub_epi32(_mm256_add_epi32(c1, c3), _mm256_add_epi32(c2, c2))
+        : _mm256_sub_epi32(_mm256_max_epi32(c1, c3), c2);
+    __m256 refinable = _mm256_castsi256_ps(_mm256_cmpgt_epi32(denominator, _mm256_setzero_si256()));
+
+    // One Newton-Raphson step takes the reciprocal estimate to nearly full single precision.
+    __m256 denominatorFloat = _mm256_cvtepi32_ps(denominator);
+    __m256 reciprocal = _mm256_rcp_ps(denominatorFloat);
+    reciprocal = _mm256_mul_ps(
+        reciprocal,
+        _mm256_sub_ps(_mm256_set1_ps(2.0f), _mm256_mul_ps(denominatorFloat, reciprocal)));
+
+    __m256 offset = _mm256_mul_ps(
+        _mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_cvtepi32_ps(numerator)),
+        reciprocal);
+    offset = _mm256_and_ps(offset, refinable);
+
+    __m256 disparity = _mm256_loadu_ps(disparities);
+    _mm256_storeu_ps(disparities, _mm256_sub_ps(disparity, offset));
+}
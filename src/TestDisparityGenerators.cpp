@@ -0,0 +1,606 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+
+#include "../include/DisparityMapAlgorithmParameters.hpp"
+#include "../include/DisparityMapBackendRegistry.hpp"
+#include "../include/DisparityMapGenerator.hpp"
+#include "../include/DisparityMapGeneratorFactory.hpp"
+#include "../include/OpenMpThreadedSimdDisparityMapGenerator.hpp"
+#include "../include/PipelinedDisparityMapGenerator.hpp"
+#include "../include/SingleThreadedDisparityMapGenerator.hpp"
+
+// Every registered algorithm besides the reference, comma-separated.
+std::string getAllAlgorithmNames() {
+    std::string names;
+    for (const std::string& name : DisparityMapBackendRegistry::getInstance().getNames()) {
+        if (name != "SingleThreaded") {
+            names += (names.empty() ? "" : ",") + name;
+        }
+    }
+
+    return names;
+}
+
+static constexpr int INCREMENTAL_TILE_SIZE = 16;
+
+typedef struct testCase {
+    int rows;
+    int cols;
+    int blockSize;
+    int leftScanSteps;
+    int rightScanSteps;
+
+    // The right image is the left one shifted by this much, plus noise.
+    // Flat images produce ties between disparities, which every backend must break the same way.
+    int shift;
+    int noiseAmplitude;
+    bool flat;
+} testCase_t;
+
+typedef struct comparisonResult {
+    int numMismatches = 0;
+    float maxDifference = 0;
+    std::vector<std::string> mismatchDescriptions;
+} comparisonResult_t;
+
+std::string describeCase(const testCase_t& testCase) {
+    std::stringstream stream;
+    stream << testCase.rows << "x" << testCase.cols
+        << ", block " << testCase.blockSize
+        << ", scan " << testCase.leftScanSteps << "/" << testCase.rightScanSteps
+        << ", shift " << testCase.shift
+        << ", noise " << testCase.noiseAmplitude
+        << (testCase.flat ? ", flat" : "");
+    return stream.str();
+}
+
+// Tiny images whose every pixel is near a border, the largest blocks of the SIMD backends and one beyond,
+//   followed by random sizes, block sizes and scan ranges.
+std::vector<testCase_t> generateTestCases(int numRandomCases, std::mt19937& generator) {
+    std::vector<testCase_t> testCases = {
+        {1, 1, 1, 0, 0, 0, 0, false},
+        {1, 1, 7, 50, 50, 0, 0, false},
+        {1, 9, 3, 4, 4, 1, 5, false},
+        {9, 1, 3, 4, 4, 0, 5, false},
+        {2, 3, 5, 2, 2, 1, 0, false},
+        {5, 5, 7, 10, 10, 2, 3, false},
+        {7, 7, 7, 0, 0, 0, 0, false},
+        {3, 33, 15, 40, 0, 4, 2, false},
+        {3, 33, 15, 0, 40, -4, 2, false},
+        {8, 40, 5, 6, 6, 3, 0, true},
+        {17, 65, 9, 64, 64, 12, 8, false},
+        {40, 96, 31, 24, 24, 5, 6, false},
+        {40, 96, 33, 24, 24, -5, 6, false}
+    };
+
+    std::uniform_int_distribution<int> rowsDistribution(1, 96);
+    std::uniform_int_distribution<int> colsDistribution(1, 160);
+    std::uniform_int_distribution<int> halfBlockDistribution(0, 7);
+    std::uniform_int_distribution<int> scanDistribution(0, 64);
+    std::uniform_int_distribution<int> shiftDistribution(-16, 16);
+    std::uniform_int_distribution<int> noiseDistribution(0, 16);
+    std::uniform_int_distribution<int> flatDistribution(0, 9);
+
+    for (int i = 0; i < numRandomCases; i++) {
+        testCase_t testCase;
+        testCase.rows = rowsDistribution(generator);
+        testCase.cols = colsDistribution(generator);
+        testCase.blockSize = (2 * halfBlockDistribution(generator)) + 1;
+        testCase.leftScanSteps = scanDistribution(generator);
+        testCase.rightScanSteps = scanDistribution(generator);
+        testCase.shift = shiftDistribution(generator);
+        testCase.noiseAmplitude = noiseDistribution(generator);
+        testCase.flat = (flatDistribution(generator) == 0);
+        testCases.emplace_back(testCase);
+    }
+
+    return testCases;
+}
+
+void generateImages(
+        const testCase_t& testCase,
+        std::mt19937& generator,
+        cv::Mat& leftImage,
+        cv::Mat& rightImage) {
+    std::uniform_int_distribution<int> pixelDistribution(0, 255);
+    std::uniform_int_distribution<int> noiseDistribution(-testCase.noiseAmplitude, testCase.noiseAmplitude);
+
+    leftImage = cv::Mat(testCase.rows, testCase.cols, CV_8UC1);
+    rightImage = cv::Mat(testCase.rows, testCase.cols, CV_8UC1);
+
+    for (int y = 0; y < testCase.rows; y++) {
+        for (int x = 0; x < testCase.cols; x++) {
+            leftImage.at<uint8_t>(y, x) = testCase.flat
+                ? static_cast<uint8_t>(((x / 8) + (y / 8)) % 2 == 0 ? 64 : 192)
+                : static_cast<uint8_t>(pixelDistribution(generator));
+        }
+    }
+
+    for (int y = 0; y < testCase.rows; y++) {
+        for (int x = 0; x < testCase.cols; x++) {
+            int sourceX = std::min(std::max(x + testCase.shift, 0), testCase.cols - 1);
+            int value = leftImage.at<uint8_t>(y, sourceX) + noiseDistribution(generator);
+            rightImage.at<uint8_t>(y, x) = static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+        }
+    }
+}
+
+// A copy of an image whose last byte is the last one before an inaccessible page,
+//   so that reading past the end of the image faults instead of going unnoticed.
+class GuardedImage {
+    public:
+        GuardedImage(const cv::Mat& image) {
+            size_t rowSize = image.cols * image.elemSize();
+            size_t imageSize = image.rows * rowSize;
+            size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            size_t imagePagesSize = ((imageSize + pageSize - 1) / pageSize) * pageSize;
+
+            this->mappingSize_ = imagePagesSize + pageSize;
+            void* mapping = mmap(nullptr, this->mappingSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED) {
+                throw std::runtime_error("Error: could not map a guarded image.");
+            }
+            this->mapping_ = static_cast<uint8_t*>(mapping);
+
+            if (mprotect(this->mapping_ + imagePagesSize, pageSize, PROT_NONE) != 0) {
+                munmap(this->mapping_, this->mappingSize_);
+                throw std::runtime_error("Error: could not protect the guard page of an image.");
+            }
+
+            this->image_ = cv::Mat(image.rows, image.cols, image.type(), this->mapping_ + imagePagesSize - imageSize);
+            for (int y = 0; y < image.rows; y++) {
+                memcpy(this->image_.ptr<uint8_t>(y), image.ptr<uint8_t>(y), rowSize);
+            }
+        }
+
+        ~GuardedImage() {
+            munmap(this->mapping_, this->mappingSize_);
+        }
+
+        GuardedImage(const GuardedImage&) = delete;
+        GuardedImage& operator=(const GuardedImage&) = delete;
+
+        const cv::Mat& get() const {
+            return this->image_;
+        }
+
+    private:
+        uint8_t* mapping_ = nullptr;
+        size_t mappingSize_ = 0;
+        cv::Mat image_;
+};
+
+// Inverts a small random rectangle of both images, which changes at most four tiles of INCREMENTAL_TILE_SIZE.
+void changeTiles(
+        std::mt19937& generator,
+        cv::Mat& leftImage,
+        cv::Mat& rightImage) {
+    std::uniform_int_distribution<int> yDistribution(0, leftImage.rows - 1);
+    std::uniform_int_distribution<int> xDistribution(0, leftImage.cols - 1);
+    std::uniform_int_distribution<int> sizeDistribution(1, INCREMENTAL_TILE_SIZE);
+
+    int minY = yDistribution(generator);
+    int minX = xDistribution(generator);
+    int maxY = std::min(minY + sizeDistribution(generator), leftImage.rows);
+    int maxX = std::min(minX + sizeDistribution(generator), leftImage.cols);
+
+    for (int y = minY; y < maxY; y++) {
+        for (int x = minX; x < maxX; x++) {
+            leftImage.at<uint8_t>(y, x) = static_cast<uint8_t>(255 - leftImage.at<uint8_t>(y, x));
+            rightImage.at<uint8_t>(y, x) = static_cast<uint8_t>(255 - rightImage.at<uint8_t>(y, x));
+        }
+    }
+}
+
+comparisonResult_t compareDisparities(
+        const cv::Mat& expected,
+        const cv::Mat& actual,
+        float tolerance,
+        int maxReportedMismatches) {
+    comparisonResult_t result;
+
+    for (int y = 0; y < expected.rows; y++) {
+        for (int x = 0; x < expected.cols; x++) {
+            float expectedValue = expected.at<float>(y, x);
+            float actualValue = actual.at<float>(y, x);
+            float difference = std::abs(expectedValue - actualValue);
+
+            // NaN never compares as within tolerance.
+            if (!(difference <= tolerance)) {
+                result.numMismatches++;
+                if (!std::isnan(difference)) {
+                    result.maxDifference = std::max(result.maxDifference, difference);
+                }
+
+                if (static_cast<int>(result.mismatchDescriptions.size()) < maxReportedMismatches) {
+                    std::stringstream stream;
+                    stream << std::setprecision(9) << "(" << x << ", " << y << "): expected " << expectedValue << ", got " << actualValue;
+                    result.mismatchDescriptions.emplace_back(stream.str());
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+// The number of pixels whose float bits differ.
+int countBitDifferences(const cv::Mat& expected, const cv::Mat& actual) {
+    int numDifferences = 0;
+    for (int y = 0; y < expected.rows; y++) {
+        for (int x = 0; x < expected.cols; x++) {
+            if (memcmp(&expected.at<float>(y, x), &actual.at<float>(y, x), sizeof(float)) != 0) {
+                numDifferences++;
+            }
+        }
+    }
+
+    return numDifferences;
+}
+
+int main(int argc, char** argv) {
+
+    const cv::String commandLineKeys =
+        "{help h usage ?          |        | This program checks every algorithm against SingleThreaded on randomized images.}"
+        "{algorithmNames          |    all | The algorithms to check, comma-separated. all checks every algorithm besides SingleThreaded.}"
+        "{numRandomCases          |    200 | The number of random cases to run after the fixed edge cases.}"
+        "{seed                    |      1 | The seed of the random case generator.}"
+        "{tolerance               | 0.0001 | The largest allowed difference from SingleThreaded. 0 requires an exact match.}"
+        "{maxReportedMismatches   |      5 | The number of mismatching pixels to print per failing case.}"
+        "{skipUnavailable         |   true | Skip algorithms whose instruction sets or devices this host lacks, such as CUDA without a GPU, instead of failing.}"
+        "{earlyTermination        |  false | Check the algorithms with early termination enabled, which must not change the result.}"
+        "{streamRows              |  false | Check OpenMPSimd through its scanline streaming API, pushing one row at a time.}"
+        "{incremental             |  false | Check OpenMPSimd's incremental recomputation on a frame with a few changed tiles, then on the same frame again.}"
+        "{sparse                  |  false | Check the algorithms that support sparse queries through computeDisparityAt(), with regions covering the image and random points, which must match its own dense map bit for bit.}"
+        "{pipelineDepth           |      1 | Above 1, check the pipelined algorithms with this many frames in flight, each of which must match its own reference.}"
+        "{hybridOpenClRowFraction |    0.5 | The initial fraction of rows the Hybrid algorithm sends to OpenCL.}";
+
+    cv::CommandLineParser parser(argc, argv, commandLineKeys);
+
+    if (!parser.check()) {
+        parser.printMessage();
+        parser.printErrors();
+        return 1;
+    }
+
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 1;
+    }
+
+    std::string algorithmNamesStr = std::string(parser.get<cv::String>("algorithmNames"));
+    if (algorithmNamesStr == "all") {
+        algorithmNamesStr = getAllAlgorithmNames();
+    }
+    int numRandomCases = parser.get<int>("numRandomCases");
+    int seed = parser.get<int>("seed");
+    float tolerance = parser.get<float>("tolerance");
+    int maxReportedMismatches = parser.get<int>("maxReportedMismatches");
+    bool skipUnavailable = parser.get<bool>("skipUnavailable");
+    bool earlyTermination = parser.get<bool>("earlyTermination");
+    bool streamRows = parser.get<bool>("streamRows");
+    bool incremental = parser.get<bool>("incremental");
+    bool sparse = parser.get<bool>("sparse");
+    int pipelineDepth = parser.get<int>("pipelineDepth");
+    double hybridOpenClRowFraction = parser.get<double>("hybridOpenClRowFraction");
+
+    std::stringstream stream(algorithmNamesStr);
+    std::vector<std::string> algorithmNames;
+    while (stream.good()) {
+        std::string algorithmName;
+        std::getline(stream, algorithmName, ',');
+        algorithmNames.emplace_back(algorithmName);
+    }
+
+    std::mt19937 generator(seed);
+    std::vector<testCase_t> testCases = generateTestCases(numRandomCases, generator);
+
+    std::cout << "Checking " << algorithmNamesStr << " against SingleThreaded on "
+        << testCases.size() << " cases (seed " << seed << ", tolerance " << tolerance << ")." << std::endl;
+
+    int numFailures = 0;
+    for (const std::string& algorithmName : algorithmNames) {
+        DisparityMapBackendInfo_t info;
+        if (!DisparityMapBackendRegistry::getInstance().find(algorithmName, info)) {
+            std::cout << "\t" << algorithmName << ": not registered." << std::endl;
+            numFailures++;
+            continue;
+        }
+
+        if (sparse && (!info.supportsSparseQueries)) {
+            std::cout << "\t" << algorithmName << ": SKIPPED, sparse queries are not supported." << std::endl;
+            continue;
+        }
+
+        if (skipUnavailable && (!DisparityMapBackendRegistry::isAvailable(info))) {
+            std::cout << "\t" << algorithmName << ": SKIPPED, this host lacks its instruction sets or devices." << std::endl;
+            continue;
+        }
+
+        DisparityMapAlgorithmParameters_t probeParameters;
+        probeParameters.algorithmName = algorithmName;
+        probeParameters.hybridOpenClRowFraction = hybridOpenClRowFraction;
+        std::unique_ptr<DisparityMapGenerator> generatorUnderTest;
+
+        // An available algorithm must run a small ordinary frame.
+        try {
+            DisparityMapGeneratorFactory factory;
+            generatorUnderTest = factory.create(probeParameters);
+
+            cv::Mat probeImage(32, 64, CV_8UC1, cv::Scalar(128));
+            cv::Mat probeDisparity(32, 64, CV_32FC1);
+            generatorUnderTest->computeDisparity(probeImage, probeImage, probeDisparity);
+        } catch (const std::exception& e) {
+            std::cout << "\t" << algorithmName << ": failed to initialize: " << e.what() << std::endl;
+            numFailures++;
+            continue;
+        }
+
+        PipelinedDisparityMapGenerator* pipelinedGenerator =
+            dynamic_cast<PipelinedDisparityMapGenerator*>(generatorUnderTest.get());
+        if ((pipelineDepth > 1) && (pipelinedGenerator == nullptr)) {
+            std::cout << "\t" << algorithmName << ": SKIPPED, frames cannot be pipelined." << std::endl;
+            continue;
+        }
+
+        int numFailedCases = 0;
+
+        // Every algorithm sees the same images.
+        std::mt19937 imageGenerator(seed);
+
+        for (size_t caseIdx = 0; caseIdx < testCases.size(); caseIdx++) {
+            const testCase_t& testCase = testCases[caseIdx];
+
+            DisparityMapAlgorithmParameters_t parameters;
+            parameters.algorithmName = algorithmName;
+            parameters.blockSize = testCase.blockSize;
+            parameters.leftScanSteps = testCase.leftScanSteps;
+            parameters.rightScanSteps = testCase.rightScanSteps;
+            parameters.earlyTerminationEnabled = earlyTermination;
+            parameters.incrementalTileSize = incremental ? INCREMENTAL_TILE_SIZE : 0;
+            parameters.openClNumBufferSets = std::max(pipelineDepth, 1);
+            parameters.hybridOpenClRowFraction = hybridOpenClRowFraction;
+
+            cv::Mat leftImage;
+            cv::Mat rightImage;
+            generateImages(testCase, imageGenerator, leftImage, rightImage);
+
+            // The incremental frames follow the images as generated, and only the changed frame is compared.
+            cv::Mat previousLeftImage = leftImage.clone();
+            cv::Mat previousRightImage = rightImage.clone();
+            if (incremental) {
+                changeTiles(imageGenerator, leftImage, rightImage);
+            }
+
+            // Backends that match in place must not read past the end of the caller's images.
+            GuardedImage guardedLeftImage(leftImage);
+            GuardedImage guardedRightImage(rightImage);
+            leftImage = guardedLeftImage.get();
+            rightImage = guardedRightImage.get();
+
+            cv::Mat expected(testCase.rows, testCase.cols, CV_32FC1);
+            SingleThreadedDisparityMapGenerator reference(parameters);
+            reference.computeDisparity(leftImage, rightImage, expected);
+
+            // The pipelined frames after the first, with their references.
+            std::vector<cv::Mat> leftFrames;
+            std::vector<cv::Mat> rightFrames;
+            std::vector<cv::Mat> expectedFrames;
+            for (int i = 1; i < pipelineDepth; i++) {
+                cv::Mat leftFrame;
+                cv::Mat rightFrame;
+                generateImages(testCase, imageGenerator, leftFrame, rightFrame);
+
+                cv::Mat expectedFrame(testCase.rows, testCase.cols, CV_32FC1);
+                reference.computeDisparity(leftFrame, rightFrame, expectedFrame);
+
+                leftFrames.emplace_back(leftFrame);
+                rightFrames.emplace_back(rightFrame);
+                expectedFrames.emplace_back(expectedFrame);
+            }
+
+            // NaN marks pixels the algorithm never wrote.
+            cv::Mat actual(testCase.rows, testCase.cols, CV_32FC1);
+            actual.setTo(std::numeric_limits<float>::quiet_NaN());
+
+            cv::Mat repeated(testCase.rows, testCase.cols, CV_32FC1);
+            float changedTileFraction = 0;
+            float repeatedTileFraction = 0;
+            int numSparseMismatches = 0;
+            int numPipelinedMismatches = 0;
+
+            // Parameters beyond the registered limits must be rejected rather than computed.
+            std::string unsupportedReason = DisparityMapBackendRegistry::checkSupport(info, parameters, leftImage.type());
+
+            // The generator is reused, so that stale state from a previous size or setting shows up too.
+            try {
+                generatorUnderTest->setParameters(parameters);
+
+                OpenMpThreadedSimdDisparityMapGenerator* simdGenerator =
+                    dynamic_cast<OpenMpThreadedSimdDisparityMapGenerator*>(generatorUnderTest.get());
+                if (incremental && (simdGenerator != nullptr)) {
+                    simdGenerator->computeDisparity(previousLeftImage, previousRightImage, actual);
+                    simdGenerator->computeDisparity(leftImage, rightImage, actual);
+                    changedTileFraction = simdGenerator->getRecomputedTileFraction();
+                    simdGenerator->computeDisparity(leftImage, rightImage, repeated);
+                    repeatedTileFraction = simdGenerator->getRecomputedTileFraction();
+                } else if (pipelineDepth > 1) {
+                    pipelinedGenerator->enqueueDisparity(leftImage, rightImage);
+                    for (size_t i = 0; i < leftFrames.size(); i++) {
+                        pipelinedGenerator->enqueueDisparity(leftFrames[i], rightFrames[i]);
+                    }
+
+                    pipelinedGenerator->dequeueDisparity(actual);
+                    for (size_t i = 0; i < expectedFrames.size(); i++) {
+                        cv::Mat actualFrame(testCase.rows, testCase.cols, CV_32FC1);
+                        actualFrame.setTo(std::numeric_limits<float>::quiet_NaN());
+                        pipelinedGenerator->dequeueDisparity(actualFrame);
+                        numPipelinedMismatches += compareDisparities(expectedFrames[i], actualFrame, tolerance, 0).numMismatches;
+                    }
+                } else if (sparse) {
+                    // The queries must reproduce the generator's own dense map bit for bit.
+                    cv::Mat dense(testCase.rows, testCase.cols, CV_32FC1);
+                    generatorUnderTest->computeDisparity(leftImage, rightImage, dense);
+
+                    // Regions that overlap and extend past the image, together covering every pixel.
+                    int splitX = testCase.cols / 3;
+                    std::vector<cv::Rect> regions = {
+                        cv::Rect(-2, -2, splitX + 3, testCase.rows + 4),
+                        cv::Rect(splitX, 0, testCase.cols, testCase.rows)
+                    };
+                    cv::Mat regionCosts;
+                    generatorUnderTest->computeDisparityAt(leftImage, rightImage, regions, actual, &regionCosts);
+                    numSparseMismatches += countBitDifferences(dense, actual);
+
+                    std::mt19937 pointGenerator(seed + static_cast<int>(caseIdx));
+                    std::uniform_int_distribution<int> yDistribution(0, testCase.rows - 1);
+                    std::uniform_int_distribution<int> xDistribution(0, testCase.cols - 1);
+                    std::vector<cv::Point> points;
+                    for (int i = 0; i < 16; i++) {
+                        points.emplace_back(xDistribution(pointGenerator), yDistribution(pointGenerator));
+                    }
+
+                    std::vector<float> pointDisparities;
+                    std::vector<int> pointCosts;
+                    generatorUnderTest->computeDisparityAt(leftImage, rightImage, points, pointDisparities, &pointCosts);
+
+                    for (size_t i = 0; i < points.size(); i++) {
+                        if ((memcmp(&pointDisparities[i], &dense.at<float>(points[i].y, points[i].x), sizeof(float)) != 0)
+                            ||
+                            (pointCosts[i] != regionCosts.at<int>(points[i].y, points[i].x))) {
+                            numSparseMismatches++;
+                        }
+                    }
+
+                    // With post-processing, queries must match the filtered dense map, or be rejected.
+                    // Auto needs some backend that can filter these parameters.
+                    DisparityMapAlgorithmParameters_t filteredParameters(parameters);
+                    filteredParameters.medianFilterSize = 3;
+                    filteredParameters.speckleMaxSize = 4;
+                    if (info.supportsPostProcessing
+                        &&
+                        DisparityMapBackendRegistry::checkSupport(info, filteredParameters, leftImage.type()).empty()
+                        &&
+                        (!DisparityMapBackendRegistry::getInstance().findSupporting(
+                            filteredParameters, testCase.rows, testCase.cols, leftImage.type()).empty())) {
+                        generatorUnderTest->setParameters(filteredParameters);
+
+                        cv::Mat filteredDense(testCase.rows, testCase.cols, CV_32FC1);
+                        generatorUnderTest->computeDisparity(leftImage, rightImage, filteredDense);
+
+                        cv::Mat filteredActual;
+                        bool rejected = false;
+                        try {
+                            generatorUnderTest->computeDisparityAt(leftImage, rightImage, regions, filteredActual);
+                        } catch (const std::exception&) {
+                            rejected = true;
+                        }
+
+                        if (!rejected) {
+                            numSparseMismatches += countBitDifferences(filteredDense, filteredActual);
+                        }
+
+                        generatorUnderTest->setParameters(parameters);
+                    }
+                } else if (streamRows && (simdGenerator != nullptr)) {
+                    simdGenerator->beginStream(
+                        testCase.cols,
+                        [&actual](int y, const float* disparityRow) {
+                            std::copy(disparityRow, disparityRow + actual.cols, actual.ptr<float>(y));
+                        });
+                    for (int y = 0; y < testCase.rows; y++) {
+                        simdGenerator->pushRows(leftImage.rowRange(y, y + 1), rightImage.rowRange(y, y + 1));
+                    }
+                    simdGenerator->endStream();
+                } else {
+                    generatorUnderTest->computeDisparity(leftImage, rightImage, actual);
+                }
+            } catch (const std::exception& e) {
+                // Frames left in flight would fail every later case.
+                while ((pipelinedGenerator != nullptr) && (pipelinedGenerator->getNumFramesInFlight() > 0)) {
+                    cv::Mat discarded(testCase.rows, testCase.cols, CV_32FC1);
+                    try {
+                        pipelinedGenerator->dequeueDisparity(discarded);
+                    } catch (const std::exception&) {
+                    }
+                }
+
+                if (!unsupportedReason.empty()) {
+                    continue;
+                }
+
+                std::cout << "\t" << algorithmName << " [" << describeCase(testCase) << "]: threw " << e.what() << std::endl;
+                numFailedCases++;
+                continue;
+            }
+
+            if (!unsupportedReason.empty()) {
+                std::cout << "\t" << algorithmName << " [" << describeCase(testCase) << "]: did not throw, although "
+                    << unsupportedReason << std::endl;
+                numFailedCases++;
+                continue;
+            }
+
+            comparisonResult_t result = compareDisparities(expected, actual, tolerance, maxReportedMismatches);
+            if (result.numMismatches > 0) {
+                numFailedCases++;
+                std::cout << "\t" << algorithmName << " [" << describeCase(testCase) << "]: "
+                    << result.numMismatches << " / " << (testCase.rows * testCase.cols)
+                    << " pixels differ, max difference " << result.maxDifference << std::endl;
+                for (const std::string& description : result.mismatchDescriptions) {
+                    std::cout << "\t\t" << description << std::endl;
+                }
+                continue;
+            }
+
+            if (numPipelinedMismatches > 0) {
+                numFailedCases++;
+                std::cout << "\t" << algorithmName << " [" << describeCase(testCase) << "]: "
+                    << numPipelinedMismatches << " pixels of the later pipelined frames differ" << std::endl;
+            }
+
+            if (numSparseMismatches > 0) {
+                numFailedCases++;
+                std::cout << "\t" << algorithmName << " [" << describeCase(testCase) << "]: "
+                    << numSparseMismatches << " queried pixels differ from its own dense map or from the regions' costs" << std::endl;
+            }
+
+            // Some tile changed, and an unchanged frame recomputes nothing yet repeats the disparity.
+            if (incremental) {
+                comparisonResult_t repeatedResult = compareDisparities(actual, repeated, 0, maxReportedMismatches);
+                if ((!(changedTileFraction > 0)) || (changedTileFraction > 1) || (repeatedTileFraction != 0) || (repeatedResult.numMismatches > 0)) {
+                    numFailedCases++;
+                    std::cout << "\t" << algorithmName << " [" << describeCase(testCase) << "]: recomputed "
+                        << changedTileFraction << " of the tiles of the changed frame and "
+                        << repeatedTileFraction << " of the repeated one, whose "
+                        << repeatedResult.numMismatches << " pixels differ" << std::endl;
+                }
+            }
+        }
+
+        std::cout << "\t" << algorithmName << ": " << (testCases.size() - numFailedCases) << " / "
+            << testCases.size() << " cases match." << std::endl;
+
+        numFailures += numFailedCases;
+    }
+
+    std::cout << ((numFailures == 0) ? "PASSED" : "FAILED") << std::endl;
+
+    return (numFailures == 0) ? 0 : 1;
+}
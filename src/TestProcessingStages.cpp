@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "../include/DisparityMapAlgorithmParameters.hpp"
+#include "../include/DisparityPostProcessor.hpp"
+#include "../include/GrayscaleConverter.hpp"
+#include "../include/MatchConfidence.hpp"
+#include "../include/StereoRectifier.hpp"
+
+// Remap tables for an affine warp that reaches past the source image, so that the border is covered too.
+void generateRemapTables(
+        int rows,
+        int cols,
+        std::mt19937& generator,
+        cv::Mat& map1,
+        cv::Mat& map2) {
+    std::uniform_real_distribution<float> scaleDistribution(0.8f, 1.2f);
+    std::uniform_real_distribution<float> shearDistribution(-0.2f, 0.2f);
+    std::uniform_real_distribution<float> offsetDistribution(-10.0f, 10.0f);
+
+    float xScale = scaleDistribution(generator);
+    float xShear = shearDistribution(generator);
+    float xOffset = offsetDistribution(generator);
+    float yScale = scaleDistribution(generator);
+    float yShear = shearDistribution(generator);
+    float yOffset = offsetDistribution(generator);
+
+    cv::Mat mapX(rows, cols, CV_32FC1);
+    cv::Mat mapY(rows, cols, CV_32FC1);
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            mapX.at<float>(y, x) = (xScale * x) + (xShear * y) + xOffset;
+            mapY.at<float>(y, x) = (yShear * x) + (yScale * y) + yOffset;
+        }
+    }
+
+    cv::convertMaps(mapX, mapY, map1, map2, CV_16SC2);
+}
+
+cv::Mat generateImage(int rows, int cols, int type, std::mt19937& generator) {
+    std::uniform_int_distribution<int> pixelDistribution(0, 255);
+
+    cv::Mat image(rows, cols, type);
+    for (int y = 0; y < rows; y++) {
+        uint8_t* row = image.ptr<uint8_t>(y);
+        for (int i = 0; i < cols * image.channels(); i++) {
+            row[i] = static_cast<uint8_t>(pixelDistribution(generator));
+        }
+    }
+
+    return image;
+}
+
+// StereoRectifier against cv::remap(INTER_LINEAR, BORDER_CONSTANT) of the luma, which it documents
+//   matching to within one gray level. Rows are rectified in strips of random height.
+int checkRectifier(int numCases, std::mt19937& generator) {
+    std::uniform_int_distribution<int> rowsDistribution(1, 80);
+    std::uniform_int_distribution<int> colsDistribution(1, 120);
+    std::uniform_int_distribution<int> stripDistribution(1, 16);
+    std::uniform_int_distribution<int> colorDistribution(0, 1);
+
+    int numFailures = 0;
+    for (int caseIdx = 0; caseIdx < numCases; caseIdx++) {
+        int type = (colorDistribution(generator) == 0) ? CV_8UC1 : CV_8UC3;
+        cv::Mat leftImage = generateImage(rowsDistribution(generator), colsDistribution(generator), type, generator);
+        cv::Mat rightImage = generateImage(leftImage.rows, leftImage.cols, type, generator);
+
+        int rectifiedRows = rowsDistribution(generator);
+        int rectifiedCols = colsDistribution(generator);
+        cv::Mat leftMap1;
+        cv::Mat leftMap2;
+        cv::Mat rightMap1;
+        cv::Mat rightMap2;
+        generateRemapTables(rectifiedRows, rectifiedCols, generator, leftMap1, leftMap2);
+        generateRemapTables(rectifiedRows, rectifiedCols, generator, rightMap1, rightMap2);
+
+        StereoRectifier rectifier(leftMap1, leftMap2, rightMap1, rightMap2);
+
+        cv::Mat leftGrayBuffer;
+        cv::Mat rightGrayBuffer;
+        cv::Mat expectedLeft;
+        cv::Mat expectedRight;
+        cv::remap(GrayscaleConverter::ensureGray(leftImage, leftGrayBuffer), expectedLeft, leftMap1, leftMap2, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0));
+        cv::remap(GrayscaleConverter::ensureGray(rightImage, rightGrayBuffer), expectedRight, rightMap1, rightMap2, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0));
+
+        cv::Mat actualLeft(rectifiedRows, rectifiedCols, CV_8UC1);
+        cv::Mat actualRight(rectifiedRows, rectifiedCols, CV_8UC1);
+        for (int minY = 0; minY < rectifiedRows;) {
+            int maxY = std::min(minY + stripDistribution(generator), rectifiedRows);
+            rectifier.rectifyLeftRows(leftImage, minY, maxY, actualLeft.ptr<uint8_t>(minY));
+            rectifier.rectifyRightRows(rightImage, minY, maxY, actualRight.ptr<uint8_t>(minY));
+            minY = maxY;
+        }
+
+        int numMismatches = 0;
+        for (int y = 0; y < rectifiedRows; y++) {
+            for (int x = 0; x < rectifiedCols; x++) {
+                if ((std::abs(actualLeft.at<uint8_t>(y, x) - expectedLeft.at<uint8_t>(y, x)) > 1)
+                    ||
+                    (std::abs(actualRight.at<uint8_t>(y, x) - expectedRight.at<uint8_t>(y, x)) > 1)) {
+                    numMismatches++;
+                }
+            }
+        }
+
+        if (numMismatches > 0) {
+            numFailures++;
+            std::cout << "\tStereoRectifier [" << leftImage.rows << "x" << leftImage.cols << " to "
+                << rectifiedRows << "x" << rectifiedCols << (type == CV_8UC3 ? ", color" : "") << "]: "
+                << numMismatches << " pixels differ from cv::remap by more than 1" << std::endl;
+        }
+    }
+
+    std::cout << "\tStereoRectifier: " << (numCases - numFailures) << " / " << numCases << " cases match." << std::endl;
+    return numFailures;
+}
+
+// Runs every enabled stage of processor over rawDisparity in strips of stripHeight rows,
+//   the way a generator does from its strip loop.
+void postProcessInStrips(
+        DisparityPostProcessor& processor,
+        const cv::Mat& rawDisparity,
+        int stripHeight,
+        cv::Mat& disparity) {
+    processor.beginFrame(rawDisparity.rows, rawDisparity.cols);
+    for (int minY = 0; minY < rawDisparity.rows; minY += stripHeight) {
+        int maxY = std::min(minY + stripHeight, rawDisparity.rows);
+        processor.medianFilterRows(rawDisparity, minY, maxY, disparity);
+        processor.labelSpeckleRows(disparity, minY, maxY);
+    }
+
+    processor.removeSpeckles(disparity, stripHeight);
+}
+
+int countDifferences(const cv::Mat& expected, const cv::Mat& actual) {
+    int numDifferences = 0;
+    for (int y = 0; y < expected.rows; y++) {
+        for (int x = 0; x < expected.cols; x++) {
+            if (expected.at<float>(y, x) != actual.at<float>(y, x)) {
+                numDifferences++;
+            }
+        }
+    }
+
+    return numDifferences;
+}
+
+// The median filter against cv::medianBlur, which must match exactly, both through apply()
+//   and in strips of random height, so that the rows either side of each seam are covered.
+int checkMedianFilter(int numCases, std::mt19937& generator) {
+    std::uniform_int_distribution<int> rowsDistribution(1, 100);
+    std::uniform_int_distribution<int> colsDistribution(1, 120);
+    std::uniform_int_distribution<int> stripDistribution(1, 40);
+    std::uniform_int_distribution<int> sizeDistribution(0, 1);
+    std::uniform_real_distribution<float> disparityDistribution(-16.0f, 64.0f);
+
+    int numFailures = 0;
+    for (int caseIdx = 0; caseIdx < numCases; caseIdx++) {
+        DisparityMapAlgorithmParameters_t parameters;
+        parameters.medianFilterSize = (sizeDistribution(generator) == 0) ? 3 : 5;
+        DisparityPostProcessor processor(parameters);
+
+        cv::Mat rawDisparity(rowsDistribution(generator), colsDistribution(generator), CV_32FC1);
+        for (int y = 0; y < rawDisparity.rows; y++) {
+            for (int x = 0; x < rawDisparity.cols; x++) {
+                rawDisparity.at<float>(y, x) = disparityDistribution(generator);
+            }
+        }
+
+        cv::Mat expected;
+        cv::medianBlur(rawDisparity, expected, parameters.medianFilterSize);
+
+        cv::Mat applied(rawDisparity.rows, rawDisparity.cols, CV_32FC1);
+        processor.apply(rawDisparity, applied);
+
+        int stripHeight = stripDistribution(generator);
+        cv::Mat stripped(rawDisparity.rows, rawDisparity.cols, CV_32FC1);
+        postProcessInStrips(processor, rawDisparity, stripHeight, stripped);
+
+        int numDifferences = countDifferences(expected, applied) + countDifferences(expected, stripped);
+        if (numDifferences > 0) {
+            numFailures++;
+            std::cout << "\tMedian [" << rawDisparity.rows << "x" << rawDisparity.cols << ", size " << parameters.medianFilterSize
+                << ", strips of " << stripHeight << "]: " << numDifferences << " pixels differ from cv::medianBlur" << std::endl;
+        }
+    }
+
+    std::cout << "\tMedian: " << (numCases - numFailures) << " / " << numCases << " cases match." << std::endl;
+    return numFailures;
+}
+
+// The speckle filter against cv::filterSpeckles on integer disparities, which must match exactly.
+// The disparities are patches of random size and value, with single pixels sprinkled in,
+//   and include the replacement value, which is never part of a region.
+int checkSpeckleFilter(int numCases, std::mt19937& generator) {
+    std::uniform_int_distribution<int> rowsDistribution(1, 100);
+    std::uniform_int_distribution<int> colsDistribution(1, 120);
+    std::uniform_int_distribution<int> patchDistribution(1, 8);
+    std::uniform_int_distribution<int> valueDistribution(0, 12);
+    std::uniform_int_distribution<int> sprinkleDistribution(0, 9);
+    std::uniform_int_distribution<int> maxSizeDistribution(1, 40);
+    std::uniform_int_distribution<int> maxDifferenceDistribution(0, 2);
+    std::uniform_int_distribution<int> stripDistribution(1, 40);
+
+    int numFailures = 0;
+    for (int caseIdx = 0; caseIdx < numCases; caseIdx++) {
+        DisparityMapAlgorithmParameters_t parameters;
+        parameters.speckleMaxSize = maxSizeDistribution(generator);
+        parameters.speckleMaxDifference = static_cast<float>(maxDifferenceDistribution(generator));
+        parameters.speckleNewValue = 0.0f;
+        DisparityPostProcessor processor(parameters);
+
+        int rows = rowsDistribution(generator);
+        int cols = colsDistribution(generator);
+        int patchRows = patchDistribution(generator);
+        int patchCols = patchDistribution(generator);
+        std::vector<int> patchValues(((rows / patchRows) + 1) * ((cols / patchCols) + 1));
+        for (int& value : patchValues) {
+            value = valueDistribution(generator);
+        }
+
+        cv::Mat integerDisparity(rows, cols, CV_16SC1);
+        cv::Mat rawDisparity(rows, cols, CV_32FC1);
+        for (int y = 0; y < rows; y++) {
+            for (int x = 0; x < cols; x++) {
+                int value = (sprinkleDistribution(generator) == 0)
+                    ? valueDistribution(generator)
+                    : patchValues[((y / patchRows) * ((cols / patchCols) + 1)) + (x / patchCols)];
+                integerDisparity.at<int16_t>(y, x) = static_cast<int16_t>(value);
+                rawDisparity.at<float>(y, x) = static_cast<float>(value);
+            }
+        }
+
+        cv::filterSpeckles(integerDisparity, parameters.speckleNewValue, parameters.speckleMaxSize, parameters.speckleMaxDifference);
+
+        cv::Mat expected(rows, cols, CV_32FC1);
+        for (int y = 0; y < rows; y++) {
+            for (int x = 0; x < cols; x++) {
+                expected.at<float>(y, x) = static_cast<float>(integerDisparity.at<int16_t>(y, x));
+            }
+        }
+
+        cv::Mat applied(rows, cols, CV_32FC1);
+        processor.apply(rawDisparity, applied);
+
+        int stripHeight = stripDistribution(generator);
+        cv::Mat stripped(rows, cols, CV_32FC1);
+        postProcessInStrips(processor, rawDisparity, stripHeight, stripped);
+
+        int numDifferences = countDifferences(expected, applied) + countDifferences(expected, stripped);
+        if (numDifferences > 0) {
+            numFailures++;
+            std::cout << "\tSpeckles [" << rows << "x" << cols << ", max size " << parameters.speckleMaxSize
+                << ", max difference " << parameters.speckleMaxDifference << ", strips of " << stripHeight << "]: "
+                << numDifferences << " pixels differ from cv::filterSpeckles" << std::endl;
+        }
+    }
+
+    std::cout << "\tSpeckles: " << (numCases - numFailures) << " / " << numCases << " cases match." << std::endl;
+    return numFailures;
+}
+
+// The peak ratio tracker on fixed cost curves, which must give exactly the expected confidence.
+// Each curve is searched in order, in reverse and from its middle, and candidates that cost more than
+//   both the best so far and the tracker's bound are skipped, as early termination does.
+// Flat curves, wide ties and single candidates must give 0, and single valleys a high confidence.
+int checkPeakRatio() {
+    struct PeakRatioCase_t {
+        std::string name;
+        std::vector<int> costs;
+        float expected;
+    };
+
+    std::vector<PeakRatioCase_t> cases = {
+        { "single candidate", { 10 }, 0.0f },
+        { "two candidates", { 20, 10 }, 0.5f },
+        { "three candidates", { 40, 10, 20 }, 0.5f },
+        { "flat", { 20, 20, 20, 20, 20 }, 0.0f },
+        { "ramp up", { 10, 20, 40, 60, 80 }, 0.75f },
+        { "ramp down", { 80, 60, 40, 20, 10 }, 0.75f },
+        { "plateau minimum", { 50, 10, 10, 10, 50 }, 0.0f },
+        { "two equal minima", { 10, 30, 10, 30, 50 }, 0.0f },
+        { "adjacent equal minima", { 80, 10, 10, 80, 80 }, 0.875f },
+        { "single valley", { 80, 20, 10, 20, 80 }, 0.875f },
+        { "two valleys", { 40, 10, 30, 20, 50 }, 0.5f },
+        { "edge and plateau", { 10, 50, 40, 40, 50 }, 0.75f },
+        { "zero cost", { 0, 50, 40 }, 1.0f }
+    };
+
+    int numFailures = 0;
+    for (const PeakRatioCase_t& peakRatioCase : cases) {
+        int numCosts = static_cast<int>(peakRatioCase.costs.size());
+        for (int order = 0; order < 3; order++) {
+            PeakRatioTracker tracker;
+            int bestIndex = -1;
+            int bestCost = std::numeric_limits<int>::max();
+            for (int n = 0; n < numCosts; n++) {
+                int i = (order == 0) ? n : ((order == 1) ? numCosts - 1 - n : (n + (numCosts / 2)) % numCosts);
+                int cost = peakRatioCase.costs[i];
+                if ((cost > bestCost) && (cost > tracker.getBound())) {
+                    continue;
+                }
+
+                tracker.add(i, cost);
+                if ((cost < bestCost) || ((cost == bestCost) && (i < bestIndex))) {
+                    bestCost = cost;
+                    bestIndex = i;
+                }
+            }
+
+            float actual = tracker.getPeakRatio(bestIndex, bestCost);
+            if (actual != peakRatioCase.expected) {
+                numFailures++;
+                std::cout << "\tPeak ratio [" << peakRatioCase.name << ", order " << order << "]: expected "
+                    << peakRatioCase.expected << ", got " << actual << std::endl;
+            }
+        }
+    }
+
+    int numChecks = static_cast<int>(cases.size()) * 3;
+    std::cout << "\tPeak ratio: " << (numChecks - numFailures) << " / " << numChecks << " searches match." << std::endl;
+    return numFailures;
+}
+
+int main(int argc, char** argv) {
+
+    const cv::String commandLineKeys =
+        "{help h usage ? |     | This program checks the processing stages around matching against their OpenCV equivalents.}"
+        "{numRandomCases | 100 | The number of random cases per stage.}"
+        "{seed           |   1 | The seed of the random case generator.}";
+
+    cv::CommandLineParser parser(argc, argv, commandLineKeys);
+
+    if (!parser.check()) {
+        parser.printMessage();
+        parser.printErrors();
+        return 1;
+    }
+
+    if (parser.has("help")) {
+        parser.printMessage();
+        return 1;
+    }
+
+    int numRandomCases = parser.get<int>("numRandomCases");
+    int seed = parser.get<int>("seed");
+
+    std::cout << "Checking the processing stages on " << numRandomCases << " cases each (seed " << seed << ")." << std::endl;
+
+    std::mt19937 generator(seed);
+
+    int numFailures = 0;
+    try {
+        numFailures += checkRectifier(numRandomCases, generator);
+        numFailures += checkMedianFilter(numRandomCases, generator);
+        numFailures += checkSpeckleFilter(numRandomCases, generator);
+        numFailures += checkPeakRatio();
+    } catch (const std::exception& e) {
+        std::cout << "\tthrew " << e.what() << std::endl;
+        numFailures++;
+    }
+
+    std::cout << ((numFailures == 0) ? "PASSED" : "FAILED") << std::endl;
+
+    return (numFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include "../include/TileChangeDetector.hpp"
+
+#include <cstring>
+
+TileChangeDetector::TileChangeDetector(int tileSize, int changeThreshold)
+        : tileSize_(tileSize), changeThreshold_(changeThreshold) {
+    if (this->tileSize_ <= 0) {
+        throw std::runtime_error("Error: tile size must be positive.");
+    }
+
+    if (this->changeThreshold_ < 0) {
+        throw std::runtime_error("Error: change threshold is negative.");
+    }
+}
+
+void TileChangeDetector::reset() {
+    this->referenceImage_ = cv::Mat();
+    this->numTileRows_ = 0;
+    this->numTileCols_ = 0;
+}
+
+void TileChangeDetector::update(
+        const cv::Mat& image,
+        std::vector<uint8_t>& changedTiles) {
+    int numTileRows = (image.rows + this->tileSize_ - 1) / this->tileSize_;
+    int numTileCols = (image.cols + this->tileSize_ - 1) / this->tileSize_;
+
+    if ((this->referenceImage_.rows != image.rows)
+        ||
+        (this->referenceImage_.cols != image.cols)) {
+        this->numTileRows_ = numTileRows;
+        this->numTileCols_ = numTileCols;
+        image.copyTo(this->referenceImage_);
+        changedTiles.assign(numTileRows * numTileCols, 1);
+        return;
+    }
+
+    changedTiles.resize(numTileRows * numTileCols);
+
+    #pragma omp parallel for collapse(2) default(none) shared(image, changedTiles, numTileRows, numTileCols)
+    for (int ty = 0; ty < numTileRows; ty++) {
+        for (int tx = 0; tx < numTileCols; tx++) {
+            int minY = ty * this->tileSize_;
+            int minX = tx * this->tileSize_;
+            int height = std::min(this->tileSize_, image.rows - minY);
+            int width = std::min(this->tileSize_, image.cols - minX);
+
+            int sad = this->computeTileSadSimd(minY, minX, width, height, image);
+            bool changed = (sad > this->changeThreshold_);
+            if (changed) {
+                this->copyTile(minY, minX, width, height, image);
+            }
+
+            changedTiles[(ty * numTileCols) + tx] = changed ? 1 : 0;
+        }
+    }
+}
+
+int TileChangeDetector::getNumTileRows() const {
+    return this->numTileRows_;
+}
+
+int TileChangeDetector::getNumTileCols() const {
+    return this->numTileCols_;
+}
+
+int TileChangeDetector::computeTileSadSimd(
+        int minY,
+        int minX,
+        int width,
+        int height,
+        const cv::Mat& image) {
+    union { __m256i accumulator; uint64_t accumulatorValues[4]; };
+    accumulator = _mm256_setzero_si256();
+
+    constexpr int numBytesPerSimd = 32;
+    int numSimdIter = width / numBytesPerSimd;
+
+    int result = 0;
+    for (int y = minY; y < minY + height; y++) {
+        const uint8_t* a = image.ptr<uint8_t>(y) + minX;
+        const uint8_t* b = this->referenceImage_.ptr<uint8_t>(y) + minX;
+
+        for (int i = 0; i < numSimdIter; i++) {
+            __m256i workRegA = _mm256_loadu_si256(
+                reinterpret_cast<__m256i const*>(a + (i * numBytesPerSimd)));
+            __m256i workRegB = _mm256_loadu_si256(
+                reinterpret_cast<__m256i const*>(b + (i * numBytesPerSimd)));
+            accumulator = _mm256_add_epi64(_mm256_sad_epu8(workRegA, workRegB), accumulator);
+        }
+
+        for (int x = numSimdIter * numBytesPerSimd; x < width; x++) {
+            result += std::abs(a[x] - b[x]);
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        result += static_cast<int>(accumulatorValues[i]);
+    }
+
+    return result;
+}
+
+void TileChangeDetector::copyTile(
+        int minY,
+        int minX,
+        int width,
+        int height,
+        const cv::Mat& image) {
+    for (int y = minY; y < minY + height; y++) {
+        memcpy(
+            this->referenceImage_.ptr<uint8_t>(y) + minX,
+            image.ptr<uint8_t>(y) + minX,
+            width);
+    }
+}